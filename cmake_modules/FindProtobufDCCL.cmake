@@ -76,6 +76,7 @@ function(PROTOBUF_GENERATE_CPP_INTERNAL USE_DCCL SRCS HDRS)
 
   set(${SRCS})
   set(${HDRS})
+  set(DCCL_PROTOC_DEPENDS)
   foreach(FIL ${ARGN})
     # /home/toby/dccl/src/core/proto/foo.proto
     get_filename_component(ABS_FIL ${FIL} ABSOLUTE)
@@ -99,7 +100,14 @@ function(PROTOBUF_GENERATE_CPP_INTERNAL USE_DCCL SRCS HDRS)
     list(APPEND ${HDRS} "${FIL_PATH}/${FIL_WE}.pb.h")
 
     if(USE_DCCL)
-      set(DCCL_PROTOC_ARGS --dccl_out ${dccl_INC_DIR} --plugin ${dccl_EXEC_DIR}/protoc-gen-dccl)
+      # e.g. set(DCCL_PROTOC_PLUGIN_PARAMETER "generate_codecs,generate_structs") before calling PROTOBUF_GENERATE_CPP
+      if(DCCL_PROTOC_PLUGIN_PARAMETER)
+        set(DCCL_PROTOC_ARGS --dccl_out ${DCCL_PROTOC_PLUGIN_PARAMETER}:${dccl_INC_DIR} --plugin ${dccl_EXEC_DIR}/protoc-gen-dccl)
+      else()
+        set(DCCL_PROTOC_ARGS --dccl_out ${dccl_INC_DIR} --plugin ${dccl_EXEC_DIR}/protoc-gen-dccl)
+      endif()
+      # regenerate when the plugin changes, since it writes code into the .pb.cc / .pb.h
+      set(DCCL_PROTOC_DEPENDS ${dccl_EXEC_DIR}/protoc-gen-dccl)
     endif()
 
     add_custom_command(
@@ -110,7 +118,7 @@ function(PROTOBUF_GENERATE_CPP_INTERNAL USE_DCCL SRCS HDRS)
       # add guards for Clang static analyzer (scan-build)
       COMMAND /bin/bash
       ARGS -c "FILE=${FIL_PATH}/${FIL_WE}.pb.cc && TMPFILE=\${FILE}.\${RANDOM} && cat <(echo '#ifndef __clang_analyzer__') \${FILE} <(echo -e '\\n#endif // __clang_analyzer__') > \${TMPFILE} && mv \${TMPFILE} \${FILE}"
-      DEPENDS ${ABS_FIL}
+      DEPENDS ${ABS_FIL} ${DCCL_PROTOC_DEPENDS}
       COMMENT "Running C++ protocol buffer compiler on ${FIL}"
       VERBATIM )
 
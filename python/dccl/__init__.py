@@ -11,3 +11,32 @@ __version__ = pkg_resources.get_distribution('dccl').version
 
 from ._dccl import *
 
+
+def decode_columns(codec, encoded, type_name=None):
+    """Decode DCCL messages of one type directly into NumPy arrays, without creating protobuf messages.
+
+    encoded is a list of encoded messages, or one bytes object of consecutive encoded messages, as for
+    Codec.decode_many(). type_name (the full name of the message type) is only needed if there may be no
+    messages; otherwise it is the type of the first message.
+
+    Returns a dict with a column for each field (other than repeated embedded messages), named by the path
+    to the field (e.g. "pos.x"). Columns have one row per message, and repeated fields have max_repeat
+    columns. Fields that may be missing (optional and repeated fields, and those in optional embedded
+    messages) are NumPy masked arrays. Strings and bytes are object arrays.
+    """
+    import numpy
+
+    count, columns = codec._decode_columns(encoded, type_name)
+    result = {}
+    for name, dtype, data, mask, width in columns:
+        shape = (count, width) if width else (count,)
+        if dtype == "O":
+            values = numpy.empty(len(data), dtype=object)
+            values[:] = data
+            values = values.reshape(shape)
+        else:
+            values = numpy.frombuffer(data, dtype=dtype).reshape(shape)
+        if mask is not None:
+            values = numpy.ma.masked_array(values, mask=numpy.frombuffer(mask, dtype=bool).reshape(shape))
+        result[name] = values
+    return result
@@ -1,3 +1,4 @@
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include "structmember.h"
 #include "bytesobject.h"
@@ -5,6 +6,13 @@
 #include <google/protobuf/message.h>
 
 #include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+
+#include <pthread.h>
+
+#include <boost/lexical_cast.hpp>
 
 #if PY_MAJOR_VERSION >= 3
 #define PyString_AS_STRING PyUnicode_AsUTF8
@@ -19,10 +27,66 @@ typedef struct {
     PyObject_HEAD
     dccl::Codec *codec;
     PyObject *codec_capsule;
+    // a dccl::Codec may only be used by one thread at a time
+    pthread_mutex_t mutex;
 } Codec;
 
-static int py_pbmsg_to_cpp_pbmsg(PyObject *pyMsg, gp::Message **cppMsg) {
-    // Get typename from the descriptor -- pyMsg.DESCRIPTOR.full_name -- and put in a string.
+// Held for reading while a Codec is in use (NativeCall), and for writing by calls that change the
+// state shared by all Codecs (GlobalStateCall): the FieldCodecManager (changed by loading libraries
+// and by constructing and destroying Codecs) and the DynamicProtobufManager (changed by loading .proto
+// files). The per-Codec mutex alone doesn't keep those from changing under another Codec.
+static pthread_rwlock_t global_state_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Releases the GIL (so other Python threads can run) and locks the Codec (if given) for the lifetime
+// of this object. Without a Codec it just keeps the global state from changing, e.g. while looking up
+// a type in the DynamicProtobufManager. Only C++ may be used while one exists: declare it inside the
+// try block, so the GIL is taken back before any exception is converted to a Python one.
+class NativeCall {
+  public:
+    NativeCall(Codec *self = NULL) : self_(self), state_(PyEval_SaveThread()) {
+        pthread_rwlock_rdlock(&global_state_lock);
+        if (self_) { pthread_mutex_lock(&self_->mutex); }
+    }
+    ~NativeCall() {
+        if (self_) { pthread_mutex_unlock(&self_->mutex); }
+        pthread_rwlock_unlock(&global_state_lock);
+        PyEval_RestoreThread(state_);
+    }
+  private:
+    Codec *self_;
+    PyThreadState *state_;
+};
+
+// As NativeCall, but waits until no Codec is in use, for calls that change global state.
+// The Codec (if given) is locked as well.
+class GlobalStateCall {
+  public:
+    GlobalStateCall(Codec *self = NULL) : self_(self), state_(PyEval_SaveThread()) {
+        pthread_rwlock_wrlock(&global_state_lock);
+        if (self_) { pthread_mutex_lock(&self_->mutex); }
+    }
+    ~GlobalStateCall() {
+        if (self_) { pthread_mutex_unlock(&self_->mutex); }
+        pthread_rwlock_unlock(&global_state_lock);
+        PyEval_RestoreThread(state_);
+    }
+  private:
+    Codec *self_;
+    PyThreadState *state_;
+};
+
+// The type of the encoded message starting at begin
+template<typename CharIterator>
+static const gp::Descriptor *loaded_descriptor(dccl::Codec *codec, CharIterator begin, CharIterator end) {
+    unsigned id = codec->id(begin, end);
+    std::map<dccl::int32, const gp::Descriptor*>::const_iterator it = codec->loaded().find(id);
+    if (it == codec->loaded().end())
+        throw(dccl::Exception("Message id " + boost::lexical_cast<std::string>(id) + " has not been loaded. Call load() before decoding this type."));
+    return it->second;
+}
+
+// Get the full name of a Python protobuf message type -- pyMsg.DESCRIPTOR.full_name
+static int py_pbmsg_full_name(PyObject *pyMsg, std::string *full_name) {
     PyObject *descriptor = PyObject_GetAttrString(pyMsg, "DESCRIPTOR");
     if (!descriptor) {
         PyErr_SetString(PyExc_TypeError, "Message had no DESCRIPTOR attribute.");
@@ -37,73 +101,166 @@ static int py_pbmsg_to_cpp_pbmsg(PyObject *pyMsg, gp::Message **cppMsg) {
 
     const char *ch_full_name = PyString_AS_STRING(py_full_name);
     if (!ch_full_name) {
+        Py_DECREF(py_full_name);
         PyErr_SetString(PyExc_TypeError, "Message full_name was not a string.");
         return 0;
     }
 
-    std::string full_name(ch_full_name); 
+    *full_name = ch_full_name;
     Py_DECREF(py_full_name);
-    if (full_name.empty()) {
+    if (full_name->empty()) {
         PyErr_SetString(PyExc_TypeError, "Message full_name was not a string.");
         return 0;
     }
+    return 1;
+}
+
+// Serialize a Python protobuf message, returning a new reference to the bytes
+static PyObject *py_pbmsg_serialize(PyObject *pyMsg) {
+    PyObject *result = PyObject_CallMethod(pyMsg, "SerializeToString", NULL);
+    if (!result || !PyBytes_Check(result)) {
+        Py_XDECREF(result);
+        PyErr_SetString(PyExc_RuntimeError, "Failed to Serialize python protobuf message.");
+        return NULL;
+    }
+    return result;
+}
+
+static int py_pbmsg_to_cpp_pbmsg(PyObject *pyMsg, gp::Message **cppMsg) {
+    std::string full_name;
+    if (!py_pbmsg_full_name(pyMsg, &full_name))
+        return 0;
 
-    // Now try to construct a C++ message with that name
-    gp::Message *msg;
+    // Serialize the python data (which needs the GIL) ...
+    PyObject *result = py_pbmsg_serialize(pyMsg);
+    if (!result)
+        return 0;
+
+    // ... then construct a C++ message with that name and populate it, with the proto files locked
+    gp::Message *msg = NULL;
     try {
+        NativeCall call;
         msg = dccl::DynamicProtobufManager::new_protobuf_message<gp::Message*>(full_name);
+        msg->ParseFromArray(PyBytes_AS_STRING(result), PyBytes_GET_SIZE(result));
     } catch (std::runtime_error &e) {
         // new_protobuf_message() throws a runtime_error instead of dccl::Exception
+        Py_DECREF(result);
         PyErr_SetString(DcclException, "Could not convert to a known DCCL protobuf type.");
         return 0;
     } catch (...) {
-        PyErr_SetString(DcclException, "Unexpected exception");
-        return 0;
-    }
-    
-    // Now that we have the C++ type, serialize the python data, and populate the C++ object.
-    PyObject *result = PyObject_CallMethod(pyMsg, "SerializeToString", NULL);
-    if (!result || !PyBytes_Check(result)) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to Serialize python protobuf message.");
+        Py_DECREF(result);
         delete msg;
+        PyErr_SetString(DcclException, "Unexpected exception");
         return 0;
     }
-    msg->ParseFromArray(PyBytes_AsString(result), PyBytes_Size(result));
+    Py_DECREF(result);
 
     // If we made it here we were successful, and can set the pointer.
     *cppMsg = msg;
     return 1;
 }
 
+// Create a Python protobuf message of the class cls from its serialized form
+static PyObject* py_pbmsg_from_serialized(PyObject *cls, const char *serialized, Py_ssize_t size) {
+    PyObject *msg = PyObject_CallObject(cls, NULL);
+    if (!msg) return NULL;
+    
+#if PY_MAJOR_VERSION >= 3
+    PyObject *result = PyObject_CallMethod(msg, "ParseFromString", "y#", serialized, size);
+#else
+    PyObject *result = PyObject_CallMethod(msg, "ParseFromString", "s#", serialized, size);
+#endif
+    if (!result) {
+        Py_DECREF(msg);
+        return NULL;
+    }
+    Py_DECREF(result);
+    return msg;
+}
+
 static PyObject* cpp_pbmsg_to_py_pbmsg(gp::Message *cppMsg) {
     // Create a Protobuf Message by looking up the Python prototype, and calling it to get a message
     PyObject *cls = PyObject_CallMethod(GPBSymbolDB, "GetSymbol", "s",
                                         cppMsg->GetTypeName().c_str());
     if (!cls) return NULL;
-    PyObject *msg = PyObject_CallObject(cls, NULL);
-    Py_DECREF(cls);
-    if (!msg) return NULL;
     
     // Populate the python object from the C++ message
     std::string encoded;
     cppMsg->SerializeToString(&encoded);
-#if PY_MAJOR_VERSION >= 3
-    PyObject_CallMethod(msg, "ParseFromString", "y#", encoded.c_str(), encoded.size());
-#else
-    PyObject_CallMethod(msg, "ParseFromString", "s#", encoded.c_str(), encoded.size());
-#endif
-
+    PyObject *msg = py_pbmsg_from_serialized(cls, encoded.data(), encoded.size());
+    Py_DECREF(cls);
     return msg;
 }
 
+// A contiguous view of (part of) an object supporting the buffer protocol (bytes, bytearray, memoryview,
+// mmap, NumPy arrays, ...), which also stops the object being resized or closed until it is released.
+class BufferView {
+  public:
+    BufferView() : acquired_(false), begin_(NULL), end_(NULL) { }
+    ~BufferView() {
+        if (acquired_)
+            PyBuffer_Release(&view_);
+    }
+
+    // View length bytes of obj starting at offset (length < 0 for the rest of the buffer)
+    int acquire(PyObject *obj, Py_ssize_t offset = 0, Py_ssize_t length = -1, bool writable = false) {
+        if (PyObject_GetBuffer(obj, &view_, writable ? PyBUF_WRITABLE : PyBUF_SIMPLE) < 0)
+            return 0;
+        acquired_ = true;
+        if (offset < 0 || offset > view_.len) {
+            PyErr_SetString(PyExc_ValueError, "offset is outside the buffer.");
+            return 0;
+        }
+        if (length < 0) {
+            length = view_.len - offset;
+        } else if (length > view_.len - offset) {
+            PyErr_SetString(PyExc_ValueError, "offset + length is past the end of the buffer.");
+            return 0;
+        }
+        begin_ = static_cast<char*>(view_.buf) + offset;
+        end_ = begin_ + length;
+        return 1;
+    }
+
+    char *begin() const { return begin_; }
+    char *end() const { return end_; }
+    Py_ssize_t size() const { return end_ - begin_; }
+
+  private:
+    BufferView(const BufferView&);
+    BufferView& operator=(const BufferView&);
+
+    Py_buffer view_;
+    bool acquired_;
+    char *begin_;
+    char *end_;
+};
+
+// Owns new references to Python objects, releasing them when it goes out of scope (with the GIL held)
+class PyObjectRefs : public std::vector<PyObject*> {
+  public:
+    ~PyObjectRefs() {
+        for (iterator it = begin(), n = end(); it != n; ++it)
+            Py_XDECREF(*it);
+    }
+};
+
 // new, dealloc, initializers...
 static PyObject *Codec_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
-    return type->tp_alloc(type, 0);
+    PyObject *self = type->tp_alloc(type, 0);
+    if (self)
+        pthread_mutex_init(&((Codec*)self)->mutex, NULL);
+    return self;
 }
 
 static void Codec_dealloc(Codec* self) {
     Py_XDECREF(self->codec_capsule);
-    if (self->codec) { delete self->codec; }
+    if (self->codec) {
+        // unloads the libraries it loaded from the FieldCodecManager
+        GlobalStateCall call;
+        delete self->codec;
+    }
+    pthread_mutex_destroy(&self->mutex);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -118,7 +275,11 @@ static int Codec_init(Codec *self, PyObject *args, PyObject *kwds) {
     std::string library_path_str = library_path ? library_path : "";
 
     try {
-        self->codec = new dccl::Codec(id_codec_str, library_path_str);
+        {
+            // adds to the FieldCodecManager
+            GlobalStateCall call;
+            self->codec = new dccl::Codec(id_codec_str, library_path_str);
+        }
         self->codec_capsule = PyCapsule_New(self->codec, "_dccl.Codec._CODEC", NULL);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -132,15 +293,20 @@ static int Codec_init(Codec *self, PyObject *args, PyObject *kwds) {
 }
 
 // Get the ID for an encoded message
-static PyObject *Codec_id(Codec *self, PyObject *args) {
-    const char *bytes;
-    int bytes_len;
+static PyObject *Codec_id(Codec *self, PyObject *args, PyObject *kwds) {
+    PyObject *input = NULL;
+    Py_ssize_t offset = 0, length = -1;
     unsigned id;
+    static char *kwlist[] = {"bytes", "offset", "length", NULL};
 
-    if (!PyArg_ParseTuple(args, "s#", &bytes, &bytes_len))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|nn", kwlist, &input, &offset, &length))
+        return NULL;
+    BufferView bytes;
+    if (!bytes.acquire(input, offset, length))
         return NULL;
     try {
-        id = self->codec->id(std::string(bytes, bytes_len));
+        NativeCall call(self);
+        id = self->codec->id(bytes.begin(), bytes.end());
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
         return NULL;
@@ -163,6 +329,7 @@ static PyObject *Codec_encode(Codec *self, PyObject *args) {
     
     // Do the DCCL Encoding, and return the value as a string.
     try {
+        NativeCall call(self);
         self->codec->encode(&bytes, *msg, header_only != 0);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -192,6 +359,7 @@ static PyObject *Codec_size(Codec *self, PyObject *args) {
     
     // Do the DCCL Encoding, and return the value as a string.
     try {
+        NativeCall call(self);
         size = self->codec->size(*msg);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -206,29 +374,481 @@ static PyObject *Codec_size(Codec *self, PyObject *args) {
     return Py_BuildValue("I", size);
 }
 
-static PyObject *Codec_decode(Codec *self, PyObject *args) {
-    const char *bytes;
-    int size = 0;
+static PyObject *Codec_encode_into(Codec *self, PyObject *args, PyObject *kwds) {
+    gp::Message *msg = NULL;
+    PyObject *output = NULL;
+    Py_ssize_t offset = 0;
+    int header_only = 0;
+    size_t size = 0;
+    static char *kwlist[] = {"message", "buffer", "offset", "header_only", NULL};
+
+    // Parse and convert the input into a gp::Message
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O|ni", kwlist, &py_pbmsg_to_cpp_pbmsg, &msg,
+                                     &output, &offset, &header_only))
+        return NULL;
+
+    BufferView bytes;
+    if (!bytes.acquire(output, offset, -1, true)) {
+        delete msg;
+        return NULL;
+    }
+
+    // Do the DCCL Encoding directly into the buffer
+    try {
+        NativeCall call(self);
+        size = self->codec->encode(bytes.begin(), bytes.size(), *msg, header_only != 0);
+    } catch (dccl::Exception &e) {
+        PyErr_SetString(DcclException, e.what());
+        delete msg;
+        return NULL;
+    } catch (std::length_error &e) {
+        PyErr_SetString(DcclException, "buffer is too small for the encoded message");
+        delete msg;
+        return NULL;
+    } catch (...) {
+        PyErr_SetString(DcclException, "unexpected exception");
+        delete msg;
+        return NULL;
+    }
+    delete msg;
+    return Py_BuildValue("n", (Py_ssize_t)size);
+}
+
+static PyObject *Codec_decode(Codec *self, PyObject *args, PyObject *kwds) {
+    PyObject *input = NULL;
     int header_only = 0;
+    Py_ssize_t offset = 0, length = -1;
+    static char *kwlist[] = {"bytes", "header_only", "offset", "length", NULL};
     
-    // Parse inputs and convert to string
-    if (!PyArg_ParseTuple(args, "s#|i", &bytes, &size, &header_only))
+    // Parse inputs, decoding directly from the buffer
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|inn", kwlist, &input, &header_only, &offset, &length))
+        return NULL;
+    BufferView bytes;
+    if (!bytes.acquire(input, offset, length))
         return NULL;
-    std::string bytestr(bytes, size);
 
     // Do DCCL Decoding, and get a gp::Message
-    gp::Message *msg;
+    boost::shared_ptr<gp::Message> msg;
     try {
-        msg = self->codec->decode<gp::Message*>(bytestr, header_only != 0);
+        NativeCall call(self);
+        msg = dccl::DynamicProtobufManager::new_protobuf_message(loaded_descriptor(self->codec, bytes.begin(), bytes.end()));
+        self->codec->decode(bytes.begin(), bytes.end(), msg.get(), header_only != 0);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
         return NULL;
+    } catch (...) {
+        PyErr_SetString(DcclException, "unexpected exception");
+        return NULL;
     }
     
     // Convert the gp::Message to a Python Protobuf Message
-    PyObject* pyMsg = cpp_pbmsg_to_py_pbmsg(msg);
-    delete msg;
-    return pyMsg;
+    return cpp_pbmsg_to_py_pbmsg(msg.get());
+}
+
+static PyObject *Codec_encode_many(Codec *self, PyObject *args) {
+    PyObject *msgs_obj = NULL;
+    if (!PyArg_ParseTuple(args, "O", &msgs_obj))
+        return NULL;
+
+    PyObjectRefs refs;
+    PyObject *py_msgs = PySequence_Fast(msgs_obj, "encode_many() requires a sequence of messages.");
+    if (!py_msgs)
+        return NULL;
+    refs.push_back(py_msgs);
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(py_msgs);
+
+    // Serialize the Python messages (which needs the GIL), getting the type name once per Python type
+    std::map<PyTypeObject*, std::size_t> type_indices;
+    std::vector<std::string> type_names;
+    std::vector<std::size_t> msg_types(n);
+    std::vector<PyObject*> serialized(n);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject *py_msg = PySequence_Fast_GET_ITEM(py_msgs, i);
+        std::map<PyTypeObject*, std::size_t>::iterator it = type_indices.find(Py_TYPE(py_msg));
+        if (it == type_indices.end()) {
+            std::string full_name;
+            if (!py_pbmsg_full_name(py_msg, &full_name))
+                return NULL;
+            it = type_indices.insert(std::make_pair(Py_TYPE(py_msg), type_names.size())).first;
+            type_names.push_back(full_name);
+        }
+        msg_types[i] = it->second;
+        if (!(serialized[i] = py_pbmsg_serialize(py_msg)))
+            return NULL;
+        refs.push_back(serialized[i]);
+    }
+
+    // Look up the C++ types, then convert and encode them all in one go
+    std::vector<std::string> bytes;
+    try {
+        NativeCall call(self);
+        std::vector<const gp::Descriptor*> descs(type_names.size());
+        for (std::size_t i = 0, m = type_names.size(); i < m; ++i) {
+            descs[i] = dccl::DynamicProtobufManager::find_descriptor(type_names[i]);
+            if (!descs[i])
+                throw(dccl::Exception("Could not convert to a known DCCL protobuf type."));
+        }
+
+        std::vector<boost::shared_ptr<gp::Message> > cpp_msgs(n);
+        std::vector<const gp::Message*> cpp_msg_ptrs(n);
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            cpp_msgs[i] = dccl::DynamicProtobufManager::new_protobuf_message(descs[msg_types[i]]);
+            cpp_msgs[i]->ParseFromArray(PyBytes_AS_STRING(serialized[i]), PyBytes_GET_SIZE(serialized[i]));
+            cpp_msg_ptrs[i] = cpp_msgs[i].get();
+        }
+        self->codec->encode_many(&bytes, cpp_msg_ptrs);
+    } catch (dccl::Exception &e) {
+        PyErr_SetString(DcclException, e.what());
+        return NULL;
+    } catch (...) {
+        PyErr_SetString(DcclException, "unexpected exception");
+        return NULL;
+    }
+
+    PyObject *result = PyList_New(n);
+    if (!result)
+        return NULL;
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject *item = PyBytes_FromStringAndSize(bytes[i].data(), bytes[i].size());
+        if (!item) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    return result;
+}
+
+// The encoded messages given to decode_many() and decode_columns(): either one object supporting the
+// buffer protocol holding consecutive messages (viewed by concatenated, without copying), or a
+// sequence of them (copied to bytes)
+static int py_encoded_messages(PyObject *input, std::vector<std::string> *bytes, BufferView *concatenated) {
+    if (PyObject_CheckBuffer(input))
+        return concatenated->acquire(input);
+
+    PyObject *py_bytes = PySequence_Fast(input, "Expected a buffer (e.g. bytes) or a sequence of them.");
+    if (!py_bytes)
+        return 0;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(py_bytes);
+    bytes->resize(n);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        BufferView item;
+        if (!item.acquire(PySequence_Fast_GET_ITEM(py_bytes, i))) {
+            Py_DECREF(py_bytes);
+            return 0;
+        }
+        (*bytes)[i].assign(item.begin(), item.end());
+    }
+    Py_DECREF(py_bytes);
+    return 1;
+}
+
+static PyObject *Codec_decode_many(Codec *self, PyObject *args) {
+    PyObject *input = NULL;
+    if (!PyArg_ParseTuple(args, "O", &input))
+        return NULL;
+
+    std::vector<std::string> bytes;
+    BufferView concatenated;
+    if (!py_encoded_messages(input, &bytes, &concatenated))
+        return NULL;
+
+    // Decode them all in one go, serializing the results for conversion to Python messages
+    std::vector<const gp::Descriptor*> descs;
+    std::vector<std::string> serialized;
+    try {
+        NativeCall call(self);
+        std::vector<boost::shared_ptr<gp::Message> > msgs;
+        if (concatenated.size() > 0) {
+            // the end of each message is only known once it has been decoded
+            const char *begin = concatenated.begin(), *end = concatenated.end();
+            while (begin != end) {
+                msgs.push_back(dccl::DynamicProtobufManager::new_protobuf_message(loaded_descriptor(self->codec, begin, end)));
+                begin = self->codec->decode(begin, end, msgs.back().get());
+            }
+        } else {
+            self->codec->decode_many(bytes, &msgs);
+        }
+
+        descs.resize(msgs.size());
+        serialized.resize(msgs.size());
+        for (std::vector<boost::shared_ptr<gp::Message> >::size_type i = 0, n = msgs.size(); i < n; ++i) {
+            descs[i] = msgs[i]->GetDescriptor();
+            msgs[i]->SerializeToString(&serialized[i]);
+        }
+    } catch (dccl::Exception &e) {
+        PyErr_SetString(DcclException, e.what());
+        return NULL;
+    } catch (...) {
+        PyErr_SetString(DcclException, "unexpected exception");
+        return NULL;
+    }
+
+    // Create the Python messages, looking up the Python class once per type
+    PyObjectRefs refs;
+    std::map<const gp::Descriptor*, PyObject*> classes;
+    PyObject *result = PyList_New(serialized.size());
+    if (!result)
+        return NULL;
+    for (std::vector<std::string>::size_type i = 0, n = serialized.size(); i < n; ++i) {
+        PyObject *&cls = classes[descs[i]];
+        if (!cls) {
+            cls = PyObject_CallMethod(GPBSymbolDB, "GetSymbol", "s", descs[i]->full_name().c_str());
+            if (!cls) {
+                Py_DECREF(result);
+                return NULL;
+            }
+            refs.push_back(cls);
+        }
+        PyObject *msg = py_pbmsg_from_serialized(cls, serialized[i].data(), serialized[i].size());
+        if (!msg) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, msg);
+    }
+    return result;
+}
+
+// One column of decode_columns(): the values of a (non-message) field, given by the path of fields
+// to it from the root message, for each decoded message.
+struct Column {
+    Column() : width(0), masked(false) { }
+
+    std::vector<const gp::FieldDescriptor*> path;
+    std::string name;
+    // NumPy type string of data, or "O" for strings and bytes (which are in strings)
+    std::string dtype;
+    // values per message: max_repeat for repeated fields, or 0 for a single value
+    int width;
+    // whether the field may be missing (optional, repeated or in an optional message)
+    bool masked;
+    std::string data;
+    std::vector<std::string> strings;
+    // one byte per value, 1 if the value is missing
+    std::string mask;
+};
+
+template<typename T>
+static void append_value(Column *col, T value) {
+    col->data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Append a value of the field, or its default value if msg is NULL
+static void append_value(Column *col, const gp::Message *msg, int index) {
+    const gp::FieldDescriptor *field = col->path.back();
+    const gp::Reflection *refl = msg ? msg->GetReflection() : NULL;
+    bool repeated = field->is_repeated();
+    switch (field->cpp_type()) {
+        case gp::FieldDescriptor::CPPTYPE_DOUBLE:
+            append_value(col, !msg ? 0.0 : repeated ? refl->GetRepeatedDouble(*msg, field, index) : refl->GetDouble(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_FLOAT:
+            append_value(col, !msg ? 0.0f : repeated ? refl->GetRepeatedFloat(*msg, field, index) : refl->GetFloat(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_INT32:
+            append_value(col, !msg ? dccl::int32(0) : repeated ? refl->GetRepeatedInt32(*msg, field, index) : refl->GetInt32(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_INT64:
+            append_value(col, !msg ? dccl::int64(0) : repeated ? refl->GetRepeatedInt64(*msg, field, index) : refl->GetInt64(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_UINT32:
+            append_value(col, !msg ? dccl::uint32(0) : repeated ? refl->GetRepeatedUInt32(*msg, field, index) : refl->GetUInt32(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_UINT64:
+            append_value(col, !msg ? dccl::uint64(0) : repeated ? refl->GetRepeatedUInt64(*msg, field, index) : refl->GetUInt64(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_BOOL:
+            append_value(col, !msg ? false : repeated ? refl->GetRepeatedBool(*msg, field, index) : refl->GetBool(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_ENUM:
+            append_value(col, !msg ? field->default_value_enum()->number() : repeated ? refl->GetRepeatedEnum(*msg, field, index)->number() : refl->GetEnum(*msg, field)->number());
+            break;
+        case gp::FieldDescriptor::CPPTYPE_STRING:
+            col->strings.push_back(!msg ? std::string() : repeated ? refl->GetRepeatedString(*msg, field, index) : refl->GetString(*msg, field));
+            break;
+        case gp::FieldDescriptor::CPPTYPE_MESSAGE:
+            break;
+    }
+}
+
+// Append the values of one decoded message to the column
+static void append_column(const gp::Message &root, Column *col) {
+    // walk to the message containing the field, noting whether any optional message on the way is missing
+    const gp::Message *msg = &root;
+    for (std::vector<const gp::FieldDescriptor*>::size_type i = 0, n = col->path.size() - 1; i < n; ++i) {
+        const gp::FieldDescriptor *field = col->path[i];
+        if (!msg->GetReflection()->HasField(*msg, field)) {
+            msg = NULL;
+            break;
+        }
+        msg = &msg->GetReflection()->GetMessage(*msg, field);
+    }
+
+    const gp::FieldDescriptor *field = col->path.back();
+    if (field->is_repeated()) {
+        int size = msg ? std::min(msg->GetReflection()->FieldSize(*msg, field), col->width) : 0;
+        for (int i = 0; i < col->width; ++i) {
+            append_value(col, i < size ? msg : NULL, i);
+            col->mask.push_back(i >= size);
+        }
+    } else {
+        bool has = msg && msg->GetReflection()->HasField(*msg, field);
+        append_value(col, has ? msg : NULL, -1);
+        col->mask.push_back(!has);
+    }
+}
+
+// Add a column for each non-message field of desc (and of its non-repeated embedded messages)
+static void add_columns(const gp::Descriptor *desc, std::vector<const gp::FieldDescriptor*> path,
+                        bool masked, std::vector<Column> *cols) {
+    for (int i = 0, n = desc->field_count(); i < n; ++i) {
+        const gp::FieldDescriptor *field = desc->field(i);
+        std::vector<const gp::FieldDescriptor*> field_path(path);
+        field_path.push_back(field);
+        bool field_masked = masked || !field->is_required();
+
+        if (field->cpp_type() == gp::FieldDescriptor::CPPTYPE_MESSAGE) {
+            // repeated messages don't fit in columns
+            if (!field->is_repeated())
+                add_columns(field->message_type(), field_path, field_masked, cols);
+            continue;
+        }
+
+        Column col;
+        col.path = field_path;
+        for (std::vector<const gp::FieldDescriptor*>::size_type j = 0; j < field_path.size(); ++j)
+            col.name += (j ? "." : "") + field_path[j]->name();
+        col.masked = field_masked;
+        if (field->is_repeated())
+            col.width = field->options().GetExtension(dccl::field).max_repeat();
+
+        switch (field->cpp_type()) {
+            case gp::FieldDescriptor::CPPTYPE_DOUBLE: col.dtype = "=f8"; break;
+            case gp::FieldDescriptor::CPPTYPE_FLOAT: col.dtype = "=f4"; break;
+            case gp::FieldDescriptor::CPPTYPE_INT32: col.dtype = "=i4"; break;
+            case gp::FieldDescriptor::CPPTYPE_INT64: col.dtype = "=i8"; break;
+            case gp::FieldDescriptor::CPPTYPE_UINT32: col.dtype = "=u4"; break;
+            case gp::FieldDescriptor::CPPTYPE_UINT64: col.dtype = "=u8"; break;
+            case gp::FieldDescriptor::CPPTYPE_BOOL: col.dtype = "?"; break;
+            case gp::FieldDescriptor::CPPTYPE_ENUM: col.dtype = "=i4"; break;
+            case gp::FieldDescriptor::CPPTYPE_STRING: col.dtype = "O"; break;
+            case gp::FieldDescriptor::CPPTYPE_MESSAGE: break;
+        }
+        cols->push_back(col);
+    }
+}
+
+// Decode the message starting at begin (which must be of type desc) into msg, appending it to the columns
+template<typename CharIterator>
+static CharIterator decode_to_columns(dccl::Codec *codec, CharIterator begin, CharIterator end,
+                                      const gp::Descriptor *desc, gp::Message *msg, std::vector<Column> *cols) {
+    const gp::Descriptor *this_desc = loaded_descriptor(codec, begin, end);
+    if (this_desc != desc)
+        throw(dccl::Exception("decode_columns() requires messages of one type, but found both " + desc->full_name() + " and " + this_desc->full_name()));
+
+    msg->Clear();
+    begin = codec->decode(begin, end, msg);
+    for (std::vector<Column>::iterator col = cols->begin(), n = cols->end(); col != n; ++col)
+        append_column(*msg, &*col);
+    return begin;
+}
+
+static PyObject *Codec_decode_columns(Codec *self, PyObject *args) {
+    PyObject *input = NULL;
+    const char *type_name = NULL;
+    if (!PyArg_ParseTuple(args, "O|z", &input, &type_name))
+        return NULL;
+
+    std::vector<std::string> bytes;
+    BufferView concatenated;
+    if (!py_encoded_messages(input, &bytes, &concatenated))
+        return NULL;
+
+    // Decode each message into the same C++ message, appending its fields to the columns
+    std::vector<Column> cols;
+    Py_ssize_t count = 0;
+    try {
+        NativeCall call(self);
+        const gp::Descriptor *desc = NULL;
+        if (type_name) {
+            desc = dccl::DynamicProtobufManager::find_descriptor(type_name);
+            if (!desc)
+                throw(dccl::Exception("Could not find a type named " + std::string(type_name)));
+        } else if (!bytes.empty()) {
+            // the type of the first message
+            desc = loaded_descriptor(self->codec, bytes.front().begin(), bytes.front().end());
+        } else if (concatenated.size() > 0) {
+            desc = loaded_descriptor(self->codec, concatenated.begin(), concatenated.end());
+        }
+
+        if (desc) {
+            add_columns(desc, std::vector<const gp::FieldDescriptor*>(), false, &cols);
+            boost::shared_ptr<gp::Message> msg = dccl::DynamicProtobufManager::new_protobuf_message(desc);
+            if (bytes.empty()) {
+                for (const char *begin = concatenated.begin(), *end = concatenated.end(); begin != end; ++count)
+                    begin = decode_to_columns(self->codec, begin, end, desc, msg.get(), &cols);
+            } else {
+                for (std::vector<std::string>::const_iterator it = bytes.begin(), n = bytes.end(); it != n; ++it, ++count)
+                    decode_to_columns(self->codec, it->begin(), it->end(), desc, msg.get(), &cols);
+            }
+        }
+    } catch (dccl::Exception &e) {
+        PyErr_SetString(DcclException, e.what());
+        return NULL;
+    } catch (...) {
+        PyErr_SetString(DcclException, "unexpected exception");
+        return NULL;
+    }
+
+    // (count, [(name, dtype, data, mask, width), ...]) with data as a bytearray (or list for strings) and mask as a bytearray (or None)
+    PyObject *py_cols = PyList_New(cols.size());
+    if (!py_cols)
+        return NULL;
+    for (std::vector<Column>::size_type i = 0, n = cols.size(); i < n; ++i) {
+        Column &col = cols[i];
+        PyObject *data;
+        if (col.dtype == "O") {
+            bool is_bytes = col.path.back()->type() == gp::FieldDescriptor::TYPE_BYTES;
+            data = PyList_New(col.strings.size());
+            for (std::vector<std::string>::size_type j = 0, m = col.strings.size(); data && j < m; ++j) {
+                PyObject *item = is_bytes ?
+                    PyBytes_FromStringAndSize(col.strings[j].data(), col.strings[j].size()) :
+                    PyUnicode_DecodeUTF8(col.strings[j].data(), col.strings[j].size(), "replace");
+                if (!item) {
+                    Py_DECREF(data);
+                    data = NULL;
+                } else {
+                    PyList_SET_ITEM(data, j, item);
+                }
+            }
+        } else {
+            data = PyByteArray_FromStringAndSize(col.data.data(), col.data.size());
+        }
+        if (!data) {
+            Py_DECREF(py_cols);
+            return NULL;
+        }
+
+        PyObject *py_col;
+        if (col.masked) {
+            PyObject *mask = PyByteArray_FromStringAndSize(col.mask.data(), col.mask.size());
+            if (!mask) {
+                Py_DECREF(data);
+                Py_DECREF(py_cols);
+                return NULL;
+            }
+            py_col = Py_BuildValue("(ssNNi)", col.name.c_str(), col.dtype.c_str(), data, mask, col.width);
+        } else {
+            py_col = Py_BuildValue("(ssNOi)", col.name.c_str(), col.dtype.c_str(), data, Py_None, col.width);
+        }
+        if (!py_col) {
+            Py_DECREF(py_cols);
+            return NULL;
+        }
+        PyList_SET_ITEM(py_cols, i, py_col);
+    }
+    return Py_BuildValue("(nN)", count, py_cols);
 }
 
 static PyObject *Codec_load(Codec *self, PyObject *args) {
@@ -237,14 +857,14 @@ static PyObject *Codec_load(Codec *self, PyObject *args) {
     if (!PyArg_ParseTuple(args, "s", &type_name_ch))
         return NULL;
     std::string type_name(type_name_ch);
-    // Find the descriptor for that codec by name, and then feed it to codec->load.
-    const gp::Descriptor* desc = dccl::DynamicProtobufManager::find_descriptor(type_name);
-    if (!desc) {
-        PyErr_SetString(PyExc_LookupError, "Could not find a type by that name.");
-        return NULL;
-    }  
+    const gp::Descriptor* desc = NULL;
     try {
-        self->codec->load(desc);
+        // validating may find new descriptors
+        GlobalStateCall call(self);
+        // Find the descriptor for that codec by name, and then feed it to codec->load.
+        desc = dccl::DynamicProtobufManager::find_descriptor(type_name);
+        if (desc)
+            self->codec->load(desc);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
         return NULL;
@@ -252,6 +872,10 @@ static PyObject *Codec_load(Codec *self, PyObject *args) {
         PyErr_SetString(DcclException, "unexpected exception");
         return NULL;
     }
+    if (!desc) {
+        PyErr_SetString(PyExc_LookupError, "Could not find a type by that name.");
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
@@ -262,6 +886,7 @@ static PyObject *Codec_load_library(Codec *self, PyObject *args) {
         return NULL;
     std::string path(path_ch);
     try {
+        GlobalStateCall call(self);
         self->codec->load_library(path);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -310,6 +935,7 @@ static PyObject *Codec_set_crypto_passphrase(Codec *self, PyObject *args) {
     }
 
     try {
+        NativeCall call(self);
         self->codec->set_crypto_passphrase(passphrase, skip_set);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -323,14 +949,22 @@ static PyObject *Codec_set_crypto_passphrase(Codec *self, PyObject *args) {
 
 
 static PyMethodDef Codec_methods[] = {
-    {"id", (PyCFunction)Codec_id, METH_VARARGS,
-     "id(bytes)\n\nReturn the ID for a string or message."},
+    {"id", (PyCFunction)Codec_id, METH_VARARGS | METH_KEYWORDS,
+     "id(bytes[, offset, length])\n\nReturn the ID for an encoded message in any buffer (bytes, bytearray, memoryview, mmap, ...), optionally starting at offset."},
     {"size", (PyCFunction)Codec_size, METH_VARARGS,
      "size(message)\n\nProvide the encoded size (in bytes) of message."},
     {"encode", (PyCFunction)Codec_encode, METH_VARARGS,
      "encode(message[, header_only])\n\nReturn a DCCL-encoded string for message."},
-    {"decode", (PyCFunction)Codec_decode, METH_VARARGS,
-     "decode(bytes[, header_only])\n\nReturn a protobuf message decoded from bytes."},
+    {"encode_into", (PyCFunction)Codec_encode_into, METH_VARARGS | METH_KEYWORDS,
+     "encode_into(message, buffer[, offset, header_only])\n\nEncode message into a writable buffer (bytearray, memoryview, mmap, ...) starting at offset, returning the number of bytes written."},
+    {"decode", (PyCFunction)Codec_decode, METH_VARARGS | METH_KEYWORDS,
+     "decode(bytes[, header_only, offset, length])\n\nReturn a protobuf message decoded from any buffer (bytes, bytearray, memoryview, mmap, ...), optionally starting at offset."},
+    {"encode_many", (PyCFunction)Codec_encode_many, METH_VARARGS,
+     "encode_many(messages)\n\nReturn a list of DCCL-encoded strings, one for each of messages (all encoded in one call)."},
+    {"decode_many", (PyCFunction)Codec_decode_many, METH_VARARGS,
+     "decode_many(bytes_list_or_bytes)\n\nReturn a list of protobuf messages decoded from a list of encoded messages, or from one buffer (e.g. bytes or mmap) of consecutive encoded messages."},
+    {"_decode_columns", (PyCFunction)Codec_decode_columns, METH_VARARGS,
+     "_decode_columns(bytes_list_or_bytes[, type_name])\n\nDecode messages of one type into columns of raw values (see dccl.decode_columns())."},
     {"load", (PyCFunction)Codec_load, METH_VARARGS,
      "load(type_name)\n\nEnsure that type_name is registered for use with DCCL."},
     {"load_library", (PyCFunction)Codec_load_library, METH_VARARGS,
@@ -401,7 +1035,13 @@ static PyObject *dccl_addProtoIncludePath(PyObject *self, PyObject *args) {
     if (!PyArg_ParseTuple(args, "s", &path))
         return NULL;
     std::string pathstr = path;
-    dccl::DynamicProtobufManager::add_include_path(pathstr);
+    try {
+        GlobalStateCall call;
+        dccl::DynamicProtobufManager::add_include_path(pathstr);
+    } catch (std::exception &e) {
+        PyErr_SetString(DcclException, e.what());
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
@@ -412,6 +1052,7 @@ static PyObject *dccl_loadProtoFile(PyObject *self, PyObject *args) {
         return NULL;
     std::string filenamestr = filename;
     try {
+        GlobalStateCall call;
         dccl::DynamicProtobufManager::load_from_proto_file(filenamestr);
     } catch (dccl::Exception &e) {
         PyErr_SetString(DcclException, e.what());
@@ -423,11 +1064,26 @@ static PyObject *dccl_loadProtoFile(PyObject *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject *dccl_enableProtoCache(PyObject *self, PyObject *args) {
+    const char *path;
+
+    if (!PyArg_ParseTuple(args, "s", &path))
+        return NULL;
+    std::string pathstr = path;
+    {
+        GlobalStateCall call;
+        dccl::DynamicProtobufManager::enable_proto_cache(pathstr);
+    }
+    Py_RETURN_NONE;
+}
+
 static PyMethodDef DcclMethods[] = {
     {"loadProtoFile", (PyCFunction)dccl_loadProtoFile, METH_VARARGS,
      "Load the types in a specific protobuf file (.proto).  The path *MUST* be absolute."},
     {"addProtoIncludePath", (PyCFunction)dccl_addProtoIncludePath, METH_VARARGS,
      "Adds a path to a collection of protobuf files (.proto)."},
+    {"enableProtoCache", (PyCFunction)dccl_enableProtoCache, METH_VARARGS,
+     "Caches the parsed protobuf files (.proto) loaded with loadProtoFile in the given directory, for faster loading next time."},
     {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
@@ -460,7 +1116,6 @@ init_dccl(void)
 #endif
 {
 
-  dccl_CodecType.tp_new = PyType_GenericNew;
   if (PyType_Ready(&dccl_CodecType) < 0) {
     INITERROR;
   }
@@ -12,6 +12,11 @@ from distutils.command.build_py import build_py as _build_py
 import subprocess
 import os, sys
 
+# Where the DCCL headers and .proto files are (a DCCL build or install tree), and protobuf's .proto files.
+# Relative paths are relative to this directory. tests/common.py uses the same variables.
+DCCL_INCLUDE_DIR = os.environ.get('DCCL_INCLUDE_DIR', '../build/include')
+PROTOBUF_INCLUDE_DIR = os.environ.get('PROTOBUF_INCLUDE_DIR', '/usr/include')
+
 def get_version():
     return open('../version.txt', 'r').readline().strip()
 
@@ -30,7 +35,8 @@ class clean(_clean):
 class build_py(_build_py):
   def run(self):
     # Generate option_extension.proto file.
-    protoc_command = ['protoc', '-I../build/include/', '-I/usr/include', '--python_out=.', '../build/include/dccl/option_extensions.proto']
+    protoc_command = ['protoc', '-I' + DCCL_INCLUDE_DIR, '-I' + PROTOBUF_INCLUDE_DIR, '--python_out=.',
+                      os.path.join(DCCL_INCLUDE_DIR, 'dccl', 'option_extensions.proto')]
     if subprocess.call(protoc_command) != 0:
       sys.exit(-1)
 
@@ -50,6 +56,7 @@ setup(
         Extension(
             "dccl._dccl",
             ["dccl/_dccl.cc"],
+            include_dirs=[DCCL_INCLUDE_DIR],
             libraries=['dccl', 'protobuf'],
             extra_compile_args = ["-Wno-write-strings"], # Hide a bunch of c++ warnings.
         )
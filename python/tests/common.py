@@ -0,0 +1,50 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Shared fixture for the binding tests: compiles a test .proto file for both Python and DCCL.
+
+Set DCCL_INCLUDE_DIR and PROTOBUF_INCLUDE_DIR as when running setup.py, if DCCL was not built in ../build.
+"""
+
+import importlib
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+import dccl
+
+
+def include_dirs():
+    # as for setup.py: where dccl/option_extensions.proto is, and protobuf's .proto files
+    python_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    return [os.path.join(python_dir, os.environ.get("DCCL_INCLUDE_DIR", "../build/include")),
+            os.environ.get("PROTOBUF_INCLUDE_DIR", "/usr/include")]
+
+
+class ProtoTestCase(unittest.TestCase):
+    """Writes PROTO (the text of a .proto file) to MODULE.proto in a temporary directory, imports the
+    generated Python module as cls.pb2, and loads the file into DCCL."""
+    PROTO = None
+    MODULE = None
+
+    @classmethod
+    def setUpClass(cls):
+        cls.tmpdir = tempfile.mkdtemp()
+        proto_path = os.path.join(cls.tmpdir, cls.MODULE + ".proto")
+        with open(proto_path, "w") as f:
+            f.write(cls.PROTO)
+        subprocess.check_call(["protoc"] + ["-I" + d for d in include_dirs() + [cls.tmpdir]] +
+                              ["--python_out=" + cls.tmpdir, proto_path])
+        sys.path.insert(0, cls.tmpdir)
+        cls.pb2 = importlib.import_module(cls.MODULE + "_pb2")
+
+        dccl.addProtoIncludePath(include_dirs()[0])
+        dccl.addProtoIncludePath(cls.tmpdir)
+        dccl.loadProtoFile(proto_path)
+
+    @classmethod
+    def tearDownClass(cls):
+        sys.path.remove(cls.tmpdir)
+        shutil.rmtree(cls.tmpdir)
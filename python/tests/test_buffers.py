@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Tests for decoding from and encoding into buffer objects (offset and length, Codec.encode_into()).
+
+Run from the python directory after building in place (python setup.py build_py egg_info build_ext
+--inplace), with libdccl on the library path: python -m unittest discover tests
+"""
+
+import unittest
+
+import dccl
+
+from common import ProtoTestCase
+
+TEST_PROTO = """
+syntax = "proto2";
+import "dccl/option_extensions.proto";
+
+package dccl.pytest;
+
+message BufferTest
+{
+    option (dccl.msg).id = 122;
+    option (dccl.msg).max_bytes = 32;
+    option (dccl.msg).codec_version = 3;
+
+    required int32 a = 1 [(dccl.field).min = -100, (dccl.field).max = 100];
+    optional string s = 2 [(dccl.field).max_length = 10];
+}
+"""
+
+
+class BufferTest(ProtoTestCase):
+    PROTO = TEST_PROTO
+    MODULE = "buffer_test"
+
+    def setUp(self):
+        self.codec = dccl.Codec()
+        self.codec.load("dccl.pytest.BufferTest")
+        self.msg = self.pb2.BufferTest(a=-42, s="buffer")
+        self.encoded = self.codec.encode(self.msg)
+
+    def test_decode_offset(self):
+        padded = b"\xff" * 5 + self.encoded + b"\xee" * 3
+        offset = 5
+        for buf in (padded, bytearray(padded), memoryview(padded), memoryview(bytearray(padded))):
+            self.assertEqual(self.codec.decode(buf, offset=offset), self.msg)
+            self.assertEqual(self.codec.decode(buf, offset=offset, length=len(self.encoded)), self.msg)
+            self.assertEqual(self.codec.id(buf, offset=offset), 122)
+
+        # a slice of a memoryview starts at a nonzero offset into the underlying buffer
+        view = memoryview(bytearray(padded))[offset:]
+        self.assertEqual(self.codec.decode(view), self.msg)
+        self.assertEqual(self.codec.id(view), 122)
+
+    def test_decode_out_of_range(self):
+        buf = bytearray(self.encoded)
+        with self.assertRaises(ValueError):
+            self.codec.decode(buf, offset=len(buf) + 1)
+        with self.assertRaises(ValueError):
+            self.codec.decode(buf, offset=-1)
+        with self.assertRaises(ValueError):
+            self.codec.decode(buf, offset=1, length=len(buf))
+        with self.assertRaises(ValueError):
+            self.codec.id(memoryview(buf), offset=len(buf) + 1)
+        with self.assertRaises(ValueError):
+            self.codec.id(memoryview(buf), offset=0, length=len(buf) + 1)
+
+    def test_encode_into_exact(self):
+        buf = bytearray(len(self.encoded))
+        self.assertEqual(self.codec.encode_into(self.msg, buf), len(self.encoded))
+        self.assertEqual(bytes(buf), self.encoded)
+
+        # at an offset into a larger buffer, leaving the rest untouched
+        buf = bytearray(b"\xaa" * (len(self.encoded) + 4))
+        self.assertEqual(self.codec.encode_into(self.msg, buf, 2), len(self.encoded))
+        self.assertEqual(bytes(buf[2:2 + len(self.encoded)]), self.encoded)
+        self.assertEqual(bytes(buf[:2]), b"\xaa\xaa")
+        self.assertEqual(bytes(buf[2 + len(self.encoded):]), b"\xaa\xaa")
+
+    def test_encode_into_too_small(self):
+        buf = bytearray(len(self.encoded) - 1)
+        with self.assertRaises(dccl.DcclException):
+            self.codec.encode_into(self.msg, buf)
+        buf = bytearray(len(self.encoded))
+        with self.assertRaises(dccl.DcclException):
+            self.codec.encode_into(self.msg, buf, 1)
+
+    def test_encode_into_read_only(self):
+        # rejected when the writable buffer is requested: TypeError for bytes, BufferError for a read-only view
+        for buf in (bytes(len(self.encoded)), memoryview(bytearray(len(self.encoded))).toreadonly()):
+            with self.assertRaises((TypeError, BufferError)):
+                self.codec.encode_into(self.msg, buf)
+
+
+if __name__ == "__main__":
+    unittest.main()
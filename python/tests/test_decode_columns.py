@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Tests for dccl.decode_columns(), compared against decoding each message with Codec.decode().
+
+Run from the python directory after building in place (python setup.py build_py egg_info build_ext
+--inplace), with libdccl on the library path: python -m unittest discover tests
+"""
+
+import unittest
+
+import numpy
+
+import dccl
+
+from common import ProtoTestCase
+
+TEST_PROTO = """
+syntax = "proto2";
+import "dccl/option_extensions.proto";
+
+package dccl.pytest;
+
+enum ColumnsEnum
+{
+    COLUMNS_A = 1;
+    COLUMNS_B = 2;
+    COLUMNS_C = 5;
+}
+
+message ColumnsPosition
+{
+    required double x = 1 [(dccl.field).min = -100, (dccl.field).max = 100, (dccl.field).precision = 1];
+    optional int32 depth = 2 [(dccl.field).min = 0, (dccl.field).max = 1000];
+}
+
+message ColumnsTest
+{
+    option (dccl.msg).id = 121;
+    option (dccl.msg).max_bytes = 64;
+    option (dccl.msg).codec_version = 3;
+
+    required int32 a = 1 [(dccl.field).min = -100, (dccl.field).max = 100];
+    required uint64 big = 2 [(dccl.field).min = 0, (dccl.field).max = 100000];
+    optional double b = 3 [(dccl.field).min = 0, (dccl.field).max = 10, (dccl.field).precision = 1];
+    required ColumnsEnum e = 4;
+    optional string s = 5 [(dccl.field).max_length = 8];
+    required bool flag = 6;
+    optional ColumnsPosition pos = 7;
+    repeated uint32 c = 8 [(dccl.field).min = 0, (dccl.field).max = 15, (dccl.field).max_repeat = 3];
+}
+"""
+
+
+class DecodeColumnsTest(ProtoTestCase):
+    PROTO = TEST_PROTO
+    MODULE = "columns_test"
+
+    def setUp(self):
+        self.codec = dccl.Codec()
+        self.codec.load("dccl.pytest.ColumnsTest")
+
+    def make_msgs(self, n):
+        enums = [self.pb2.COLUMNS_A, self.pb2.COLUMNS_B, self.pb2.COLUMNS_C]
+        msgs = []
+        for i in range(n):
+            msg = self.pb2.ColumnsTest(a=i - n // 2, big=i * 997, e=enums[i % 3], flag=(i % 3 == 0))
+            if i % 2:
+                msg.b = (i % 100) / 10.0
+            if i % 3:
+                msg.s = "s%d" % i
+            if i % 4:
+                msg.pos.x = i - 50.5
+                if i % 5:
+                    msg.pos.depth = i * 10
+            msg.c.extend(range(i % 4))
+            msgs.append(msg)
+        return msgs
+
+    def check_column(self, column, values, masked):
+        # values are the field values from Codec.decode(), with None for a missing field
+        self.assertEqual(len(column), len(values))
+        self.assertEqual(isinstance(column, numpy.ma.MaskedArray), masked)
+        if masked:
+            self.assertEqual(list(numpy.ma.getmaskarray(column)), [v is None for v in values])
+        for row, value in zip(column, values):
+            if value is not None:
+                self.assertEqual(row, value)
+
+    def test_columns(self):
+        msgs = self.make_msgs(40)
+        encoded = self.codec.encode_many(msgs)
+        decoded = [self.codec.decode(enc) for enc in encoded]
+
+        columns = dccl.decode_columns(self.codec, encoded)
+        self.assertEqual(sorted(columns),
+                         sorted(["a", "big", "b", "e", "s", "flag", "pos.x", "pos.depth", "c"]))
+
+        # required fields are plain arrays
+        self.check_column(columns["a"], [d.a for d in decoded], False)
+        self.assertEqual(columns["a"].dtype, numpy.int32)
+        self.check_column(columns["big"], [d.big for d in decoded], False)
+        self.assertEqual(columns["big"].dtype, numpy.uint64)
+        self.check_column(columns["e"], [d.e for d in decoded], False)
+        self.assertEqual(columns["e"].dtype, numpy.int32)
+        self.check_column(columns["flag"], [d.flag for d in decoded], False)
+        self.assertEqual(columns["flag"].dtype, numpy.bool_)
+
+        # optional fields are masked where Codec.decode() leaves them unset
+        self.check_column(columns["b"], [d.b if d.HasField("b") else None for d in decoded], True)
+        self.check_column(columns["s"], [d.s if d.HasField("s") else None for d in decoded], True)
+        self.assertEqual(columns["s"].dtype, object)
+
+        # fields of an optional embedded message are masked when the message is missing
+        self.check_column(columns["pos.x"], [d.pos.x if d.HasField("pos") else None for d in decoded], True)
+        self.check_column(columns["pos.depth"],
+                          [d.pos.depth if d.HasField("pos") and d.pos.HasField("depth") else None
+                           for d in decoded], True)
+
+        # repeated fields are (count, max_repeat), masked past the end of each message's values
+        c = columns["c"]
+        self.assertIsInstance(c, numpy.ma.MaskedArray)
+        self.assertEqual(c.shape, (len(msgs), 3))
+        for row, d in zip(c, decoded):
+            self.assertEqual(list(numpy.ma.getmaskarray(row)), [i >= len(d.c) for i in range(3)])
+            self.assertEqual(list(row.compressed()), list(d.c))
+
+        # one bytes object of consecutive messages gives the same columns
+        joined = dccl.decode_columns(self.codec, b"".join(encoded))
+        for name, column in columns.items():
+            self.assertTrue(numpy.ma.allequal(joined[name], column), name)
+
+    def test_empty(self):
+        columns = dccl.decode_columns(self.codec, [], "dccl.pytest.ColumnsTest")
+        self.assertEqual(len(columns["a"]), 0)
+        self.assertEqual(columns["c"].shape, (0, 3))
+
+
+if __name__ == "__main__":
+    unittest.main()
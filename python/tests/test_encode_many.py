@@ -0,0 +1,92 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Smoke tests for Codec.encode_many() and Codec.decode_many().
+
+Run from the python directory after building in place (python setup.py build_py egg_info build_ext
+--inplace), with libdccl on the library path: python -m unittest discover tests
+"""
+
+import threading
+import unittest
+
+import dccl
+
+from common import ProtoTestCase
+
+TEST_PROTO = """
+syntax = "proto2";
+import "dccl/option_extensions.proto";
+
+package dccl.pytest;
+
+message ManyTest
+{
+    option (dccl.msg).id = 120;
+    option (dccl.msg).max_bytes = 32;
+    option (dccl.msg).codec_version = 3;
+
+    required int32 a = 1 [(dccl.field).min = -100, (dccl.field).max = 100];
+    optional double b = 2 [(dccl.field).min = 0, (dccl.field).max = 10, (dccl.field).precision = 1];
+    repeated uint32 c = 3 [(dccl.field).min = 0, (dccl.field).max = 15, (dccl.field).max_repeat = 3];
+}
+"""
+
+
+class EncodeManyTest(ProtoTestCase):
+    PROTO = TEST_PROTO
+    MODULE = "many_test"
+
+    def make_msgs(self, n):
+        msgs = []
+        for i in range(n):
+            msg = self.pb2.ManyTest(a=i - n // 2)
+            if i % 2:
+                msg.b = (i % 100) / 10.0
+            msg.c.extend(range(i % 4))
+            msgs.append(msg)
+        return msgs
+
+    def test_round_trip(self):
+        codec = dccl.Codec()
+        codec.load("dccl.pytest.ManyTest")
+        msgs = self.make_msgs(50)
+
+        encoded = codec.encode_many(msgs)
+        self.assertEqual(len(encoded), len(msgs))
+        for msg, enc in zip(msgs, encoded):
+            self.assertEqual(enc, codec.encode(msg))
+
+        self.assertEqual(codec.decode_many(encoded), msgs)
+        self.assertEqual(codec.decode_many(b"".join(encoded)), msgs)
+        self.assertEqual(codec.decode_many([]), [])
+
+    def test_threads(self):
+        # loading (global state) on some threads while others encode and decode on their own Codecs
+        msgs = self.make_msgs(20)
+        errors = []
+
+        def work(load_only):
+            try:
+                for _ in range(20):
+                    codec = dccl.Codec()
+                    codec.load("dccl.pytest.ManyTest")
+                    if load_only:
+                        # changes the proto search path while other threads look up types by name
+                        dccl.addProtoIncludePath(self.tmpdir)
+                    else:
+                        self.assertEqual(codec.decode_many(codec.encode_many(msgs)), msgs)
+                        self.assertEqual([codec.decode(codec.encode(m)) for m in msgs], msgs)
+                        self.assertEqual(codec.size(msgs[0]), len(codec.encode(msgs[0])))
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=work, args=(i % 2 == 0,)) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -28,6 +28,12 @@
 
 #include <sstream>
 #include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <cmath>
+#include <new>
+#include <algorithm>
+#include <cerrno>
 
 
 #include <google/protobuf/descriptor.h>
@@ -35,10 +41,13 @@
 #include <google/protobuf/descriptor.pb.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "dccl/codec.h"
 #include "dccl/cli_option.h"
 #include "dccl/binary.h"
+#include "dccl/message_generator.h"
 
 #include "dccl_tool.pb.h"
 #include "dccl/version.h"
@@ -47,9 +56,44 @@
 #include <limits.h>
 #include <stdlib.h>
 
+// for mmap and isatty
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
 
-enum Action { NO_ACTION, ENCODE, DECODE, ANALYZE, DISP_PROTO };
-enum Format { BINARY, TEXTFORMAT, HEX, BASE64 };
+
+enum Action { NO_ACTION, ENCODE, DECODE, ANALYZE, DISP_PROTO, BENCHMARK, GENERATE };
+enum Format { BINARY, FRAMED, TEXTFORMAT, HEX, BASE64 };
+
+// records given to each thread at a time by encode and decode
+const std::size_t BATCH_RECORDS_PER_THREAD = 1024;
+
+// minimum time spent timing each operation of --benchmark
+const double BENCHMARK_MIN_SECONDS = 0.5;
+
+#ifdef DCCL_TOOL_COUNT_ALLOCATIONS
+// heap allocations made while allocation_counting is set, which is only done by --benchmark.
+// Only built with the CMake option count_allocations, so other builds of the tool keep the standard allocator.
+boost::atomic<bool> allocation_counting(false);
+boost::atomic<unsigned long long> allocation_count(0);
+
+void* operator new(std::size_t size)
+{
+    if(allocation_counting.load(boost::memory_order_relaxed))
+        allocation_count.fetch_add(1, boost::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+#endif
 
 namespace dccl
 {
@@ -63,7 +107,14 @@ namespace dccl
                   format(BINARY),
                   id_codec(dccl::Codec::default_id_codec_name()),
                   verbose(false),
-                  omit_prefix(false)
+                  omit_prefix(false),
+                  threads(1),
+                  frame_size(0),
+                  count(1000),
+                  seed(1),
+                  worst_case(false),
+                  profile(false),
+                  reference_time(-1)
                 { }
     
             Action action;
@@ -71,10 +122,22 @@ namespace dccl
             std::vector<std::string> dlopen;
             std::set<std::string> message;
             std::set<std::string> proto_file;
+            std::string proto_cache;
             Format format;
             std::string id_codec;
             bool verbose;
             bool omit_prefix;
+            unsigned threads;
+            // bytes in each message of decode input, or 0 if not fixed
+            unsigned frame_size;
+            std::string input;
+            std::string crypto_passphrase;
+            unsigned count;
+            unsigned seed;
+            bool worst_case;
+            bool profile;
+            // seconds since the UNIX epoch, or < 0 for the system clock
+            double reference_time;
         };
     }
 }
@@ -84,11 +147,295 @@ void analyze(dccl::Codec& dccl, const dccl::tool::Config& cfg);
 void encode(dccl::Codec& dccl, dccl::tool::Config& cfg);
 void decode(dccl::Codec& dccl, const dccl::tool::Config& cfg);
 void disp_proto(dccl::Codec& dccl, const dccl::tool::Config& cfg);
+void benchmark(dccl::Codec& dccl, const dccl::tool::Config& cfg);
+void generate(dccl::Codec& dccl, const dccl::tool::Config& cfg);
+bool uses_arithmetic_codec(const google::protobuf::Descriptor* desc, std::set<const google::protobuf::Descriptor*>* visited);
 
         
 void load_desc(dccl::Codec* dccl,  const google::protobuf::Descriptor* desc, const std::string& name);
 void parse_options(int argc, char* argv[], dccl::tool::Config* cfg);
 
+// Record input and output for encode() and decode()
+namespace dccl
+{
+    namespace tool
+    {
+        /// All of the input, either memory mapped from a file or read from stdin
+        class InputBuffer
+        {
+          public:
+            InputBuffer(const std::string& path)
+                : mapped_(0), mapped_size_(0)
+            {
+                if(path.empty())
+                {
+                    // read stdin in large blocks
+                    std::vector<char> block(1 << 20);
+                    std::size_t n;
+                    while((n = fread(&block[0], 1, block.size(), stdin)) > 0)
+                        stdin_data_.append(&block[0], n);
+                    begin_ = stdin_data_.data();
+                    end_ = begin_ + stdin_data_.size();
+                    return;
+                }
+                
+                int fd = open(path.c_str(), O_RDONLY);
+                struct stat st;
+                if(fd < 0 || fstat(fd, &st) != 0)
+                {
+                    std::cerr << "Failed to open input file: " << path << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                mapped_size_ = st.st_size;
+                if(mapped_size_ > 0)
+                {
+                    mapped_ = mmap(0, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(mapped_ == MAP_FAILED)
+                    {
+                        std::cerr << "Failed to memory map input file: " << path << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    madvise(mapped_, mapped_size_, MADV_SEQUENTIAL);
+                }
+                close(fd);
+                
+                begin_ = static_cast<const char*>(mapped_);
+                end_ = begin_ + mapped_size_;
+            }
+            
+            ~InputBuffer()
+            {
+                if(mapped_)
+                    munmap(mapped_, mapped_size_);
+            }
+
+            const char* begin() const { return begin_; }
+            const char* end() const { return end_; }
+            
+          private:
+            InputBuffer(const InputBuffer&);
+            InputBuffer& operator=(const InputBuffer&);
+            
+            void* mapped_;
+            std::size_t mapped_size_;
+            std::string stdin_data_;
+            const char* begin_;
+            const char* end_;
+        };
+
+        /// Reads lines from a memory mapped file, or stdin (as it becomes available, so interactive use works)
+        class LineReader
+        {
+          public:
+            LineReader(const std::string& path)
+                : input_(path.empty() ? 0 : new InputBuffer(path)),
+                  pos_(input_ ? input_->begin() : 0),
+                  stdin_pos_(0),
+                  stdin_eof_(false)
+            { }
+            
+            bool getline(std::string* line)
+            {
+                if(!input_)
+                    return getline_stdin(line);
+                
+                if(pos_ == input_->end())
+                    return false;
+                const char* eol = std::find(pos_, input_->end(), '\n');
+                line->assign(pos_, eol);
+                pos_ = (eol == input_->end()) ? eol : eol + 1;
+                return true;
+            }
+
+          private:
+            // reads stdin with read() rather than std::getline(), so that the bytes are passed through unchanged
+            // (as with the fread() of binary input in InputBuffer) and each read returns whatever is available
+            bool getline_stdin(std::string* line)
+            {
+                for(;;)
+                {
+                    std::string::size_type eol = stdin_data_.find('\n', stdin_pos_);
+                    if(eol != std::string::npos)
+                    {
+                        line->assign(stdin_data_, stdin_pos_, eol - stdin_pos_);
+                        stdin_pos_ = eol + 1;
+                        return true;
+                    }
+                    
+                    if(stdin_eof_)
+                    {
+                        if(stdin_pos_ == stdin_data_.size())
+                            return false;
+                        // last line, without a newline
+                        line->assign(stdin_data_, stdin_pos_, std::string::npos);
+                        stdin_pos_ = stdin_data_.size();
+                        return true;
+                    }
+
+                    stdin_data_.erase(0, stdin_pos_);
+                    stdin_pos_ = 0;
+                    
+                    char block[1 << 16];
+                    ssize_t n = read(STDIN_FILENO, block, sizeof(block));
+                    if(n < 0 && errno == EINTR)
+                        continue;
+                    if(n <= 0)
+                        stdin_eof_ = true;
+                    else
+                        stdin_data_.append(block, n);
+                }
+            }
+            
+            boost::shared_ptr<InputBuffer> input_;
+            const char* pos_;
+            
+            std::string stdin_data_;
+            std::string::size_type stdin_pos_;
+            bool stdin_eof_;
+        };
+        
+        /// Buffers output, writing it to stdout in large blocks
+        class OutputBuffer
+        {
+          public:
+            OutputBuffer() { }
+            ~OutputBuffer() { flush(); }
+            
+            void append(const std::string& s)
+            {
+                buffer_ += s;
+                if(buffer_.size() >= FLUSH_SIZE)
+                    flush();
+            }
+            
+            void flush()
+            {
+                if(!buffer_.empty())
+                {
+                    fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+                    buffer_.clear();
+                }
+                fflush(stdout);
+            }
+            
+          private:
+            enum { FLUSH_SIZE = 1 << 20 };
+            std::string buffer_;
+        };
+        
+        /// Processes one batch of records, split among a number of threads
+        class BatchWorker
+        {
+          public:
+            virtual ~BatchWorker() { }
+
+            /// Process record i on thread (0 is the calling thread), storing any error in errors[i]
+            virtual void process(unsigned thread, std::size_t i) = 0;
+
+            void run(std::size_t size, unsigned num_threads)
+            {
+                size_ = size;
+                num_threads_ = std::max(1u, std::min<unsigned>(num_threads, size));
+                errors.assign(size, std::string());
+                
+                std::vector<pthread_t> threads(num_threads_);
+                std::vector<std::pair<BatchWorker*, unsigned> > args(num_threads_);
+                for(unsigned t = 1; t < num_threads_; ++t)
+                {
+                    args[t] = std::make_pair(this, t);
+                    pthread_create(&threads[t], 0, &BatchWorker::thread_main, &args[t]);
+                }
+                process_range(0);
+                for(unsigned t = 1; t < num_threads_; ++t)
+                    pthread_join(threads[t], 0);
+            }
+
+            std::vector<std::string> errors;
+
+          private:
+            static void* thread_main(void* arg)
+            {
+                std::pair<BatchWorker*, unsigned>* worker_thread = static_cast<std::pair<BatchWorker*, unsigned>*>(arg);
+                worker_thread->first->process_range(worker_thread->second);
+                return 0;
+            }
+            
+            // contiguous ranges, so each thread works on neighboring records
+            void process_range(unsigned thread)
+            {
+                for(std::size_t i = size_ * thread / num_threads_, end = size_ * (thread + 1) / num_threads_; i < end; ++i)
+                {
+                    try { process(thread, i); }
+                    catch(std::exception& e) { errors[i] = e.what(); }
+                }
+            }
+
+            std::size_t size_;
+            unsigned num_threads_;
+        };
+        
+        /// A Codec for each thread, with the same messages loaded
+        class CodecPool
+        {
+          public:
+            CodecPool(dccl::Codec* codec, const Config& cfg)
+            {
+                codecs_.push_back(codec);
+                for(unsigned t = 1; t < cfg.threads; ++t)
+                {
+                    // codecs in libraries were already added to FieldCodecManager by codec,
+                    // which may also have changed its id codec (e.g. the CCL library)
+                    boost::shared_ptr<dccl::Codec> thread_codec(new dccl::Codec(codec->get_id_codec()));
+                    if(!cfg.crypto_passphrase.empty())
+                        thread_codec->set_crypto_passphrase(cfg.crypto_passphrase);
+                    if(cfg.reference_time >= 0)
+                        thread_codec->set_reference_time(cfg.reference_time);
+                    owned_.push_back(thread_codec);
+                    codecs_.push_back(thread_codec.get());
+                    for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = codec->loaded().begin(), end = codec->loaded().end(); it != end; ++it)
+                        thread_codec->load(it->second, it->first);
+                }
+            }
+
+            dccl::Codec& operator[](unsigned thread) { return *codecs_[thread]; }
+            
+            void load(const google::protobuf::Descriptor* desc, const std::string& name)
+            {
+                for(std::size_t t = 0, n = codecs_.size(); t < n; ++t)
+                    load_desc(codecs_[t], desc, name);
+            }
+            
+          private:
+            std::vector<dccl::Codec*> codecs_;
+            std::vector<boost::shared_ptr<dccl::Codec> > owned_;
+        };
+
+        void append_varint(std::string* out, std::size_t value)
+        {
+            while(value >= 0x80)
+            {
+                out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out->push_back(static_cast<char>(value));
+        }
+
+        bool read_varint(const char** pos, const char* end, std::size_t* value)
+        {
+            *value = 0;
+            for(int shift = 0; *pos != end && shift < 64; shift += 7)
+            {
+                unsigned char byte = static_cast<unsigned char>(*(*pos)++);
+                *value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+                if(!(byte & 0x80))
+                    return true;
+            }
+            return false;
+        }
+    }
+}
+
 
 int main(int argc, char* argv[])
 {
@@ -107,6 +454,8 @@ int main(int argc, char* argv[])
                 end = cfg.include.end(); it != end; ++it)
             dccl::DynamicProtobufManager::add_include_path(*it);
     
+        if(!cfg.proto_cache.empty())
+            dccl::DynamicProtobufManager::enable_proto_cache(cfg.proto_cache);
 
 
         std::string first_dl;
@@ -114,6 +463,10 @@ int main(int argc, char* argv[])
             first_dl = cfg.dlopen[0];
         
         dccl::Codec dccl(cfg.id_codec, first_dl);
+        if(!cfg.crypto_passphrase.empty())
+            dccl.set_crypto_passphrase(cfg.crypto_passphrase);
+        if(cfg.reference_time >= 0)
+            dccl.set_reference_time(cfg.reference_time);
 
         if(cfg.dlopen.size() > 1)
         {
@@ -149,21 +502,51 @@ int main(int argc, char* argv[])
             }
         }
 
-        // Load up all the messages
+        // Load up all the messages, validating them in parallel
+        std::vector<const google::protobuf::Descriptor*> descs;
         for(std::set<std::string>::const_iterator it = cfg.message.begin(),
                 end = cfg.message.end(); it != end; ++it)   
         {
             const google::protobuf::Descriptor* desc = 
                 dccl::DynamicProtobufManager::find_descriptor(*it);
-            load_desc(&dccl, desc, *it);
+            if(!desc)
+            {
+                std::cerr << "No descriptor with name " << *it << " found! Make sure you have loaded all the necessary .proto files and/or shared libraries. Try --help." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            descs.push_back(desc);
+        }
+        
+        try { dccl.load_all(descs); }
+        catch(std::exception& e)
+        {
+            std::cerr << "Not a valid DCCL message: " << e.what() << std::endl;
         }
 
+        // the arithmetic codec's models (which may adapt to each message coded) are shared by every Codec
+        // in the process without synchronization, so those messages can only be coded on one thread
+        if(cfg.threads > 1)
+        {
+            std::set<const google::protobuf::Descriptor*> visited;
+            for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), n = dccl.loaded().end(); it != n; ++it)
+            {
+                if(uses_arithmetic_codec(it->second, &visited))
+                {
+                    std::cerr << "Warning: " << it->second->full_name() << " uses the arithmetic codec, which cannot be used from more than one thread. Ignoring --threads." << std::endl;
+                    cfg.threads = 1;
+                    break;
+                }
+            }
+        }
+        
         switch(cfg.action)
         {
             case ENCODE: encode(dccl, cfg); break;
             case DECODE: decode(dccl, cfg); break;
             case ANALYZE: analyze(dccl, cfg); break;
             case DISP_PROTO: disp_proto(dccl, cfg); break;
+            case BENCHMARK: benchmark(dccl, cfg); break;
+            case GENERATE: generate(dccl, cfg); break;
             default:
                 std::cerr << "No action specified (e.g. analyze, decode, encode). Try --help." << std::endl;
                 exit(EXIT_SUCCESS);
@@ -174,11 +557,134 @@ int main(int argc, char* argv[])
 
 
 
+bool uses_arithmetic_codec(const google::protobuf::Descriptor* desc, std::set<const google::protobuf::Descriptor*>* visited)
+{
+    if(!visited->insert(desc).second)
+        return false;
+    
+    const dccl::DCCLMessageOptions& msg_options = desc->options().GetExtension(dccl::msg);
+    bool has_codec_group = msg_options.has_codec_group() || msg_options.has_codec_version();
+    std::string codec_group = dccl::FieldCodecBase::codec_group(desc);
+    for(int i = 0, n = desc->field_count(); i < n; ++i)
+    {
+        const google::protobuf::FieldDescriptor* field = desc->field(i);
+        // e.g. "_arithmetic" or "dccl.arithmetic"
+        if(dccl::FieldCodecManager::find(field, has_codec_group, codec_group)->name().find("arithmetic") != std::string::npos)
+            return true;
+        if(field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE &&
+           uses_arithmetic_codec(field->message_type(), visited))
+            return true;
+    }
+    return false;
+}
+
 void analyze(dccl::Codec& dccl, const dccl::tool::Config& cfg)
 {
     dccl.info_all(&std::cout);
+
+    if(cfg.profile)
+    {
+        // profile encoding, sizing and decoding generated messages 
+        dccl::MessageGenerator generator(cfg.seed);
+        generator.set_worst_case(cfg.worst_case);
+
+        dccl.reset_profile();
+        dccl.set_profiling(true);
+        std::string bytes;
+        for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), end = dccl.loaded().end(); it != end; ++it)
+        {
+            boost::shared_ptr<google::protobuf::Message> decoded = dccl::DynamicProtobufManager::new_protobuf_message(it->second);
+            for(unsigned i = 0; i < cfg.count; ++i)
+            {
+                boost::shared_ptr<google::protobuf::Message> msg = generator.generate(it->second);
+                bytes.clear();
+                dccl.encode(&bytes, *msg);
+                dccl.size(*msg);
+                decoded->Clear();
+                dccl.decode(bytes, decoded.get());
+            }
+        }
+        dccl.set_profiling(false);
+        
+        std::cout << "Profile of encoding, sizing and decoding " << cfg.count << " generated messages of each type:" << std::endl;
+        dccl.write_profile(&std::cout);
+    }
+}
+
+// encoded message in the output format (including the trailing newline for text formats)
+void format_encoded(const std::string& encoded, Format format, std::string* output)
+{
+    switch(format)
+    {
+        default:
+        case BINARY:
+            *output = encoded;
+            break;
+
+        case FRAMED:
+            output->clear();
+            dccl::tool::append_varint(output, encoded.size());
+            *output += encoded;
+            break;
+            
+        case TEXTFORMAT:
+        {
+            dccl::tool::protobuf::ByteString s;
+            s.set_b(encoded);
+            google::protobuf::TextFormat::PrintFieldValueToString(s, s.GetDescriptor()->FindFieldByNumber(1), -1, output);
+            *output += "\n";
+            break;
+        }
+                
+        case HEX:
+            *output = dccl::hex_encode(encoded) + "\n";
+            break;
+
+        case BASE64:
+#if DCCL_HAS_B64
+            std::stringstream instream(encoded);
+            std::stringstream outstream;
+            ::base64::encoder D;
+            D.encode(instream, outstream);
+            *output = outstream.str();
+#else
+            std::cerr << "dccl was not compiled with libb64-dev, so no Base64 functionality is available." << std::endl;
+            exit(EXIT_FAILURE);
+#endif
+            break;
+    }
 }
 
+class EncodeWorker : public dccl::tool::BatchWorker
+{
+  public:
+    EncodeWorker(dccl::tool::CodecPool& codecs, Format format)
+        : codecs_(codecs), format_(format)
+    { }
+    
+    void process(unsigned thread, std::size_t i)
+    {
+        boost::shared_ptr<google::protobuf::Message> msg = dccl::DynamicProtobufManager::new_protobuf_message(descs[i]);
+        google::protobuf::TextFormat::ParseFromString(inputs[i], msg.get());
+
+        outputs[i].clear();
+        if(msg->IsInitialized())
+        {
+            std::string encoded;
+            codecs_[thread].encode(&encoded, *msg);
+            format_encoded(encoded, format_, &outputs[i]);
+        }
+    }
+
+    std::vector<const google::protobuf::Descriptor*> descs;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    
+  private:
+    dccl::tool::CodecPool& codecs_;
+    Format format_;
+};
+
 void encode(dccl::Codec& dccl, dccl::tool::Config& cfg)
 {
     if(cfg.message.size() > 1)
@@ -193,134 +699,154 @@ void encode(dccl::Codec& dccl, dccl::tool::Config& cfg)
     }
     
     std::string command_line_name = *cfg.message.begin();
-    
-    while(!std::cin.eof())
-    {
-        std::string input;
-        std::getline (std::cin, input);
 
-        boost::trim(input);
-        if(input.empty())
-            continue;
+    dccl::tool::CodecPool codecs(&dccl, cfg);
+    dccl::tool::LineReader reader(cfg.input);
+    dccl::tool::OutputBuffer output;
+    EncodeWorker worker(codecs, cfg.format);
 
-        std::string name;
-        if(input[0] == '|')
+    // when typing at a terminal, encode each line as it is entered
+    const bool interactive = cfg.input.empty() && isatty(STDIN_FILENO);
+    const std::size_t batch_size = interactive ? 1 : BATCH_RECORDS_PER_THREAD * cfg.threads;
+    
+    std::string input;
+    bool more_input = true;
+    while(more_input)
+    {
+        worker.descs.clear();
+        worker.inputs.clear();
+        while(worker.inputs.size() < batch_size && (more_input = reader.getline(&input)))
         {
-            std::string::size_type close_bracket_pos = input.find('|', 1);
-            if(close_bracket_pos == std::string::npos)
-            {
-                std::cerr << "Incorrectly formatted input: expected '|'" << std::endl;
-                exit(EXIT_FAILURE);
-            }
+            boost::trim(input);
+            if(input.empty())
+                continue;
 
-            name = input.substr(1, close_bracket_pos-1);
-            if(cfg.message.find(name) == cfg.message.end())
+            std::string name;
+            if(input[0] == '|')
             {
-                const google::protobuf::Descriptor* desc = 
-                    dccl::DynamicProtobufManager::find_descriptor(name);
-                load_desc(&dccl, desc, name);
-                cfg.message.insert(name);
-            }
-            
+                std::string::size_type close_bracket_pos = input.find('|', 1);
+                if(close_bracket_pos == std::string::npos)
+                {
+                    std::cerr << "Incorrectly formatted input: expected '|'" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                name = input.substr(1, close_bracket_pos-1);
+                if(cfg.message.find(name) == cfg.message.end())
+                {
+                    const google::protobuf::Descriptor* desc = 
+                        dccl::DynamicProtobufManager::find_descriptor(name);
+                    codecs.load(desc, name);
+                    cfg.message.insert(name);
+                }
             
-            if(input.size() > close_bracket_pos+1)
-                input = input.substr(close_bracket_pos+1);
+                if(input.size() > close_bracket_pos+1)
+                    input = input.substr(close_bracket_pos+1);
+                else
+                    input.clear();
+            }
             else
-                input.clear();
-        }
-        else
-        {
-            if(cfg.message.size() == 0)
             {
-                std::cerr << "Message name not given with -m or in the input (i.e. '[Name] field1: value field2: value')." << std::endl;
-                exit(EXIT_FAILURE);
-            }
+                if(cfg.message.size() == 0)
+                {
+                    std::cerr << "Message name not given with -m or in the input (i.e. '[Name] field1: value field2: value')." << std::endl;
+                    exit(EXIT_FAILURE);
+                }
                 
-            name = command_line_name;
-        }
+                name = command_line_name;
+            }
         
-        const google::protobuf::Descriptor* desc = dccl::DynamicProtobufManager::find_descriptor(name);
-        if(desc == 0)
-        {
-            std::cerr << "No descriptor with name " << name << " found! Make sure you have loaded all the necessary .proto files and/or shared libraries. Also make sure you specified the fully qualified name including the package, if any (e.g. 'goby.acomms.protobuf.NetworkAck', not just 'NetworkAck')." << std::endl;
-            exit(EXIT_FAILURE);
+            const google::protobuf::Descriptor* desc = dccl::DynamicProtobufManager::find_descriptor(name);
+            if(desc == 0)
+            {
+                std::cerr << "No descriptor with name " << name << " found! Make sure you have loaded all the necessary .proto files and/or shared libraries. Also make sure you specified the fully qualified name including the package, if any (e.g. 'goby.acomms.protobuf.NetworkAck', not just 'NetworkAck')." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            worker.descs.push_back(desc);
+            worker.inputs.push_back(input);
         }
-        
-        
-        boost::shared_ptr<google::protobuf::Message> msg = dccl::DynamicProtobufManager::new_protobuf_message(desc);
-        google::protobuf::TextFormat::ParseFromString(input, msg.get());
 
-        if(msg->IsInitialized())
+        worker.outputs.resize(worker.inputs.size());
+        worker.run(worker.inputs.size(), cfg.threads);
+        for(std::size_t i = 0, n = worker.outputs.size(); i < n; ++i)
         {
-            std::string encoded;
-            dccl.encode(&encoded, *msg);
-            switch(cfg.format)
+            if(!worker.errors[i].empty())
             {
-                default:
-                case BINARY:                    
-                {    
-                    std::ofstream fout("/dev/stdout", std::ios::binary | std::ios::app);
-                    fout.write(encoded.data(), encoded.size()); 
-                    break;
-                }
-                
-                case TEXTFORMAT:
-                {
-                    
-                    dccl::tool::protobuf::ByteString s;
-                    s.set_b(encoded);
-                    std::string output;
-                    google::protobuf::TextFormat::PrintFieldValueToString(s, s.GetDescriptor()->FindFieldByNumber(1), -1, &output);
-
-                    std::cout << output << std::endl;
-                    break;
-                }
-                
-                case HEX:
-                    std::cout << dccl::hex_encode(encoded) << std::endl;
-                    break;
-                case BASE64:
-#if DCCL_HAS_B64
-                    std::stringstream instream(encoded);
-                    std::stringstream outstream;
-                    ::base64::encoder D;
-                    D.encode(instream, outstream);
-                    std::cout << outstream.str();
-#else
-                    std::cerr << "dccl was not compiled with libb64-dev, so no Base64 functionality is available." << std::endl;
-                    exit(EXIT_FAILURE);
-#endif
-                    break;
+                std::cerr << "Failed to encode message: " << worker.errors[i] << std::endl;
+                exit(EXIT_FAILURE);
             }
-        
+            output.append(worker.outputs[i]);
         }
+        
+        if(interactive)
+            output.flush();
     }    
 }
 
+class DecodeWorker : public dccl::tool::BatchWorker
+{
+  public:
+    DecodeWorker(dccl::tool::CodecPool& codecs, bool omit_prefix)
+        : codecs_(codecs), omit_prefix_(omit_prefix)
+    { }
+
+    void process(unsigned thread, std::size_t i)
+    {
+        decode_one(codecs_[thread], frames[i].first, frames[i].second, omit_prefix_, &outputs[i]);
+    }
+
+    // decodes the message starting at begin as one output line, returning the end of the message
+    static const char* decode_one(dccl::Codec& codec, const char* begin, const char* end, bool omit_prefix, std::string* output)
+    {
+        const std::map<dccl::int32, const google::protobuf::Descriptor*>& loaded = codec.loaded();
+        unsigned id = codec.id(begin, end);
+        if(!loaded.count(id))
+            throw(dccl::Exception("Message id " + boost::lexical_cast<std::string>(id) + " has not been loaded."));
+            
+        boost::shared_ptr<google::protobuf::Message> msg = dccl::DynamicProtobufManager::new_protobuf_message(loaded.find(id)->second);
+        const char* msg_end = codec.decode(begin, end, msg.get());
+
+        output->clear();
+        if(!omit_prefix)
+            *output += "|" + msg->GetDescriptor()->full_name() + "| ";
+        *output += msg->ShortDebugString() + "\n";
+        return msg_end;
+    }
+    
+    std::vector<std::pair<const char*, const char*> > frames;
+    std::vector<std::string> outputs;
+
+  private:
+    dccl::tool::CodecPool& codecs_;
+    bool omit_prefix_;
+};
+
 void decode(dccl::Codec& dccl, const dccl::tool::Config& cfg)
 {
-    std::string input;
-    if(cfg.format == BINARY)
+    boost::shared_ptr<dccl::tool::InputBuffer> binary_input;
+    std::string text_input;
+    const char* begin;
+    const char* end;
+    
+    if(cfg.format == BINARY || cfg.format == FRAMED)
     {
-        std::ifstream fin("/dev/stdin", std::ios::binary);
-        std::ostringstream ostrm;
-        ostrm << fin.rdbuf();
-        input = ostrm.str();
+        binary_input.reset(new dccl::tool::InputBuffer(cfg.input));
+        begin = binary_input->begin();
+        end = binary_input->end();
     }
     else
     {
-        while(!std::cin.eof())
+        dccl::tool::LineReader reader(cfg.input);
+        std::string line;
+        while(reader.getline(&line))
         {
-            std::string line;
-            std::getline (std::cin, line);
-            
             if(boost::trim_copy(line).empty())
                 continue;
             
             switch(cfg.format)
             {
                 default:
-                case BINARY:
                     break;
                     
                 case TEXTFORMAT:
@@ -330,11 +856,11 @@ void decode(dccl::Codec& dccl, const dccl::tool::Config& cfg)
                     
                     dccl::tool::protobuf::ByteString s;
                     google::protobuf::TextFormat::ParseFieldValueFromString("\"" + line + "\"", s.GetDescriptor()->FindFieldByNumber(1), &s);
-                    input += s.b();
+                    text_input += s.b();
                     break;
                 }
                 case HEX:
-                    input += dccl::hex_decode(line);
+                    text_input += dccl::hex_decode(line);
                     break;
                 case BASE64:
 #if DCCL_HAS_B64
@@ -342,7 +868,7 @@ void decode(dccl::Codec& dccl, const dccl::tool::Config& cfg)
                     std::stringstream outstream;
                     ::base64::decoder D;
                     D.decode(instream, outstream);
-                    input += outstream.str();
+                    text_input += outstream.str();
                     break;
 #else
                     std::cerr << "dccl was not compiled with libb64-dev, so no Base64 functionality is available." << std::endl;
@@ -350,14 +876,286 @@ void decode(dccl::Codec& dccl, const dccl::tool::Config& cfg)
 #endif
             }
         }
+        begin = text_input.data();
+        end = begin + text_input.size();
     }
 
-    while(!input.empty())
+    dccl::tool::OutputBuffer output;
+    std::string line;
+    if(cfg.format != FRAMED && cfg.frame_size == 0)
     {
-        boost::shared_ptr<google::protobuf::Message> msg = dccl.decode<boost::shared_ptr<google::protobuf::Message> >(&input);
-        if(!cfg.omit_prefix)
-            std::cout << "|" << msg->GetDescriptor()->full_name() << "| ";
-        std::cout << msg->ShortDebugString() << std::endl;
+        // no message is longer than the max_size() of its type, so there's no need to pass decode() any more
+        // of the input than that (this keeps decoding a long stream of concatenated messages linear in its length)
+        std::map<dccl::int32, unsigned> max_sizes;
+        for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), n = dccl.loaded().end(); it != n; ++it)
+            max_sizes[it->first] = dccl.max_size(it->second);
+        
+        // the end of each message is only known once it is decoded, so this can't be split among threads
+        while(begin != end)
+        {
+            std::map<dccl::int32, unsigned>::const_iterator max_size_it = max_sizes.find(dccl.id(begin, end));
+            const char* message_end = end;
+            if(max_size_it != max_sizes.end() && end - begin > static_cast<std::ptrdiff_t>(max_size_it->second))
+                message_end = begin + max_size_it->second;
+            
+            begin = DecodeWorker::decode_one(dccl, begin, message_end, cfg.omit_prefix, &line);
+            output.append(line);
+        }
+        return;
+    }
+    
+    dccl::tool::CodecPool codecs(&dccl, cfg);
+    DecodeWorker worker(codecs, cfg.omit_prefix);
+    const std::size_t batch_size = BATCH_RECORDS_PER_THREAD * cfg.threads;
+    while(begin != end)
+    {
+        worker.frames.clear();
+        while(worker.frames.size() < batch_size && begin != end)
+        {
+            std::size_t frame_size = cfg.frame_size;
+            if(frame_size == 0)
+            {
+                if(!dccl::tool::read_varint(&begin, end, &frame_size) ||
+                   frame_size > static_cast<std::size_t>(end - begin))
+                {
+                    std::cerr << "Truncated input: expected a length prefixed (framed) DCCL message" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else if(frame_size > static_cast<std::size_t>(end - begin))
+            {
+                std::cerr << "Truncated input: expected a " << frame_size << " byte frame" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            worker.frames.push_back(std::make_pair(begin, begin + frame_size));
+            begin += frame_size;
+        }
+
+        worker.outputs.resize(worker.frames.size());
+        worker.run(worker.frames.size(), cfg.threads);
+        for(std::size_t i = 0, n = worker.outputs.size(); i < n; ++i)
+        {
+            if(!worker.errors[i].empty())
+            {
+                std::cerr << "Failed to decode message: " << worker.errors[i] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            output.append(worker.outputs[i]);
+        }
+    }
+}
+
+enum BenchmarkOperation { BENCHMARK_ENCODE, BENCHMARK_DECODE, BENCHMARK_SIZE, BENCHMARK_ROUND_TRIP };
+
+void benchmark_operation(dccl::Codec& dccl, BenchmarkOperation operation, const std::string& name,
+                         const std::vector<boost::shared_ptr<google::protobuf::Message> >& msgs,
+                         const std::vector<std::string>& encoded, std::size_t encoded_bytes)
+{
+    boost::shared_ptr<google::protobuf::Message> decoded = dccl::DynamicProtobufManager::new_protobuf_message(msgs.front()->GetDescriptor());
+    std::string bytes;
+
+    // the first pass counts allocations (if built with count_allocations), the rest are timed
+    std::size_t passes = 0;
+#ifdef DCCL_TOOL_COUNT_ALLOCATIONS
+    unsigned long long allocations = 0;
+#endif
+    boost::posix_time::ptime start;
+    boost::posix_time::time_duration elapsed;
+    do
+    {
+        if(passes == 0)
+        {
+#ifdef DCCL_TOOL_COUNT_ALLOCATIONS
+            allocation_count = 0;
+            allocation_counting = true;
+#endif
+        }
+        else if(passes == 1)
+        {
+            start = boost::posix_time::microsec_clock::universal_time();
+        }
+        
+        for(std::size_t i = 0, n = msgs.size(); i < n; ++i)
+        {
+            switch(operation)
+            {
+                case BENCHMARK_ENCODE:
+                    bytes.clear();
+                    dccl.encode(&bytes, *msgs[i]);
+                    break;
+                case BENCHMARK_DECODE:
+                    decoded->Clear();
+                    dccl.decode(encoded[i], decoded.get());
+                    break;
+                case BENCHMARK_SIZE:
+                    dccl.size(*msgs[i]);
+                    break;
+                case BENCHMARK_ROUND_TRIP:
+                    bytes.clear();
+                    dccl.encode(&bytes, *msgs[i]);
+                    decoded->Clear();
+                    dccl.decode(bytes, decoded.get());
+                    break;
+            }
+        }
+
+        if(passes == 0)
+        {
+#ifdef DCCL_TOOL_COUNT_ALLOCATIONS
+            allocation_counting = false;
+            allocations = allocation_count;
+#endif
+        }
+        else
+        {
+            elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+        }
+        ++passes;
+    }
+    while(passes < 2 || elapsed.total_microseconds() < BENCHMARK_MIN_SECONDS * 1e6);
+
+    double seconds = elapsed.total_microseconds() / 1e6;
+    double num_msgs = static_cast<double>(msgs.size()) * (passes - 1);
+    std::cout << "  " << std::left << std::setw(12) << name << std::right << std::fixed
+              << std::setw(14) << std::setprecision(0) << num_msgs / seconds
+              << std::setw(12) << std::setprecision(2) << encoded_bytes * static_cast<double>(passes - 1) / seconds / 1e6
+              << std::setw(12) << std::setprecision(0) << seconds * 1e9 / num_msgs;
+#ifdef DCCL_TOOL_COUNT_ALLOCATIONS
+    std::cout << std::setw(12) << std::setprecision(1) << static_cast<double>(allocations) / msgs.size() << std::endl;
+#else
+    std::cout << std::setw(12) << "-" << std::endl;
+#endif
+}
+
+void benchmark_message(dccl::Codec& dccl, const google::protobuf::Descriptor* desc,
+                       const std::vector<boost::shared_ptr<google::protobuf::Message> >& all_msgs)
+{
+    // only keep the messages that can be encoded
+    std::vector<boost::shared_ptr<google::protobuf::Message> > msgs;
+    std::vector<std::string> encoded;
+    std::vector<std::size_t> sizes;
+    std::size_t encoded_bytes = 0;
+    std::string first_error;
+    for(std::size_t i = 0, n = all_msgs.size(); i < n; ++i)
+    {
+        std::string bytes;
+        try { dccl.encode(&bytes, *all_msgs[i]); }
+        catch(std::exception& e)
+        {
+            if(first_error.empty())
+                first_error = e.what();
+            continue;
+        }
+        msgs.push_back(all_msgs[i]);
+        encoded.push_back(bytes);
+        sizes.push_back(bytes.size());
+        encoded_bytes += bytes.size();
+    }
+    
+    std::cout << "== " << desc->full_name() << " (max size: " << dccl.max_size(desc) << " bytes) ==" << std::endl;
+    std::cout << "  messages: " << msgs.size() << " (" << all_msgs.size() - msgs.size() << " failed to encode)" << std::endl;
+    if(msgs.empty())
+    {
+        std::cout << "  nothing to benchmark: " << first_error << std::endl;
+        return;
+    }
+    
+    std::sort(sizes.begin(), sizes.end());
+    std::cout << "  encoded size (bytes): min " << sizes.front()
+              << ", mean " << std::fixed << std::setprecision(1) << static_cast<double>(encoded_bytes) / sizes.size()
+              << ", p50 " << sizes[sizes.size() / 2]
+              << ", p90 " << sizes[sizes.size() * 9 / 10]
+              << ", p99 " << sizes[sizes.size() * 99 / 100]
+              << ", max " << sizes.back() << std::endl;
+    
+    std::cout << "  " << std::left << std::setw(12) << "operation" << std::right
+              << std::setw(14) << "msg/s" << std::setw(12) << "MB/s"
+              << std::setw(12) << "ns/msg" << std::setw(12) << "allocs/msg" << std::endl;
+    benchmark_operation(dccl, BENCHMARK_ENCODE, "encode", msgs, encoded, encoded_bytes);
+    benchmark_operation(dccl, BENCHMARK_DECODE, "decode", msgs, encoded, encoded_bytes);
+    benchmark_operation(dccl, BENCHMARK_SIZE, "size", msgs, encoded, encoded_bytes);
+    benchmark_operation(dccl, BENCHMARK_ROUND_TRIP, "round trip", msgs, encoded, encoded_bytes);
+}
+
+void benchmark(dccl::Codec& dccl, const dccl::tool::Config& cfg)
+{
+    std::cout << "DCCL " << dccl::VERSION_STRING << " benchmark (crypto: "
+              << (cfg.crypto_passphrase.empty() ? "off" : (DCCL_HAS_CRYPTOPP ? "on" : "unavailable, DCCL was compiled without Crypto++"))
+              << ")" << std::endl;
+    
+    std::map<const google::protobuf::Descriptor*, std::vector<boost::shared_ptr<google::protobuf::Message> > > msgs;
+    if(cfg.input.empty())
+    {
+        dccl::MessageGenerator generator(cfg.seed);
+        generator.set_worst_case(cfg.worst_case);
+        for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), end = dccl.loaded().end(); it != end; ++it)
+        {
+            for(unsigned i = 0; i < cfg.count; ++i)
+                msgs[it->second].push_back(generator.generate(it->second));
+        }
+    }
+    else
+    {
+        dccl::tool::LineReader reader(cfg.input);
+        std::string input;
+        while(reader.getline(&input))
+        {
+            boost::trim(input);
+            if(input.empty())
+                continue;
+
+            std::string name;
+            if(input[0] == '|' && input.find('|', 1) != std::string::npos)
+            {
+                std::string::size_type close_bracket_pos = input.find('|', 1);
+                name = input.substr(1, close_bracket_pos-1);
+                input = input.substr(close_bracket_pos+1);
+            }
+            else if(cfg.message.size() == 1)
+            {
+                name = *cfg.message.begin();
+            }
+            else
+            {
+                std::cerr << "Message name not given in the input (i.e. '|Name| field1: value field2: value') and more than one message given with -m" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            const google::protobuf::Descriptor* desc = dccl::DynamicProtobufManager::find_descriptor(name);
+            if(!desc || !cfg.message.count(name))
+            {
+                std::cerr << "Message " << name << " was not loaded with -m" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            
+            boost::shared_ptr<google::protobuf::Message> msg = dccl::DynamicProtobufManager::new_protobuf_message(desc);
+            google::protobuf::TextFormat::ParseFromString(input, msg.get());
+            msgs[desc].push_back(msg);
+        }
+    }
+
+    for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), end = dccl.loaded().end(); it != end; ++it)
+    {
+        if(msgs.count(it->second))
+            benchmark_message(dccl, it->second, msgs[it->second]);
+    }
+}
+
+void generate(dccl::Codec& dccl, const dccl::tool::Config& cfg)
+{
+    dccl::MessageGenerator generator(cfg.seed);
+    generator.set_worst_case(cfg.worst_case);
+    
+    dccl::tool::OutputBuffer output;
+    for(std::map<dccl::int32, const google::protobuf::Descriptor*>::const_iterator it = dccl.loaded().begin(), end = dccl.loaded().end(); it != end; ++it)
+    {
+        for(unsigned i = 0; i < cfg.count; ++i)
+        {
+            boost::shared_ptr<google::protobuf::Message> msg = generator.generate(it->second);
+            if(!cfg.omit_prefix)
+                output.append("|" + it->second->full_name() + "| ");
+            output.append(msg->ShortDebugString() + "\n");
+        }
     }
 }
 
@@ -400,14 +1198,26 @@ void parse_options(int argc, char* argv[], dccl::tool::Config* cfg)
     options.push_back(dccl::Option('d', "decode", no_argument, "Decode a DCCL message to STDOUT from STDIN"));
     options.push_back(dccl::Option('a', "analyze", no_argument, "Provides information on a given DCCL message definition (e.g. field sizes)"));
     options.push_back(dccl::Option('p', "display_proto", no_argument, "Display the .proto definition of this message."));
+    options.push_back(dccl::Option('b', "benchmark", no_argument, "Measure encode, decode, size and round trip throughput for the given messages, using randomly generated messages (or those read from --input, in the same format as for encode)."));
     options.push_back(dccl::Option('h', "help", no_argument, "Gives help on the usage of 'dccl'"));
     options.push_back(dccl::Option('I', "proto_path", required_argument, "Add another search directory for .proto files"));
     options.push_back(dccl::Option('l', "dlopen", required_argument, "Open this shared library containing compiled DCCL messages."));
     options.push_back(dccl::Option('m', "message", required_argument, "Message name to encode, decode or analyze."));
     options.push_back(dccl::Option('f', "proto_file", required_argument, ".proto file to load."));
-    options.push_back(dccl::Option(0, "format", required_argument, "Format for encode output or decode input: 'bin' (default) is raw binary, 'hex' is ascii-encoded hexadecimal, 'textformat' is a Google Protobuf TextFormat byte string, 'base64' is ascii-encoded base 64."));
+    options.push_back(dccl::Option(0, "proto_cache", required_argument, "Directory for caching the parsed .proto files given with -f, so that later runs start faster."));
+    options.push_back(dccl::Option(0, "format", required_argument, "Format for encode output or decode input: 'bin' (default) is raw binary, 'framed' is binary with each message preceded by its length in bytes (as a base 128 varint, like Protobuf), 'hex' is ascii-encoded hexadecimal, 'textformat' is a Google Protobuf TextFormat byte string, 'base64' is ascii-encoded base 64."));
+    options.push_back(dccl::Option(0, "input", required_argument, "Read input for encode or decode from this file (memory mapped) instead of STDIN."));
+    options.push_back(dccl::Option(0, "threads", required_argument, "Number of threads to encode with, or decode 'framed' or --frame_size input with (output order is preserved). Ignored if any message uses the arithmetic codec, whose models are shared between threads. Default is 1."));
+    options.push_back(dccl::Option(0, "frame_size", required_argument, "Decode the input as a sequence of frames of this many bytes each (e.g. 32 for the legacy CCL messages loaded with -l libdccl_ccl_compat.so), so that it can be split among --threads."));
+    options.push_back(dccl::Option('g', "generate", no_argument, "Write randomly generated messages of the given types (honoring the DCCL field bounds) to STDOUT, in the input format of encode."));
+    options.push_back(dccl::Option('n', "count", required_argument, "Number of messages of each type to generate for --generate or --benchmark. Default is 1000."));
+    options.push_back(dccl::Option(0, "seed", required_argument, "Random seed for --generate or --benchmark (the same seed gives the same messages). Default is 1."));
+    options.push_back(dccl::Option(0, "profile", no_argument, "With --analyze, also encodes, sizes and decodes --count generated messages of each type and shows the average bits and time of each field."));
+    options.push_back(dccl::Option(0, "worst_case", no_argument, "Only generate the largest messages for --generate or --benchmark (all optional fields set, strings and repeated fields of the maximum length)."));
+    options.push_back(dccl::Option(0, "reference_time", required_argument, "Decode time of day fields (e.g. dccl.time2) relative to this time (seconds since the UNIX epoch) rather than the current time, such as the time a log being decoded was recorded."));
+    options.push_back(dccl::Option(0, "crypto_passphrase", required_argument, "Encrypt (encode) or decrypt (decode) the message bodies with this passphrase."));
     options.push_back(dccl::Option('v', "verbose", no_argument, "Display extra debugging information."));
-    options.push_back(dccl::Option('o', "omit_prefix", no_argument, "Omit the DCCL type name prefix from the output of decode."));
+    options.push_back(dccl::Option('o', "omit_prefix", no_argument, "Omit the DCCL type name prefix from the output of decode or generate."));
     options.push_back(dccl::Option('i', "id_codec", required_argument, "(Advanced) name for a nonstandard DCCL ID codec to use"));
     options.push_back(dccl::Option('V', "version", no_argument, "DCCL Version"));
     
@@ -439,12 +1249,62 @@ void parse_options(int argc, char* argv[], dccl::tool::Config* cfg)
                         cfg->format = BASE64;
                     else if(!strcmp(optarg, "bin"))
                         cfg->format = BINARY;
+                    else if(!strcmp(optarg, "framed"))
+                        cfg->format = FRAMED;
                     else
                     {
                         std::cerr << "Invalid format '" << optarg << "'" << std::endl;
                         exit(EXIT_FAILURE);
                     }
                 }
+                else if(!strcmp(long_options[option_index].name, "proto_cache"))
+                {
+                    cfg->proto_cache = optarg;
+                }
+                else if(!strcmp(long_options[option_index].name, "input"))
+                {
+                    cfg->input = optarg;
+                }
+                else if(!strcmp(long_options[option_index].name, "threads"))
+                {
+                    int threads = atoi(optarg);
+                    if(threads < 1)
+                    {
+                        std::cerr << "Invalid number of threads '" << optarg << "'" << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    cfg->threads = threads;
+                }
+                else if(!strcmp(long_options[option_index].name, "frame_size"))
+                {
+                    int frame_size = atoi(optarg);
+                    if(frame_size < 1)
+                    {
+                        std::cerr << "Invalid frame size '" << optarg << "'" << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    cfg->frame_size = frame_size;
+                }
+                else if(!strcmp(long_options[option_index].name, "seed"))
+                {
+                    cfg->seed = strtoul(optarg, 0, 10);
+                }
+                else if(!strcmp(long_options[option_index].name, "worst_case"))
+                {
+                    cfg->worst_case = true;
+                }
+                else if(!strcmp(long_options[option_index].name, "profile"))
+                {
+                    cfg->profile = true;
+                }
+                else if(!strcmp(long_options[option_index].name, "reference_time"))
+                {
+                    cfg->reference_time = strtod(optarg, 0);
+                }
+                else if(!strcmp(long_options[option_index].name, "crypto_passphrase"))
+                {
+                    cfg->crypto_passphrase = optarg;
+                }
                 else
                 {
                     std::cerr << "Try --help for valid options." << std::endl;
@@ -457,6 +1317,19 @@ void parse_options(int argc, char* argv[], dccl::tool::Config* cfg)
             case 'd': cfg->action = DECODE; break;
             case 'a': cfg->action = ANALYZE; break;    
             case 'p': cfg->action = DISP_PROTO; break;    
+            case 'b': cfg->action = BENCHMARK; break;    
+            case 'g': cfg->action = GENERATE; break;    
+            case 'n':
+            {
+                int count = atoi(optarg);
+                if(count < 1)
+                {
+                    std::cerr << "Invalid count '" << optarg << "'" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                cfg->count = count;
+                break;
+            }
             case 'I': cfg->include.insert(optarg); break;
             case 'l': cfg->dlopen.push_back(optarg); break;
             case 'm': cfg->message.insert(optarg); break;
@@ -0,0 +1,784 @@
+// Copyright 2014-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     Stephanie Petillo (http://gobysoft.org/index.wt/people/stephanie)
+//                     GobySoft, LLC
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef GenMessageCodecPlugin20261019H
+#define GenMessageCodecPlugin20261019H
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/stubs/common.h>
+
+#include "dccl/binary.h"
+#include "option_extensions.pb.h"
+
+///////////////////////////////////////////////////////////////////////////////////
+// Fields of DCCL messages with their (dccl.field) options folded into constants
+///////////////////////////////////////////////////////////////////////////////////
+
+namespace dccl
+{
+  namespace codegen
+  {
+    /// A field encoded by one of the default codecs (numeric, bool, enum; optionally string and bytes) of the v3 DefaultMessageCodec
+    struct FixedField
+    {
+      enum Kind { NUMERIC, BOOL, ENUM, STRING, BYTES };
+
+      const google::protobuf::FieldDescriptor* field;
+      Kind kind;
+      // C++ type that the value is encoded from (the field type, or dccl::int32 for enumerations)
+      std::string wire_type;
+      double min;
+      double max;
+      int precision;
+      // reserves the value 0 for "not set" (singular fields that are not `required`)
+      bool has_null;
+      // bits for a single value (largest and smallest, which only differ for STRING and optional BYTES)
+      unsigned bits;
+      unsigned min_bits;
+      // (dccl.field).max_length for STRING and BYTES
+      unsigned max_length;
+      // for `repeated` fields
+      unsigned max_repeat;
+      unsigned repeat_bits;
+      bool in_head;
+    };
+
+    inline std::string cpp_namespace(const google::protobuf::FileDescriptor* file)
+    {
+      std::string ns = "::";
+      const std::string& package = file->package();
+      for(std::string::size_type i = 0; i < package.size(); ++i)
+        ns += (package[i] == '.') ? std::string("::") : std::string(1, package[i]);
+      return package.empty() ? ns : ns + "::";
+    }
+
+    // nested types are named Outer_Inner by the protobuf C++ generator
+    inline std::string cpp_nested_name(const std::string& full_name, const std::string& package)
+    {
+      std::string name = package.empty() ? full_name : full_name.substr(package.size() + 1);
+      for(std::string::size_type i = 0; i < name.size(); ++i)
+        if(name[i] == '.') name[i] = '_';
+      return name;
+    }
+
+    /// Unqualified name of the generated class for desc (e.g. Outer_Inner)
+    inline std::string cpp_class_name(const google::protobuf::Descriptor* desc)
+    { return cpp_nested_name(desc->full_name(), desc->file()->package()); }
+
+    /// Fully qualified name of the generated class for desc (e.g. ::pkg::Outer_Inner)
+    inline std::string cpp_qualified_name(const google::protobuf::Descriptor* desc)
+    { return cpp_namespace(desc->file()) + cpp_class_name(desc); }
+
+    inline std::string cpp_qualified_name(const google::protobuf::EnumDescriptor* desc)
+    { return cpp_namespace(desc->file()) + cpp_nested_name(desc->full_name(), desc->file()->package()); }
+
+    /// Name of the generated accessors for field (lowercased, with a trailing underscore for C++ keywords)
+    inline std::string cpp_field_name(const google::protobuf::FieldDescriptor* field)
+    {
+      static const char* keywords[] = {
+        "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+        "class", "compl", "const", "const_cast", "continue", "default", "delete", "do", "double",
+        "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+        "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "not",
+        "not_eq", "operator", "or", "or_eq", "private", "protected", "public", "register",
+        "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_cast",
+        "struct", "switch", "template", "this", "throw", "true", "try", "typedef", "typeid",
+        "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+        "while", "xor", "xor_eq" };
+      static const std::set<std::string> keyword_set(keywords, keywords + sizeof(keywords)/sizeof(keywords[0]));
+
+      std::string name = field->name();
+      for(std::string::size_type i = 0; i < name.size(); ++i)
+        if(name[i] >= 'A' && name[i] <= 'Z') name[i] += 'a' - 'A';
+      return keyword_set.count(name) ? name + "_" : name;
+    }
+
+    /// A double literal that reads back as exactly d
+    inline std::string double_literal(double d)
+    {
+      std::stringstream ss;
+      ss << std::setprecision(std::numeric_limits<double>::digits10 + 2) << d;
+      std::string s = ss.str();
+      if(s.find_first_of(".e") == std::string::npos)
+        s += ".0";
+      return s;
+    }
+
+    /// The effective codec name (group) of a message, as found by FieldCodecManager for a root message
+    inline std::string message_codec_name(const google::protobuf::Descriptor* desc)
+    {
+      const dccl::DCCLMessageOptions& options = desc->options().GetExtension(dccl::msg);
+      if(options.has_codec())
+        return options.codec();
+      else if(options.has_codec_group())
+        return options.codec_group();
+      else
+      {
+        std::stringstream name;
+        name << "dccl.default" << options.codec_version();
+        return name.str();
+      }
+    }
+
+    /// Fold the (dccl.field) options of every field of desc into fields (in encoding order, omitted fields removed).
+    ///
+    /// \param strings Also accept (non-repeated) string and bytes fields
+    /// \return true if every field is encoded by one of the fixed size v3 default codecs (or the string and bytes codecs), otherwise false (with the first unsupported feature in *reason)
+    inline bool fixed_fields(const google::protobuf::Descriptor* desc, std::vector<FixedField>* fields, std::string* reason, bool strings = false)
+    {
+      using google::protobuf::FieldDescriptor;
+
+      const dccl::DCCLMessageOptions& msg_options = desc->options().GetExtension(dccl::msg);
+#if GOOGLE_PROTOBUF_VERSION >= 3000000
+      // the generated has_ accessors only match the presence used by DefaultMessageCodec for proto2
+      if(desc->file()->syntax() != google::protobuf::FileDescriptor::SYNTAX_PROTO2)
+      { *reason = "only proto2 messages are supported"; return false; }
+#endif
+      if(!msg_options.has_id())
+      { *reason = "not a DCCL message (no (dccl.msg).id)"; return false; }
+      if(msg_options.codec_version() != 3 || message_codec_name(desc) != "dccl.default3")
+      { *reason = "only messages using the dccl.default3 codecs are supported"; return false; }
+
+      for(int i = 0, n = desc->field_count(); i < n; ++i)
+      {
+        const FieldDescriptor* field = desc->field(i);
+        const dccl::DCCLFieldOptions& options = field->options().GetExtension(dccl::field);
+        if(options.omit())
+          continue;
+
+        if(options.has_codec() && options.codec() != "dccl.default3")
+        { *reason = field->name() + ": uses (dccl.field).codec = \"" + options.codec() + "\""; return false; }
+        if(field->is_repeated() && !options.has_max_repeat())
+        { *reason = field->name() + ": missing (dccl.field).max_repeat"; return false; }
+
+        FixedField f;
+        f.field = field;
+        f.min = options.min();
+        f.max = options.max();
+        f.precision = options.precision();
+        f.has_null = !field->is_required() && !field->is_repeated();
+        f.max_repeat = field->is_repeated() ? options.max_repeat() : 1;
+        f.repeat_bits = field->is_repeated() ? dccl::ceil_log2(options.max_repeat() + 1) : 0;
+        f.in_head = options.in_head();
+        f.max_length = options.max_length();
+
+        switch(field->cpp_type())
+        {
+          case FieldDescriptor::CPPTYPE_INT32: f.kind = FixedField::NUMERIC; f.wire_type = "dccl::int32"; break;
+          case FieldDescriptor::CPPTYPE_INT64: f.kind = FixedField::NUMERIC; f.wire_type = "dccl::int64"; break;
+          case FieldDescriptor::CPPTYPE_UINT32: f.kind = FixedField::NUMERIC; f.wire_type = "dccl::uint32"; break;
+          case FieldDescriptor::CPPTYPE_UINT64: f.kind = FixedField::NUMERIC; f.wire_type = "dccl::uint64"; break;
+          case FieldDescriptor::CPPTYPE_DOUBLE: f.kind = FixedField::NUMERIC; f.wire_type = "double"; break;
+          case FieldDescriptor::CPPTYPE_FLOAT: f.kind = FixedField::NUMERIC; f.wire_type = "float"; break;
+          case FieldDescriptor::CPPTYPE_BOOL: f.kind = FixedField::BOOL; f.wire_type = "bool"; break;
+          case FieldDescriptor::CPPTYPE_ENUM:
+          {
+            // as v3::DefaultEnumCodec: encodes the index (packed_enum, the default) or the value
+            f.kind = FixedField::ENUM;
+            f.wire_type = "dccl::int32";
+            const google::protobuf::EnumDescriptor* e = field->enum_type();
+            if(options.packed_enum())
+            {
+              f.min = 0;
+              f.max = e->value_count() - 1;
+            }
+            else
+            {
+              f.min = f.max = e->value(0)->number();
+              for(int j = 1, m = e->value_count(); j < m; ++j)
+              {
+                f.min = std::min<double>(f.min, e->value(j)->number());
+                f.max = std::max<double>(f.max, e->value(j)->number());
+              }
+            }
+            break;
+          }
+          case FieldDescriptor::CPPTYPE_STRING:
+          {
+            if(!strings || field->is_repeated())
+            { *reason = field->name() + ": type " + field->type_name() + (strings ? " (repeated)" : "") + " is not supported"; return false; }
+            if(!options.has_max_length())
+            { *reason = field->name() + ": missing (dccl.field).max_length"; return false; }
+            f.kind = (field->type() == FieldDescriptor::TYPE_BYTES) ? FixedField::BYTES : FixedField::STRING;
+            f.wire_type = "char";
+            break;
+          }
+          default:
+            *reason = field->name() + ": type " + field->type_name() + " is not supported";
+            return false;
+        }
+
+        if(f.kind == FixedField::STRING)
+        {
+          // v3::DefaultStringCodec: the length, then the characters
+          f.min_bits = dccl::ceil_log2(f.max_length + 1);
+          f.bits = f.min_bits + f.max_length * BITS_IN_BYTE;
+        }
+        else if(f.kind == FixedField::BYTES)
+        {
+          // v3::DefaultBytesCodec: all max_length bytes, after a presence bit unless required
+          f.bits = f.max_length * BITS_IN_BYTE + (f.has_null ? 1 : 0);
+          f.min_bits = f.has_null ? 1 : f.bits;
+        }
+        else if(f.kind == FixedField::BOOL)
+        {
+          f.bits = f.min_bits = dccl::ceil_log2(2 + (f.has_null ? 1 : 0));
+        }
+        else
+        {
+          if(f.kind == FixedField::NUMERIC && (!options.has_min() || !options.has_max()))
+          { *reason = field->name() + ": missing (dccl.field).min or (dccl.field).max"; return false; }
+          f.bits = dccl::ceil_log2((f.max - f.min) * std::pow(10.0, f.precision) + 1 + (f.has_null ? 1 : 0));
+          if(f.bits > 64)
+          { *reason = field->name() + ": more than 64 bits"; return false; }
+          f.min_bits = f.bits;
+        }
+
+        // as FieldCodecBase::field_validate
+        if(f.in_head && (field->is_repeated() || f.min_bits != f.bits))
+        { *reason = field->name() + ": variable size field in the head"; return false; }
+        fields->push_back(f);
+      }
+      return true;
+    }
+
+    /// Total bits of the fields in the head (in_head = true) or body, counting `repeated` fields as empty (min) or full (max)
+    inline unsigned fixed_fields_size(const std::vector<FixedField>& fields, bool in_head, bool max)
+    {
+      unsigned bits = 0;
+      for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+      {
+        if(it->in_head != in_head)
+          continue;
+        if(it->field->is_repeated())
+          bits += it->repeat_bits + (max ? it->bits * it->max_repeat : 0);
+        else
+          bits += max ? it->bits : it->min_bits;
+      }
+      return bits;
+    }
+
+    /// Bits written for id by dccl::DefaultIdentifierCodec (one byte up to 127, otherwise two bytes)
+    inline unsigned default_id_bits(unsigned id)
+    { return (id <= (1 << 7) - 1) ? BITS_IN_BYTE : 2 * BITS_IN_BYTE; }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Print message codec plugin pieces to some type of ostream
+///////////////////////////////////////////////////////////////////////////////////
+
+// scaling by 10^precision as DefaultNumericFieldCodec, with the power folded into a literal
+inline void construct_scale(const dccl::codegen::FixedField& f, bool encode, const std::string& indent, std::ostream& os)
+{
+  if(f.precision == 0)
+    return;
+  bool multiply = (f.precision > 0) == encode;
+  os << indent << "value " << (multiply ? "*=" : "/=") << " (" << f.wire_type << ")1e" << std::abs(f.precision) << ";\n";
+}
+
+// the index (packed_enum) or number of the enumeration value `expr`, as v3::DefaultEnumCodec::pre_encode
+inline void construct_enum_wire_value(const dccl::codegen::FixedField& f, const std::string& expr, const std::string& indent, std::ostream& os)
+{
+  if(!f.field->options().GetExtension(dccl::field).packed_enum())
+  {
+    os << indent << "dccl::int32 wire_value = " << expr << ";\n";
+    return;
+  }
+
+  const google::protobuf::EnumDescriptor* e = f.field->enum_type();
+  std::set<int> numbers;
+  os << indent << "dccl::int32 wire_value = 0;\n"
+     << indent << "switch(" << expr << ")\n"
+     << indent << "{\n";
+  for(int i = 0, n = e->value_count(); i < n; ++i)
+  {
+    // aliases share the index of the first value with the number
+    if(numbers.insert(e->value(i)->number()).second)
+      os << indent << "    case " << e->value(i)->number() << ": wire_value = " << i << "; break;\n";
+  }
+  os << indent << "}\n";
+}
+
+// a block that encodes the value `expr` of f and appends it to `bits`, as DefaultNumericFieldCodec::encode (and DefaultBoolCodec)
+inline void construct_encode_value(const dccl::codegen::FixedField& f, const std::string& expr, bool has_null, const std::string& indent, std::ostream& os)
+{
+  using dccl::codegen::double_literal;
+  const std::string null_offset = has_null ? " + 1" : "";
+  os << indent << "{\n";
+  if(f.kind == dccl::codegen::FixedField::BOOL)
+  {
+    os << indent << "    append_bits(bits, " << expr << null_offset << ", " << f.bits << ");\n"
+       << indent << "}\n";
+    return;
+  }
+
+  std::string value = expr;
+  if(f.kind == dccl::codegen::FixedField::ENUM)
+  {
+    construct_enum_wire_value(f, expr, indent + "    ", os);
+    value = "wire_value";
+  }
+  os << indent << "    " << f.wire_type << " value = dccl::round(" << value << ", " << f.precision << ");\n"
+     << indent << "    if(value < " << double_literal(f.min) << " || value > " << double_literal(f.max) << ")\n"
+     << indent << "        out_of_range(bits, " << f.bits << ", " << f.field->number() << ");\n"
+     << indent << "    else\n"
+     << indent << "    {\n"
+     << indent << "        value -= dccl::round((" << f.wire_type << ")" << double_literal(f.min) << ", " << f.precision << ");\n";
+  construct_scale(f, true, indent + "        ", os);
+  os << indent << "        append_bits(bits, boost::numeric_cast<dccl::uint64>(dccl::round(value, 0))" << null_offset << ", " << f.bits << ");\n"
+     << indent << "    }\n"
+     << indent << "}\n";
+}
+
+// stores (store_begin + value + store_end) the enumeration value with the index (packed_enum) or number `value`, ignoring unknown values
+inline void construct_enum_set(const dccl::codegen::FixedField& f, const std::string& store_begin, const std::string& store_end, const std::string& indent, std::ostream& os)
+{
+  const google::protobuf::EnumDescriptor* e = f.field->enum_type();
+  const bool packed = f.field->options().GetExtension(dccl::field).packed_enum();
+  const std::string enum_type = dccl::codegen::cpp_qualified_name(e);
+  std::set<int> numbers;
+  os << indent << "switch(value)\n"
+     << indent << "{\n";
+  for(int i = 0, n = e->value_count(); i < n; ++i)
+  {
+    int number = e->value(i)->number();
+    if(packed)
+      os << indent << "    case " << i << ": " << store_begin << "static_cast<" << enum_type << ">(" << number << ")" << store_end << " break;\n";
+    else if(numbers.insert(number).second)
+      os << indent << "    case " << number << ": " << store_begin << "static_cast<" << enum_type << ">(" << number << ")" << store_end << " break;\n";
+  }
+  os << indent << "    default: break;\n"
+     << indent << "}\n";
+}
+
+// takes a value of f from `bits` and stores it with the statement store_begin + value + store_end (e.g. "msg->set_x(" and ");")
+inline void construct_decode_value(const dccl::codegen::FixedField& f, const std::string& store_begin, const std::string& store_end, bool has_null, const std::string& indent, std::ostream& os)
+{
+  using dccl::codegen::double_literal;
+  os << indent << "{\n"
+     << indent << "    dccl::uint64 encoded = take_bits(bits, " << f.bits << ");\n";
+  std::string inner = indent + "    ";
+  if(has_null)
+  {
+    os << indent << "    if(encoded--)\n"
+       << indent << "    {\n";
+    inner += "    ";
+  }
+
+  if(f.kind == dccl::codegen::FixedField::BOOL)
+  {
+    os << inner << store_begin << "encoded != 0" << store_end << "\n";
+  }
+  else
+  {
+    os << inner << f.wire_type << " value = (" << f.wire_type << ")encoded;\n";
+    construct_scale(f, false, inner, os);
+    os << inner << "value = dccl::round(value + dccl::round((" << f.wire_type << ")" << double_literal(f.min) << ", " << f.precision << "), " << f.precision << ");\n";
+    if(f.kind == dccl::codegen::FixedField::ENUM)
+      construct_enum_set(f, store_begin, store_end, inner, os);
+    else
+      os << inner << store_begin << "value" << store_end << "\n";
+  }
+
+  if(has_null)
+    os << indent << "    }\n";
+  os << indent << "}\n";
+}
+
+inline void construct_encode_field(const dccl::codegen::FixedField& f, const std::string& indent, std::ostream& os)
+{
+  const std::string name = dccl::codegen::cpp_field_name(f.field);
+  os << indent << "// " << f.field->name() << "\n";
+  if(f.field->is_repeated())
+  {
+    os << indent << "check_repeat(msg." << name << "_size(), " << f.max_repeat << ", " << f.field->number() << ");\n"
+       << indent << "append_bits(bits, msg." << name << "_size(), " << f.repeat_bits << ");\n"
+       << indent << "for(int i = 0, n = msg." << name << "_size(); i < n; ++i)\n";
+    construct_encode_value(f, "msg." + name + "(i)", false, indent, os);
+  }
+  else
+  {
+    // required fields may be unset when encoding only the header
+    os << indent << "if(msg.has_" << name << "())\n";
+    construct_encode_value(f, "msg." + name + "()", f.has_null, indent, os);
+    os << indent << "else\n"
+       << indent << "    append_bits(bits, 0, " << f.bits << ");\n";
+  }
+}
+
+inline void construct_decode_field(const dccl::codegen::FixedField& f, const std::string& indent, std::ostream& os)
+{
+  const std::string name = dccl::codegen::cpp_field_name(f.field);
+  os << indent << "// " << f.field->name() << "\n";
+  if(f.field->is_repeated())
+  {
+    os << indent << "for(dccl::uint64 i = 0, n = take_bits(bits, " << f.repeat_bits << "); i < n; ++i)\n";
+    construct_decode_value(f, "msg->add_" + name + "(", ");", false, indent, os);
+  }
+  else
+  {
+    construct_decode_value(f, "msg->set_" + name + "(", ");", f.has_null, indent, os);
+  }
+}
+
+// one of the bodies of the generated encode_fields/decode_fields/size_fields, for the head or body
+inline void construct_message_part(const std::vector<dccl::codegen::FixedField>& fields, bool in_head, const std::string& function, const std::string& indent, std::ostream& os)
+{
+  if(function == "size")
+  {
+    os << indent << "return " << dccl::codegen::fixed_fields_size(fields, in_head, false);
+    for(std::vector<dccl::codegen::FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    {
+      if(it->in_head == in_head && it->field->is_repeated())
+        os << "\n" << indent << "    + " << it->bits << "*std::min(msg." << dccl::codegen::cpp_field_name(it->field) << "_size(), " << it->max_repeat << ")";
+    }
+    os << ";\n";
+    return;
+  }
+
+  for(std::vector<dccl::codegen::FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+  {
+    if(it->in_head != in_head)
+      continue;
+    if(function == "encode")
+      construct_encode_field(*it, indent, os);
+    else
+      construct_decode_field(*it, indent, os);
+  }
+}
+
+/// Writes a dccl::v3::GeneratedMessageCodec for desc (named ClassName_DCCLCodec) and a static object that registers it with dccl::FieldCodecManager for the lifetime of the program (or shared library).
+inline void construct_message_codec_plugin(const google::protobuf::Descriptor* desc, const std::vector<dccl::codegen::FixedField>& fields, std::ostream& os)
+{
+  const std::string msg_type = dccl::codegen::cpp_qualified_name(desc);
+  const std::string codec = dccl::codegen::cpp_class_name(desc) + "_DCCLCodec";
+  const char* functions[] = { "encode", "decode", "size" };
+  const char* signatures[] = { "void encode_fields(dccl::Bitset* bits, const " , "void decode_fields(dccl::Bitset* bits, ", "unsigned size_fields(const " };
+  const char* arguments[] = { "& msg)", "* msg)", "& msg)" };
+
+  // leave unused parameters unnamed so the generated code builds cleanly with -Wunused-parameter
+  bool has_repeated = false;
+  for(std::vector<dccl::codegen::FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    has_repeated = has_repeated || it->field->is_repeated();
+  if(fields.empty())
+  {
+    signatures[0] = "void encode_fields(dccl::Bitset* /*bits*/, const ";
+    signatures[1] = "void decode_fields(dccl::Bitset* /*bits*/, ";
+    arguments[0] = "& /*msg*/)";
+    arguments[1] = "* /*msg*/)";
+  }
+  if(!has_repeated)
+    arguments[2] = "& /*msg*/)";
+
+  os << "\n"
+     << "// DCCL codec for " << desc->full_name() << ", generated by protoc-gen-dccl from its (dccl.field) options\n"
+     << "namespace\n"
+     << "{\n"
+     << "class " << codec << " : public dccl::v3::GeneratedMessageCodec< " << msg_type << " >\n"
+     << "{\n"
+     << "  private:\n";
+
+  for(int i = 0; i < 3; ++i)
+  {
+    os << "    " << signatures[i] << msg_type << arguments[i] << "\n"
+       << "    {\n"
+       << "        if(part() == dccl::HEAD)\n"
+       << "        {\n";
+    construct_message_part(fields, true, functions[i], "            ", os);
+    os << "        }\n"
+       << "        else\n"
+       << "        {\n";
+    construct_message_part(fields, false, functions[i], "            ", os);
+    os << "        }\n"
+       << "    }\n\n";
+  }
+
+  os << "    unsigned max_size_fields()\n"
+     << "    { return (part() == dccl::HEAD) ? " << dccl::codegen::fixed_fields_size(fields, true, true)
+     << " : " << dccl::codegen::fixed_fields_size(fields, false, true) << "; }\n\n"
+     << "    unsigned min_size_fields()\n"
+     << "    { return (part() == dccl::HEAD) ? " << dccl::codegen::fixed_fields_size(fields, true, false)
+     << " : " << dccl::codegen::fixed_fields_size(fields, false, false) << "; }\n"
+     << "};\n\n"
+     << "struct " << codec << "Registrar\n"
+     << "{\n"
+     << "    " << codec << "Registrar()\n"
+     << "    { dccl::FieldCodecManager::add<" << codec << ">(\"" << dccl::codegen::message_codec_name(desc) << "\", " << msg_type << "::descriptor()); }\n"
+     << "    ~" << codec << "Registrar()\n"
+     << "    { dccl::FieldCodecManager::remove<" << codec << ">(\"" << dccl::codegen::message_codec_name(desc) << "\", " << msg_type << "::descriptor()); }\n"
+     << "} " << codec << "_registrar;\n"
+     << "}\n";
+}
+
+/// Writes (into the class scope of desc) enumerations holding the encoded sizes of desc, and optionally a static_assert that they fit in (dccl.msg).max_bytes (DCCL_MAX_BYTES).
+inline void construct_message_sizes_plugin(const google::protobuf::Descriptor* desc, const std::vector<dccl::codegen::FixedField>& fields, bool static_assert_max_bytes, std::ostream& os)
+{
+  const unsigned id_bits = dccl::codegen::default_id_bits(desc->options().GetExtension(dccl::msg).id());
+  const unsigned head_max_bits = id_bits + dccl::codegen::fixed_fields_size(fields, true, true);
+  const unsigned head_min_bits = id_bits + dccl::codegen::fixed_fields_size(fields, true, false);
+  const unsigned body_max_bits = dccl::codegen::fixed_fields_size(fields, false, true);
+  const unsigned body_min_bits = dccl::codegen::fixed_fields_size(fields, false, false);
+
+  // same arithmetic as dccl::Codec::load() uses to check max_bytes: the head and body are each padded to whole bytes
+  os << "// encoded sizes (with the identifier written by dccl::DefaultIdentifierCodec)\n"
+     << "enum DCCLSizes { DCCL_ID_BITS = " << id_bits << ",\n"
+     << "                 DCCL_HEAD_MAX_BITS = " << head_max_bits << ",\n"
+     << "                 DCCL_HEAD_MIN_BITS = " << head_min_bits << ",\n"
+     << "                 DCCL_BODY_MAX_BITS = " << body_max_bits << ",\n"
+     << "                 DCCL_BODY_MIN_BITS = " << body_min_bits << ",\n"
+     << "                 DCCL_MAX_ENCODED_BYTES = " << dccl::ceil_bits2bytes(head_max_bits) + dccl::ceil_bits2bytes(body_max_bits) << ",\n"
+     << "                 DCCL_MIN_ENCODED_BYTES = " << dccl::ceil_bits2bytes(head_min_bits) + dccl::ceil_bits2bytes(body_min_bits) << " };\n";
+
+  // repeated fields count the size prefix and (dccl.field).max_repeat values
+  os << "// largest encoded size of each field\n"
+     << "enum DCCLFieldBits {";
+  for(std::vector<dccl::codegen::FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+  {
+    const unsigned bits = it->field->is_repeated() ? it->repeat_bits + it->bits * it->max_repeat : it->bits;
+    os << (it == fields.begin() ? " " : ",\n                     ") << "DCCL_BITS_" << it->field->name() << " = " << bits;
+  }
+  os << " };\n";
+
+  if(static_assert_max_bytes)
+  {
+    os << "#if __cplusplus >= 201103L\n"
+       << "static_assert(static_cast<int>(DCCL_MAX_ENCODED_BYTES) <= static_cast<int>(DCCL_MAX_BYTES), \"" << desc->full_name()
+       << ": maximum encoded size exceeds (dccl.msg).max_bytes\");\n"
+       << "#endif\n";
+  }
+}
+
+// C++ type of a (non-string) value of f in the generated struct
+inline std::string struct_value_type(const dccl::codegen::FixedField& f)
+{
+  return (f.kind == dccl::codegen::FixedField::ENUM) ? dccl::codegen::cpp_qualified_name(f.field->enum_type()) : f.wire_type;
+}
+
+// encodes the field f of the struct `msg`, as construct_encode_field does for the protobuf message
+inline void construct_struct_encode_field(const dccl::codegen::FixedField& f, const std::string& struct_name, const std::string& indent, std::ostream& os)
+{
+  using dccl::codegen::FixedField;
+  const std::string name = dccl::codegen::cpp_field_name(f.field);
+  os << indent << "// " << f.field->name() << "\n";
+  if(f.kind == FixedField::STRING || f.kind == FixedField::BYTES)
+  {
+    std::string inner = indent;
+    if(f.has_null)
+    {
+      os << indent << "if(msg.has_" << name << ")\n";
+      inner += "    ";
+    }
+    os << indent << "{\n"
+       << indent << "    const std::size_t length = std::min<std::size_t>(msg." << name << "_size, " << f.max_length << ");\n";
+    if(f.kind == FixedField::STRING)
+    {
+      os << indent << "    append_bits(bits, length, " << f.min_bits << ");\n"
+         << indent << "    append_bytes(bits, msg." << name << ", length);\n"
+         << indent << "}\n";
+      // an unset string is encoded as an empty one
+      if(f.has_null)
+        os << indent << "else\n"
+           << indent << "    append_bits(bits, 0, " << f.min_bits << ");\n";
+    }
+    else
+    {
+      if(f.has_null)
+        os << indent << "    append_bits(bits, 1, 1);\n";
+      os << indent << "    append_bytes(bits, msg." << name << ", length);\n"
+         << indent << "    append_zeros(bits, (" << f.max_length << " - length) * dccl::BITS_IN_BYTE);\n"
+         << indent << "}\n";
+      if(f.has_null)
+        os << indent << "else\n"
+           << indent << "    append_bits(bits, 0, 1);\n";
+    }
+  }
+  else if(f.field->is_repeated())
+  {
+    os << indent << "if(msg." << name << "_size > " << f.max_repeat << ")\n"
+       << indent << "    throw(std::length_error(\"" << struct_name << "::" << name << "_size exceeds (dccl.field).max_repeat\"));\n"
+       << indent << "append_bits(bits, msg." << name << "_size, " << f.repeat_bits << ");\n"
+       << indent << "for(unsigned i = 0; i < msg." << name << "_size; ++i)\n";
+    construct_encode_value(f, "msg." + name + "[i]", false, indent, os);
+  }
+  else if(f.has_null)
+  {
+    os << indent << "if(msg.has_" << name << ")\n";
+    construct_encode_value(f, "msg." + name, true, indent, os);
+    os << indent << "else\n"
+       << indent << "    append_bits(bits, 0, " << f.bits << ");\n";
+  }
+  else
+  {
+    construct_encode_value(f, "msg." + name, false, indent, os);
+  }
+}
+
+// decodes the field f into the struct `msg`, as construct_decode_field does for the protobuf message
+inline void construct_struct_decode_field(const dccl::codegen::FixedField& f, const std::string& struct_name, const std::string& indent, std::ostream& os)
+{
+  using dccl::codegen::FixedField;
+  const std::string name = dccl::codegen::cpp_field_name(f.field);
+  const std::string set_has = f.has_null ? "msg->has_" + name + " = true; " : "";
+  os << indent << "// " << f.field->name() << "\n";
+  if(f.kind == FixedField::STRING)
+  {
+    // as v3::DefaultStringCodec, an empty string is not set
+    os << indent << "{\n"
+       << indent << "    const dccl::uint64 length = take_bits(bits, " << f.min_bits << ");\n"
+       << indent << "    if(length > " << f.max_length << ")\n"
+       << indent << "        throw(dccl::Exception(\"" << struct_name << "::" << name << " is longer than (dccl.field).max_length\"));\n"
+       << indent << "    take_bytes(bits, msg->" << name << ", length);\n"
+       << indent << "    msg->" << name << "_size = static_cast<unsigned>(length);\n";
+    if(f.has_null)
+      os << indent << "    msg->has_" << name << " = (length != 0);\n";
+    os << indent << "}\n";
+  }
+  else if(f.kind == FixedField::BYTES)
+  {
+    if(f.has_null)
+      os << indent << "if(take_bits(bits, 1))\n";
+    os << indent << "{\n"
+       << indent << "    " << set_has << "take_bytes(bits, msg->" << name << ", " << f.max_length << ");\n"
+       << indent << "    msg->" << name << "_size = " << f.max_length << ";\n"
+       << indent << "}\n";
+  }
+  else if(f.field->is_repeated())
+  {
+    os << indent << "{\n"
+       << indent << "    const dccl::uint64 n = take_bits(bits, " << f.repeat_bits << ");\n"
+       << indent << "    if(n > " << f.max_repeat << ")\n"
+       << indent << "        throw(dccl::Exception(\"" << struct_name << "::" << name << " has more than (dccl.field).max_repeat values\"));\n"
+       << indent << "    for(dccl::uint64 i = 0; i < n; ++i)\n";
+    construct_decode_value(f, "msg->" + name + "[msg->" + name + "_size++] = ", ";", false, indent + "    ", os);
+    os << indent << "}\n";
+  }
+  else
+  {
+    construct_decode_value(f, set_has + "msg->" + name + " = ", ";", f.has_null, indent, os);
+  }
+}
+
+/// Writes a plain struct (named ClassName_DCCLStruct) mirroring desc, with encode and decode member functions (defined by construct_message_struct_functions_plugin) that do not use the protobuf message or allocate.
+inline void construct_message_struct_plugin(const google::protobuf::Descriptor* desc, const std::vector<dccl::codegen::FixedField>& fields, std::ostream& os)
+{
+  using dccl::codegen::FixedField;
+  const std::string struct_name = dccl::codegen::cpp_class_name(desc) + "_DCCLStruct";
+  const unsigned id = desc->options().GetExtension(dccl::msg).id();
+  const unsigned id_bits = dccl::codegen::default_id_bits(id);
+  const unsigned head_bytes = dccl::ceil_bits2bytes(id_bits + dccl::codegen::fixed_fields_size(fields, true, true));
+
+  os << "\n"
+     << "// Plain struct for " << desc->full_name() << ", generated by protoc-gen-dccl; encodes to the same bytes as dccl::Codec\n"
+     << "struct " << struct_name << "\n"
+     << "{\n"
+     << "    enum DCCLParameters { DCCL_ID = " << id << ",\n"
+     << "                          DCCL_MAX_ENCODED_BYTES = " << head_bytes + dccl::ceil_bits2bytes(dccl::codegen::fixed_fields_size(fields, false, true)) << ",\n"
+     << "                          DCCL_MIN_ENCODED_BYTES = "
+     << dccl::ceil_bits2bytes(id_bits + dccl::codegen::fixed_fields_size(fields, true, false)) + dccl::ceil_bits2bytes(dccl::codegen::fixed_fields_size(fields, false, false)) << " };\n\n";
+
+  for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+  {
+    const std::string name = dccl::codegen::cpp_field_name(it->field);
+    if(it->has_null)
+      os << "    bool has_" << name << ";\n";
+    if(it->kind == FixedField::STRING || it->kind == FixedField::BYTES)
+      os << "    char " << name << "[" << it->max_length << "];\n"
+         << "    unsigned " << name << "_size;\n";
+    else if(it->field->is_repeated())
+      os << "    " << struct_value_type(*it) << " " << name << "[" << it->max_repeat << "];\n"
+         << "    unsigned " << name << "_size;\n";
+    else
+      os << "    " << struct_value_type(*it) << " " << name << ";\n";
+  }
+
+  os << "\n"
+     << "    /// \\brief Encode as dccl::Codec::encode (not strict, no encryption) into bytes (at least DCCL_MAX_ENCODED_BYTES long)\n"
+     << "    /// \\return number of bytes written\n"
+     << "    /// \\throw std::length_error if max_len is less than the encoded length, or a _size exceeds its array\n"
+     << "    std::size_t encode(char* bytes, std::size_t max_len, bool header_only = false) const;\n"
+     << "    /// \\brief Decode (replacing all fields) as dccl::Codec::decode\n"
+     << "    /// \\return number of bytes consumed\n"
+     << "    /// \\throw dccl::Exception if bytes is not a " << desc->full_name() << " message or is too short\n"
+     << "    std::size_t decode(const char* bytes, std::size_t len, bool header_only = false);\n"
+     << "};\n";
+}
+
+/// Writes the definitions of ClassName_DCCLStruct::encode and ClassName_DCCLStruct::decode for desc.
+inline void construct_message_struct_functions_plugin(const google::protobuf::Descriptor* desc, const std::vector<dccl::codegen::FixedField>& fields, std::ostream& os)
+{
+  using dccl::codegen::FixedField;
+  const std::string struct_name = dccl::codegen::cpp_class_name(desc) + "_DCCLStruct";
+  const unsigned head_bytes = dccl::ceil_bits2bytes(dccl::codegen::default_id_bits(desc->options().GetExtension(dccl::msg).id()) +
+                                                    dccl::codegen::fixed_fields_size(fields, true, true));
+  const std::string indent = "    ";
+
+  os << "\n"
+     << "std::size_t " << struct_name << "::encode(char* bytes, std::size_t max_len, bool header_only) const\n"
+     << "{\n";
+  if(!fields.empty())
+    os << "    const " << struct_name << "& msg = *this;\n";
+  os << "    dccl::v3::StructBitWriter writer(bytes, max_len);\n"
+     << "    dccl::v3::StructBitWriter* bits = &writer;\n"
+     << "    append_id(bits, DCCL_ID);\n";
+  for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    if(it->in_head) construct_struct_encode_field(*it, struct_name, indent, os);
+  os << "    bits->pad();\n"
+     << "    if(header_only)\n"
+     << "        return bits->bytes();\n\n";
+  for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    if(!it->in_head) construct_struct_encode_field(*it, struct_name, indent, os);
+  os << "    bits->pad();\n"
+     << "    return bits->bytes();\n"
+     << "}\n\n";
+
+  os << "std::size_t " << struct_name << "::decode(const char* bytes, std::size_t len, bool header_only)\n"
+     << "{\n"
+     << "    " << struct_name << "* msg = this;\n"
+     << "    *msg = " << struct_name << "();\n"
+     << "    dccl::v3::StructBitReader reader(bytes, len);\n"
+     << "    dccl::v3::StructBitReader* bits = &reader;\n"
+     << "    if(take_id(bits) != DCCL_ID)\n"
+     << "        throw(dccl::Exception(\"Not a " << desc->full_name() << " message (wrong DCCL id)\"));\n";
+  for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    if(it->in_head) construct_struct_decode_field(*it, struct_name, indent, os);
+  os << "    // the head is always its largest size\n"
+     << "    bits->seek_byte(" << head_bytes << ");\n"
+     << "    if(header_only)\n"
+     << "        return bits->bytes();\n\n";
+  for(std::vector<FixedField>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+    if(!it->in_head) construct_struct_decode_field(*it, struct_name, indent, os);
+  os << "    bits->pad();\n"
+     << "    return bits->bytes();\n"
+     << "}\n";
+}
+
+#endif
@@ -30,10 +30,20 @@
 #include <google/protobuf/io/zero_copy_stream.h>
 #include "option_extensions.pb.h"
 #include "gen_units_class_plugin.h"
+#include "gen_message_codec_plugin.h"
 
 std::set<std::string> systems_to_include_;
 std::set<std::string> base_units_to_include_;
 std::string filename_h_;
+std::string filename_cc_;
+
+// set by the plugin parameter (e.g. --dccl_out=generate_codecs,size_constants:.)
+bool generate_codecs_ = false;
+bool generate_structs_ = false;
+bool size_constants_ = false;
+bool static_assert_max_bytes_ = false;
+bool codecs_generated_ = false;
+bool structs_generated_ = false;
 
 
 class DCCLGenerator : public google::protobuf::compiler::CodeGenerator {
@@ -51,6 +61,10 @@ class DCCLGenerator : public google::protobuf::compiler::CodeGenerator {
     void generate_message(const google::protobuf::Descriptor* desc,
                           google::protobuf::compiler::GeneratorContext* generator_context,
                           boost::shared_ptr<std::string> message_unit_system = boost::shared_ptr<std::string>()) const;
+    void generate_message_codec(const google::protobuf::Descriptor* desc,
+                                google::protobuf::compiler::GeneratorContext* generator_context) const;
+    void generate_message_struct(const google::protobuf::Descriptor* desc,
+                                 google::protobuf::compiler::GeneratorContext* generator_context) const;
     void generate_field(const google::protobuf::FieldDescriptor* field,
                         google::protobuf::io::Printer* printer,
                         boost::shared_ptr<std::string> message_unit_system) const;
@@ -87,7 +101,30 @@ bool DCCLGenerator::Generate(const google::protobuf::FileDescriptor* file,
     {
         const std::string& filename = file->name();
         filename_h_ = filename.substr(0, filename.find(".proto")) + ".pb.h";
-//        std::string filename_cc = filename.substr(0, filename.find(".proto")) + ".pb.cc";
+        filename_cc_ = filename.substr(0, filename.find(".proto")) + ".pb.cc";
+        generate_codecs_ = false;
+        generate_structs_ = false;
+        size_constants_ = false;
+        static_assert_max_bytes_ = false;
+        codecs_generated_ = false;
+        structs_generated_ = false;
+
+        std::vector<std::pair<std::string, std::string> > options;
+        google::protobuf::compiler::ParseGeneratorParameter(parameter, &options);
+        for(std::vector<std::pair<std::string, std::string> >::const_iterator it = options.begin(), end = options.end(); it != end; ++it)
+        {
+            if(it->first == "generate_codecs")
+                generate_codecs_ = true;
+            else if(it->first == "generate_structs")
+                generate_structs_ = true;
+            else if(it->first == "size_constants")
+                size_constants_ = true;
+            // the static_assert uses the size constants
+            else if(it->first == "static_assert_max_bytes")
+                size_constants_ = static_assert_max_bytes_ = true;
+            else
+                throw(std::runtime_error("Unknown protoc-gen-dccl parameter: " + it->first));
+        }
         
         for(int message_i = 0, message_n = file->message_type_count(); message_i < message_n; ++message_i)
         {
@@ -110,6 +147,8 @@ bool DCCLGenerator::Generate(const google::protobuf::FileDescriptor* file,
         includes_ss << "#include <boost/units/absolute.hpp>" <<std::endl;
         includes_ss << "#include <boost/units/dimensionless_type.hpp>" <<std::endl;
         includes_ss << "#include <boost/units/make_scaled_unit.hpp>" <<std::endl;
+        if(structs_generated_)
+            includes_ss << "#include \"dccl/codecs3/generated_struct.h\"" <<std::endl;
 
         for(std::set<std::string>::const_iterator it = systems_to_include_.begin(), end = systems_to_include_.end(); it != end; ++it)
         {
@@ -120,6 +159,14 @@ bool DCCLGenerator::Generate(const google::protobuf::FileDescriptor* file,
             include_base_unit_headers(*it, includes_ss);
         }
         include_printer.Print(includes_ss.str().c_str());
+
+        if(codecs_generated_)
+        {
+            boost::shared_ptr<google::protobuf::io::ZeroCopyOutputStream> cc_include_output(
+                generator_context->OpenForInsert(filename_cc_, "includes"));
+            google::protobuf::io::Printer cc_include_printer(cc_include_output.get(), '$');
+            cc_include_printer.Print("#include \"dccl/codecs3/field_codec_generated.h\"\n");
+        }
         
         return true;
     }
@@ -148,6 +195,16 @@ void DCCLGenerator::generate_message(const google::protobuf::Descriptor* desc, g
                 id_enum << "enum DCCLParameters { DCCL_ID = " << desc->options().GetExtension(dccl::msg).id() << ", " <<
                     " DCCL_MAX_BYTES = " << desc->options().GetExtension(dccl::msg).max_bytes() << " };\n";
                 printer.Print(id_enum.str().c_str());
+
+                // if requested, messages of fixed size fields also get their encoded sizes as constants
+                std::vector<dccl::codegen::FixedField> fields;
+                std::string reason;
+                if(size_constants_ && dccl::codegen::fixed_fields(desc, &fields, &reason))
+                {
+                    std::stringstream sizes;
+                    construct_message_sizes_plugin(desc, fields, static_assert_max_bytes_, sizes);
+                    printer.Print(sizes.str().c_str());
+                }
             }
             
 
@@ -165,6 +222,12 @@ void DCCLGenerator::generate_message(const google::protobuf::Descriptor* desc, g
             generate_field(desc->field(field_i), &printer, message_unit_system);
         }
 
+        if(generate_codecs_)
+            generate_message_codec(desc, generator_context);
+
+        if(generate_structs_)
+            generate_message_struct(desc, generator_context);
+
         for(int nested_type_i = 0, nested_type_n = desc->nested_type_count(); nested_type_i < nested_type_n; ++nested_type_i)
             generate_message(desc->nested_type(nested_type_i), generator_context, message_unit_system);
     }
@@ -174,6 +237,63 @@ void DCCLGenerator::generate_message(const google::protobuf::Descriptor* desc, g
     }
 }
 
+void DCCLGenerator::generate_message_codec(const google::protobuf::Descriptor* desc, google::protobuf::compiler::GeneratorContext* generator_context) const
+{
+    // only DCCL messages (with an id) can be encoded by themselves
+    if(!desc->options().GetExtension(dccl::msg).has_id())
+        return;
+    
+    boost::shared_ptr<google::protobuf::io::ZeroCopyOutputStream> output(
+        generator_context->OpenForInsert(filename_cc_, "namespace_scope"));
+    google::protobuf::io::Printer printer(output.get(), '$');
+
+    std::stringstream codec;
+    std::vector<dccl::codegen::FixedField> fields;
+    std::string reason;
+    if(dccl::codegen::fixed_fields(desc, &fields, &reason))
+    {
+        construct_message_codec_plugin(desc, fields, codec);
+        codecs_generated_ = true;
+    }
+    else
+    {
+        // the message is still encoded by the DefaultMessageCodec
+        codec << "\n// protoc-gen-dccl: no generated DCCL codec for " << desc->full_name() << " (" << reason << ")\n";
+    }
+    printer.Print(codec.str().c_str());
+}
+
+void DCCLGenerator::generate_message_struct(const google::protobuf::Descriptor* desc, google::protobuf::compiler::GeneratorContext* generator_context) const
+{
+    if(!desc->options().GetExtension(dccl::msg).has_id())
+        return;
+
+    boost::shared_ptr<google::protobuf::io::ZeroCopyOutputStream> h_output(
+        generator_context->OpenForInsert(filename_h_, "namespace_scope"));
+    google::protobuf::io::Printer h_printer(h_output.get(), '$');
+
+    std::stringstream declaration;
+    std::vector<dccl::codegen::FixedField> fields;
+    std::string reason;
+    if(dccl::codegen::fixed_fields(desc, &fields, &reason, true))
+    {
+        construct_message_struct_plugin(desc, fields, declaration);
+
+        boost::shared_ptr<google::protobuf::io::ZeroCopyOutputStream> cc_output(
+            generator_context->OpenForInsert(filename_cc_, "namespace_scope"));
+        google::protobuf::io::Printer cc_printer(cc_output.get(), '$');
+        std::stringstream definition;
+        construct_message_struct_functions_plugin(desc, fields, definition);
+        cc_printer.Print(definition.str().c_str());
+        structs_generated_ = true;
+    }
+    else
+    {
+        declaration << "\n// protoc-gen-dccl: no DCCL struct for " << desc->full_name() << " (" << reason << ")\n";
+    }
+    h_printer.Print(declaration.str().c_str());
+}
+
 void DCCLGenerator::generate_field(const google::protobuf::FieldDescriptor* field, google::protobuf::io::Printer* printer, boost::shared_ptr<std::string> message_unit_system) const
 {
     try
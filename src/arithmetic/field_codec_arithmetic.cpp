@@ -99,32 +99,42 @@ extern "C"
 
 dccl::arith::Model::symbol_type dccl::arith::Model::value_to_symbol(value_type value) const
 {
-    if(value < *user_model_.value_bound().begin() || value > *(user_model_.value_bound().end()-1))
+    // also rejects NaN
+    if(!(value >= value_bound_.front() && value <= value_bound_.back()))
         return Model::OUT_OF_RANGE_SYMBOL;
-    
-
-    google::protobuf::RepeatedField<double>::const_iterator upper_it =
-        std::upper_bound(user_model_.value_bound().begin(),
-                         user_model_.value_bound().end(),
-                         value);
 
+    // index of the first bound greater than value
+    symbol_type upper = 0;
+    const symbol_type bounds_size = value_bound_.size();
+    if(uniform_bounds_)
+    {
+        upper = static_cast<symbol_type>((value - bound_min_) / bound_step_) + 1;
+        if(upper > bounds_size)
+            upper = bounds_size;
         
-    google::protobuf::RepeatedField<double>::const_iterator lower_it = 
-        (upper_it == user_model_.value_bound().begin()) ? upper_it : upper_it - 1;
-        
-    double lower_diff = std::abs((*lower_it)*(*lower_it) - value*value);
-    double upper_diff = std::abs((*upper_it)*(*upper_it) - value*value);
+        // correct for any floating point rounding in the division above, so this
+        // always gives the same answer as the binary search below
+        while(upper < bounds_size && value_bound_[upper] <= value)
+            ++upper;
+        while(upper > 1 && value_bound_[upper-1] > value)
+            --upper;
+    }
+    else
+    {
+        upper = std::upper_bound(value_bound_.begin(), value_bound_.end(), value)
+            - value_bound_.begin();
+    }
 
-//    std::cout << "value: " << value << std::endl;
-//    std::cout << "lower_value: " << *lower_it << std::endl;
-//    std::cout << "upper_value: " << *upper_it << std::endl;
-    
-    symbol_type symbol = ((lower_diff < upper_diff) ? lower_it : upper_it)
-        - user_model_.value_bound().begin();
+    symbol_type lower = upper - 1;
 
+    // value is exactly the last bound
+    if(upper == bounds_size)
+        return lower;
     
-    return symbol;
-                          
+    value_type lower_diff = std::abs(value_bound_[lower]*value_bound_[lower] - value*value);
+    value_type upper_diff = std::abs(value_bound_[upper]*value_bound_[upper] - value*value);
+
+    return (lower_diff < upper_diff) ? lower : upper;
 }
               
                   
@@ -136,10 +146,35 @@ dccl::arith::Model::value_type dccl::arith::Model::symbol_to_value(symbol_type s
                           
     value_type value = (symbol == Model::OUT_OF_RANGE_SYMBOL) ?
         std::numeric_limits<value_type>::quiet_NaN() :
-        user_model_.value_bound(symbol);
+        value_bound_[symbol];
 
     return value;
 }
+
+void dccl::arith::Model::cache_value_bounds()
+{
+    value_bound_.assign(user_model_.value_bound().begin(), user_model_.value_bound().end());
+
+    uniform_bounds_ = false;
+    bound_min_ = value_bound_.front();
+    bound_step_ = 0;
+    
+    if(value_bound_.size() < 2)
+        return;
+
+    bound_step_ = (value_bound_.back() - value_bound_.front()) / (value_bound_.size() - 1);
+
+    // tolerance only needs to keep value_to_symbol()'s correction step to at most one bound,
+    // so allow for the rounding error in typical user bounds (e.g. 0.1, 0.2, 0.3 ...)
+    const value_type tolerance = 1e-6 * bound_step_;
+    for(std::vector<value_type>::size_type i = 0, n = value_bound_.size(); i < n; ++i)
+    {
+        if(std::abs(value_bound_[i] - (bound_min_ + i*bound_step_)) > tolerance)
+            return;
+    }
+
+    uniform_bounds_ = true;
+}
               
 
 std::pair<dccl::arith::Model::freq_type, dccl::arith::Model::freq_type> dccl::arith::Model::symbol_to_cumulative_freq(symbol_type symbol, ModelState state) const
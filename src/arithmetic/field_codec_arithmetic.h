@@ -27,6 +27,8 @@
 
 #include <limits>
 #include <algorithm>
+#include <vector>
+#include <cmath>
 
 #include <boost/bimap.hpp>
 #include <boost/lexical_cast.hpp>
@@ -75,7 +77,10 @@ namespace dccl
 
             
           Model(const protobuf::ArithmeticModel& user)
-              : user_model_(user)
+              : user_model_(user),
+                uniform_bounds_(false),
+                bound_min_(0),
+                bound_step_(0)
             { }
 
             enum ModelState
@@ -108,11 +113,23 @@ namespace dccl
             std::pair<freq_type, freq_type> symbol_to_cumulative_freq(symbol_type symbol, ModelState state) const;
             std::pair<symbol_type, symbol_type> cumulative_freq_to_symbol(std::pair<freq_type, freq_type> c_freq_pair,  ModelState state) const;
 
+            /// true if `value_bound` is evenly spaced, allowing value_to_symbol() to compute the symbol directly rather than searching for it
+            bool uniform_bounds() const { return uniform_bounds_; }
+            
             friend class ModelManager;
+          private:
+            // copy of user_model_.value_bound() and (if uniform_bounds_) its affine parameters, computed by ModelManager::create_and_validate_model()
+            void cache_value_bounds();
+            
           private:
             protobuf::ArithmeticModel user_model_;
             boost::bimap<symbol_type, freq_type> encoder_cumulative_freqs_;
             boost::bimap<symbol_type, freq_type> decoder_cumulative_freqs_;
+
+            std::vector<value_type> value_bound_;
+            bool uniform_bounds_;
+            value_type bound_min_;
+            value_type bound_step_;
         };
 
         class ModelManager
@@ -187,6 +204,8 @@ namespace dccl
                                     model->user_model_.DebugString() +
                                     "`value_bound` must be monotonically increasing."));
                 }
+
+                model->cache_value_bounds();
             }
             
 
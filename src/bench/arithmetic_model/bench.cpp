@@ -0,0 +1,81 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// compares Model::value_to_symbol() / symbol_to_value() for uniformly spaced
+// value bounds (direct mapping) against non-uniform bounds (binary search)
+
+#include <iostream>
+#include <cstdlib>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "dccl/arithmetic/field_codec_arithmetic.h"
+
+const int num_symbols = 1000;
+const int num_values = 1000000;
+
+dccl::arith::protobuf::ArithmeticModel make_model(const std::string& name, bool uniform)
+{
+    dccl::arith::protobuf::ArithmeticModel model;
+    model.set_name(name);
+    for(int i = 0; i <= num_symbols; ++i)
+    {
+        // shift one bound to defeat the uniform detection
+        model.add_value_bound(i*0.25 + ((!uniform && i == num_symbols/2) ? 0.1 : 0));
+        if(i < num_symbols)
+            model.add_frequency(1);
+    }
+    return model;
+}
+
+void run_bench(const std::string& name, const std::vector<double>& values)
+{
+    const dccl::arith::Model& model = dccl::arith::ModelManager::find(name);
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    long long checksum = 0;
+    for(int i = 0, n = values.size(); i < n; ++i)
+    {
+        dccl::arith::Model::symbol_type symbol = model.value_to_symbol(values[i]);
+        checksum += symbol;
+        if(symbol >= 0)
+            checksum += static_cast<long long>(model.symbol_to_value(symbol));
+    }
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+
+    std::cout << name << " (uniform_bounds: " << std::boolalpha << model.uniform_bounds() << "): "
+              << static_cast<double>(elapsed.total_microseconds())*1e3 / values.size() << " ns/value"
+              << " (checksum: " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::arith::ModelManager::set_model(make_model("uniform", true));
+    dccl::arith::ModelManager::set_model(make_model("nonuniform", false));
+
+    std::vector<double> values(num_values);
+    srand(1);
+    for(int i = 0; i < num_values; ++i)
+        values[i] = (static_cast<double>(rand()) / RAND_MAX) * num_symbols * 0.25;
+
+    run_bench("uniform", values);
+    run_bench("nonuniform", values);
+}
@@ -0,0 +1,342 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// micro (Bitset, individual codecs) and macro (message shapes, crypto) benchmarks
+// of Codec::encode(), decode() and size(). Run with --benchmark_format=json or
+// --benchmark_out=<file> for machine-readable results, which can be compared
+// with compare.py.
+
+#include <dlfcn.h>
+
+#include <benchmark/benchmark.h>
+
+#include "dccl/codec.h"
+#include "dccl/arithmetic/field_codec_arithmetic.h"
+#include "dccl/ccl/protobuf/ccl.pb.h"
+#include "bench.pb.h"
+
+using namespace dccl::bench;
+
+namespace dccl
+{
+    /// Benchmark namespace
+    namespace bench
+    {
+        // CCL messages need the CCL identifier codec
+        template<typename ProtobufMessage>
+            struct UsesCCL { enum { value = false }; };
+        template<>
+            struct UsesCCL<dccl::legacyccl::protobuf::CCLMDATState> { enum { value = true }; };
+
+        dccl::Codec& codec(bool ccl, bool crypto)
+        {
+            static dccl::Codec* codecs[2][2] = { { 0, 0 }, { 0, 0 } };
+            dccl::Codec*& codec = codecs[ccl][crypto];
+            if(!codec)
+            {
+                // the libraries' field codecs are global, so they only need to be loaded once
+                static dccl::Codec* library_codec = 0;
+                if(!library_codec)
+                {
+                    library_codec = new dccl::Codec;
+                    const char* libraries[] = { DCCL_ARITHMETIC_NAME, DCCL_NATIVE_PROTOBUF_NAME, DCCL_CCL_COMPAT_NAME };
+                    for(int i = 0, n = sizeof(libraries)/sizeof(const char*); i < n; ++i)
+                    {
+                        void* dl_handle = dlopen(libraries[i], RTLD_LAZY);
+                        if(!dl_handle)
+                        {
+                            std::cerr << "Failed to open " << libraries[i] << std::endl;
+                            exit(1);
+                        }
+                        library_codec->load_library(dl_handle);
+                    }
+                }
+                    
+                codec = ccl ? new dccl::Codec("dccl.ccl.id") : new dccl::Codec;
+                if(crypto)
+                    codec->set_crypto_passphrase("dccl_bench");
+            }
+            return *codec;
+        }
+        
+        template<typename ProtobufMessage>
+            dccl::Codec& codec(bool crypto)
+        {
+            dccl::Codec& c = codec(UsesCCL<ProtobufMessage>::value, crypto);
+            static bool loaded[2] = { false, false };
+            if(!loaded[crypto])
+            {
+                c.load<ProtobufMessage>();
+                loaded[crypto] = true;
+            }
+            return c;
+        }
+        
+        void fill(Flat* msg)
+        {
+            msg->set_lat(41.523412);
+            msg->set_lon(-70.672841);
+            msg->set_depth(1234.5);
+            msg->set_heading(271);
+            msg->set_battery(87);
+            msg->set_status(SURVEY);
+            msg->set_ok(true);
+            msg->set_speed(1.52);
+        }
+
+        void fill(Point* point, int i)
+        {
+            point->set_x(-250.5 + 10*i);
+            point->set_y(731.2 - 10*i);
+            point->set_z(i % 100);
+        }
+        
+        void fill(Nested* msg)
+        {
+            fill(msg->mutable_origin(), 0);
+            fill(msg->mutable_leg()->mutable_start(), 1);
+            fill(msg->mutable_leg()->mutable_end(), 2);
+            fill(msg->mutable_next_leg()->mutable_start(), 2);
+            fill(msg->mutable_next_leg()->mutable_end(), 3);
+        }
+
+        void fill(Repeated* msg)
+        {
+            for(int i = 0; i < 64; ++i)
+                msg->add_samples((i * 37) % 1024);
+            for(int i = 0; i < 16; ++i)
+                msg->add_temperature(4.25 + i * 0.5);
+            for(int i = 0; i < 8; ++i)
+                fill(msg->add_track(), i);
+        }
+
+        // two of the sixteen fields set
+        void fill(SparseOptional* msg)
+        {
+            msg->set_f3(512);
+            msg->set_f10(-12.34);
+        }
+
+        void fill(NumericV2* msg) { msg->set_value(-123.456); msg->set_count(98765); }
+        void fill(NumericV3* msg) { msg->set_value(-123.456); msg->set_count(98765); }
+        void fill(String* msg) { msg->set_value("the quick brown fox"); }
+        void fill(Bytes* msg) { msg->set_value(std::string(32, '\xA5')); }
+        void fill(VarBytes* msg) { msg->set_value(std::string(20, '\x5A')); }
+        void fill(Presence* msg) { msg->set_a(500); msg->set_c(-1.25); }
+        
+        void fill(Enum* msg)
+        {
+            msg->set_value(TRANSIT);
+            for(int i = 0; i < 8; ++i)
+                msg->add_history(static_cast<Status>(i % 4));
+        }
+        
+        void fill(Time* msg) { msg->set_time(1500000000000000ull); }
+
+        void fill(Arithmetic* msg)
+        {
+            for(int i = 0; i < 16; ++i)
+                msg->add_value(-8 + i);
+        }
+
+        void fill(NativeProtobuf* msg)
+        {
+            msg->set_value(3.14159);
+            msg->set_count(-42);
+            msg->set_offset(-1234567890123ll);
+            msg->set_ok(true);
+            msg->set_status(ABORT);
+        }
+        
+        void fill(dccl::legacyccl::protobuf::CCLMDATState* msg)
+        {
+            // from dccl_ccl test
+            codec<dccl::legacyccl::protobuf::CCLMDATState>(false).decode(dccl::hex_decode("0e86fa11ad20c9011b4432bf47d10000002401042f0e7d87fa111620c95a200a"), msg);
+        }
+    }
+}
+
+//
+// Bitset primitives
+//
+
+void BM_BitsetFromByteString(benchmark::State& state)
+{
+    std::string bytes(state.range(0), '\xA5');
+    dccl::Bitset bits;
+    while(state.KeepRunning())
+    {
+        bits.from_byte_string(bytes);
+        benchmark::DoNotOptimize(bits);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_BitsetFromByteString)->Arg(8)->Arg(32)->Arg(256);
+
+void BM_BitsetToByteString(benchmark::State& state)
+{
+    dccl::Bitset bits;
+    bits.from_byte_string(std::string(state.range(0), '\xA5'));
+    while(state.KeepRunning())
+        benchmark::DoNotOptimize(bits.to_byte_string());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BitsetToByteString)->Arg(8)->Arg(32)->Arg(256);
+
+// builds a Bitset from 32 fields of the given size, like encoding a message
+void BM_BitsetAppend(benchmark::State& state)
+{
+    dccl::Bitset field(state.range(0), 0x55);
+    while(state.KeepRunning())
+    {
+        dccl::Bitset bits;
+        for(int i = 0; i < 32; ++i)
+            bits.append(field);
+        benchmark::DoNotOptimize(bits);
+    }
+}
+BENCHMARK(BM_BitsetAppend)->Arg(1)->Arg(8)->Arg(20);
+
+void BM_BitsetShiftRight(benchmark::State& state)
+{
+    dccl::Bitset bits(state.range(0), 0xFFFF);
+    while(state.KeepRunning())
+    {
+        dccl::Bitset shifted = bits >> 8;
+        benchmark::DoNotOptimize(shifted);
+    }
+}
+BENCHMARK(BM_BitsetShiftRight)->Arg(64)->Arg(512);
+
+void BM_BitsetToULong(benchmark::State& state)
+{
+    dccl::Bitset bits(state.range(0), 0x12345678);
+    while(state.KeepRunning())
+        benchmark::DoNotOptimize(bits.to_ulong());
+}
+BENCHMARK(BM_BitsetToULong)->Arg(8)->Arg(32);
+
+//
+// Codec
+//
+
+template<typename ProtobufMessage>
+void BM_Encode(benchmark::State& state)
+{
+    dccl::Codec& codec = dccl::bench::codec<ProtobufMessage>(state.range(0));
+    ProtobufMessage msg;
+    dccl::bench::fill(&msg);
+    std::string bytes;
+    while(state.KeepRunning())
+    {
+        bytes.clear();
+        codec.encode(&bytes, msg);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+    state.counters["encoded_bytes"] = bytes.size();
+}
+
+template<typename ProtobufMessage>
+void BM_Decode(benchmark::State& state)
+{
+    dccl::Codec& codec = dccl::bench::codec<ProtobufMessage>(state.range(0));
+    ProtobufMessage msg;
+    dccl::bench::fill(&msg);
+    std::string bytes;
+    codec.encode(&bytes, msg);
+    while(state.KeepRunning())
+    {
+        msg.Clear();
+        codec.decode(bytes, &msg);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+    state.counters["encoded_bytes"] = bytes.size();
+}
+
+template<typename ProtobufMessage>
+void BM_Size(benchmark::State& state)
+{
+    dccl::Codec& codec = dccl::bench::codec<ProtobufMessage>(state.range(0));
+    ProtobufMessage msg;
+    dccl::bench::fill(&msg);
+    while(state.KeepRunning())
+        benchmark::DoNotOptimize(codec.size(msg));
+}
+
+// each built-in codec, without crypto
+#define DCCL_BENCH_CODEC(ProtobufMessage)                               \
+    BENCHMARK_TEMPLATE(BM_Encode, ProtobufMessage)->ArgName("crypto")->Arg(0); \
+    BENCHMARK_TEMPLATE(BM_Decode, ProtobufMessage)->ArgName("crypto")->Arg(0)
+
+DCCL_BENCH_CODEC(NumericV2);
+DCCL_BENCH_CODEC(NumericV3);
+DCCL_BENCH_CODEC(String);
+DCCL_BENCH_CODEC(Bytes);
+DCCL_BENCH_CODEC(VarBytes);
+DCCL_BENCH_CODEC(Presence);
+DCCL_BENCH_CODEC(Enum);
+DCCL_BENCH_CODEC(Time);
+DCCL_BENCH_CODEC(Arithmetic);
+DCCL_BENCH_CODEC(NativeProtobuf);
+DCCL_BENCH_CODEC(dccl::legacyccl::protobuf::CCLMDATState);
+
+// message shapes, with crypto off and (if available) on
+#if DCCL_HAS_CRYPTOPP
+#define DCCL_BENCH_CRYPTO_ARGS ->Arg(0)->Arg(1)
+#else
+#define DCCL_BENCH_CRYPTO_ARGS ->Arg(0)
+#endif
+
+#define DCCL_BENCH_SHAPE(ProtobufMessage)                               \
+    BENCHMARK_TEMPLATE(BM_Encode, ProtobufMessage)->ArgName("crypto") DCCL_BENCH_CRYPTO_ARGS; \
+    BENCHMARK_TEMPLATE(BM_Decode, ProtobufMessage)->ArgName("crypto") DCCL_BENCH_CRYPTO_ARGS; \
+    BENCHMARK_TEMPLATE(BM_Size, ProtobufMessage)->ArgName("crypto")->Arg(0)
+
+DCCL_BENCH_SHAPE(Flat);
+DCCL_BENCH_SHAPE(Nested);
+DCCL_BENCH_SHAPE(Repeated);
+DCCL_BENCH_SHAPE(SparseOptional);
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+    
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    // load the library before using its ModelManager
+    dccl::bench::codec(false, false);
+    
+    // uniform over [-10, 10)
+    dccl::arith::protobuf::ArithmeticModel model;
+    model.set_name("bench");
+    for(int i = 0; i <= 20; ++i)
+    {
+        model.add_value_bound(-10 + i);
+        if(i < 20)
+            model.add_frequency(1);
+    }
+    dccl::arith::ModelManager::set_model(model);
+    
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
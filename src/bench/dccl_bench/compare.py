@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""Compares two dccl_bench results files written with --benchmark_out=<file>
+(JSON), e.g.
+
+  dccl_bench --benchmark_out=before.json
+  (make changes, rebuild)
+  dccl_bench --benchmark_out=after.json
+  compare.py before.json after.json --threshold 5
+
+Exits with a non-zero status if any benchmark is slower by more than the
+threshold (in percent).
+"""
+__license__ = "LGPL"
+
+import argparse
+import json
+import sys
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    times = {}
+    for b in results["benchmarks"]:
+        # only the individual runs, not the mean/median/stddev aggregates
+        if b.get("run_type", "iteration") != "iteration" or "error_occurred" in b:
+            continue
+        times[b["name"]] = b["cpu_time"] * TIME_UNITS[b.get("time_unit", "ns")]
+    return times
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two dccl_bench JSON results files")
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent slowdown reported as a regression (default: 5)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    contender = load(args.contender)
+
+    regressions = 0
+    names = sorted(set(baseline) | set(contender))
+    width = max([len(name) for name in names] + [len("benchmark")])
+    print("%-*s %14s %14s %9s" % (width, "benchmark", "baseline (ns)", "contender (ns)", "change"))
+    for name in names:
+        if name not in baseline or name not in contender:
+            print("%-*s %14s %14s %9s" % (width, name,
+                                          "%.1f" % baseline[name] if name in baseline else "-",
+                                          "%.1f" % contender[name] if name in contender else "-", ""))
+            continue
+
+        change = 100.0 * (contender[name] - baseline[name]) / baseline[name]
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-*s %14.1f %14.1f %+8.1f%%%s" % (width, name, baseline[name], contender[name], change, flag))
+
+    if regressions:
+        print("%d benchmark(s) slower by more than %g%%" % (regressions, args.threshold))
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -211,9 +211,9 @@ TIME_DATE Encode_time_date(long secs_since_1970)
 */ 
   struct tm tm;
   TIME_DATE_LONG comp;
-  /* Note: substitute localtime() for local timezone 
+  /* Note: substitute localtime_r() for local timezone 
    * instead of GMT. */ 
-  tm = *gmtime(&secs_since_1970);
+  gmtime_r(&secs_since_1970, &tm);
   comp.as_long = (unsigned long)tm.tm_sec >> 2;
   comp.as_long += (unsigned long)tm.tm_min << 4;
   comp.as_long += (unsigned long)tm.tm_hour << (4 + 6);
@@ -20,6 +20,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include <ctime>
+#include <limits>
 
 #include <boost/date_time.hpp>
 
@@ -27,6 +28,51 @@
 #include "WhoiUtil.h"
 #include "dccl/codec.h"
 
+namespace
+{
+    // Decoded values for every possible input of the fixed size CCL
+    // quantizers, computed once (using the WhoiUtil functions, so the results
+    // are identical) when the library is loaded. Decoding a large CCL archive
+    // then becomes a table lookup per field.
+    struct CCLDecodeTables
+    {
+        enum { DEPTH_TABLE_SIZE = 1 << 13 }; // Decode_depth() only uses the bottom 13 bits
+        
+        CCLDecodeTables()
+        {
+            for(unsigned i = 0; i <= std::numeric_limits<unsigned char>::max(); ++i)
+            {
+                heading[i] = Decode_heading(i);
+                velocity[i] = Decode_est_velocity(static_cast<char>(i));
+                speed_rpm[i] = Decode_speed(SPEED_MODE_RPM, static_cast<char>(i));
+                speed_msec[i] = Decode_speed(SPEED_MODE_MSEC, static_cast<char>(i));
+                watts[i] = Decode_watts(i);
+                salinity[i] = Decode_salinity(i);
+                temperature[i] = Decode_temperature(i);
+                sound_speed[i] = Decode_sound_speed(i);
+            }
+            for(unsigned i = 0; i < DEPTH_TABLE_SIZE; ++i)
+                depth[i] = Decode_depth(i);
+        }
+
+        float heading[1 << dccl::BITS_IN_BYTE];
+        float velocity[1 << dccl::BITS_IN_BYTE];
+        float speed_rpm[1 << dccl::BITS_IN_BYTE];
+        float speed_msec[1 << dccl::BITS_IN_BYTE];
+        float watts[1 << dccl::BITS_IN_BYTE];
+        float salinity[1 << dccl::BITS_IN_BYTE];
+        float temperature[1 << dccl::BITS_IN_BYTE];
+        float sound_speed[1 << dccl::BITS_IN_BYTE];
+        float depth[DEPTH_TABLE_SIZE];
+    };
+
+    const CCLDecodeTables decode_tables;
+
+    // index into the 8 bit tables
+    inline unsigned char byte_index(dccl::Bitset* bits)
+    { return static_cast<unsigned char>(bits->to_ulong()); }
+}
+
 extern "C"
 {
     void dccl3_load(dccl::Codec* dccl)
@@ -148,9 +194,13 @@ dccl::uint64 dccl::legacyccl::TimeDateCodec::decode(Bitset* bits)
     Decode_time_date(decoded.as_time_date,
                      &mon, &day, &hour, &min, &sec);
 
-    // \todo chrismurf FIX ME! with timegm
-    // assume current year
-    int year = boost::gregorian::day_clock::universal_day().year();
+    // the year is not encoded, so assume the year of the reference time
+    // (the current time unless set with Codec::set_reference_time(), e.g. to
+    // the time an archive was logged)
+    time_t reference = static_cast<time_t>(FieldCodecBase::reference_time());
+    std::tm reference_tm;
+    gmtime_r(&reference, &reference_tm);
+    int year = reference_tm.tm_year + 1900;
 
     boost::posix_time::ptime time_date(
         boost::gregorian::date(year, mon, day), 
@@ -196,7 +246,7 @@ dccl::Bitset dccl::legacyccl::HeadingCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_heading(wire_value)); } 
 
 float dccl::legacyccl::HeadingCodec::decode(Bitset* bits)
-{ return Decode_heading(bits->to_ulong()); }
+{ return decode_tables.heading[byte_index(bits)]; }
 
 
 //
@@ -206,7 +256,7 @@ dccl::Bitset dccl::legacyccl::DepthCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_depth(wire_value)); } 
 
 float dccl::legacyccl::DepthCodec::decode(Bitset* bits)
-{ return Decode_depth(bits->to_ulong()); }
+{ return decode_tables.depth[bits->to_ulong() & (CCLDecodeTables::DEPTH_TABLE_SIZE - 1)]; }
 
 //
 // VelocityCodec
@@ -217,7 +267,7 @@ dccl::Bitset dccl::legacyccl::VelocityCodec::encode(const float& wire_value)
 } 
 
 float dccl::legacyccl::VelocityCodec::decode(Bitset* bits)
-{ return Decode_est_velocity(bits->to_ulong()); }
+{ return decode_tables.velocity[byte_index(bits)]; }
 
 
 //
@@ -252,10 +302,10 @@ float dccl::legacyccl::SpeedCodec::decode(Bitset* bits)
     {
         default:
         case protobuf::CCLMDATRedirect::RPM:
-            return Decode_speed(SPEED_MODE_RPM, bits->to_ulong());
+            return decode_tables.speed_rpm[byte_index(bits)];
             
         case protobuf::CCLMDATRedirect::METERS_PER_SECOND:
-            return Decode_speed(SPEED_MODE_MSEC, bits->to_ulong());
+            return decode_tables.speed_msec[byte_index(bits)];
     }
 }
 
@@ -268,7 +318,7 @@ dccl::Bitset dccl::legacyccl::WattsCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_watts(wire_value, 1)); } 
 
 float dccl::legacyccl::WattsCodec::decode(Bitset* bits)
-{ return Decode_watts(bits->to_ulong()); }
+{ return decode_tables.watts[byte_index(bits)]; }
 
 //
 // GFIPitchOilCodec
@@ -305,7 +355,7 @@ dccl::Bitset dccl::legacyccl::SalinityCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_salinity(wire_value)); } 
 
 float dccl::legacyccl::SalinityCodec::decode(Bitset* bits)
-{ return Decode_salinity(bits->to_ulong()); }
+{ return decode_tables.salinity[byte_index(bits)]; }
 
 //
 // TemperatureCodec
@@ -314,7 +364,7 @@ dccl::Bitset dccl::legacyccl::TemperatureCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_temperature(wire_value)); } 
 
 float dccl::legacyccl::TemperatureCodec::decode(Bitset* bits)
-{ return Decode_temperature(bits->to_ulong()); }
+{ return decode_tables.temperature[byte_index(bits)]; }
 
 //
 // SoundSpeedCodec
@@ -323,4 +373,4 @@ dccl::Bitset dccl::legacyccl::SoundSpeedCodec::encode(const float& wire_value)
 { return dccl::Bitset(size(), Encode_sound_speed(wire_value)); } 
 
 float dccl::legacyccl::SoundSpeedCodec::decode(Bitset* bits)
-{ return Decode_sound_speed(bits->to_ulong()); }
+{ return decode_tables.sound_speed[byte_index(bits)]; }
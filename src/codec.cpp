@@ -20,19 +20,22 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <typeinfo>
 
 #include <dlfcn.h> // for shared library loading
+#include <pthread.h>
+#include <unistd.h> // for sysconf
 
 #include "dccl/codec.h"
 
 #if DCCL_HAS_CRYPTOPP
 #if CRYPTOPP_PATH_USES_PLUS_SIGN
-#include <crypto++/filters.h>
 #include <crypto++/sha.h>
 #include <crypto++/modes.h>
 #include <crypto++/aes.h>
 #else
-#include <cryptopp/filters.h>
 #include <cryptopp/sha.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/aes.h>
@@ -46,6 +49,8 @@
 #include "dccl/field_codec_id.h"
 
 #include "dccl/option_extensions.pb.h"
+#include "dccl/codec_snapshot.pb.h"
+#include "dccl/version.h"
 
 
 using dccl::hex_encode;
@@ -66,7 +71,7 @@ const unsigned full_width = 60;
 //
 
 dccl::Codec::Codec(const std::string& dccl_id_codec, const std::string& library_path)
-    : strict_(false), id_codec_(dccl_id_codec)
+    : strict_(false), profiling_(false), id_codec_(dccl_id_codec)
 {
     set_default_codecs();
     FieldCodecManager::add<DefaultIdentifierCodec>(default_id_codec_name());
@@ -194,6 +199,7 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
 
             internal::MessageStack msg_stack;
             msg_stack.push(msg.GetDescriptor());
+            internal::FieldProfiler::Scope profiler_scope(profiling_ ? &profile_ : 0);
             codec->base_encode(&head_bits, msg, HEAD, strict_);
 
             // given header of not even byte size (e.g. 01011), make even byte size (e.g. 00001011)
@@ -233,7 +239,6 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
 
 size_t dccl::Codec::encode(char* bytes, size_t max_len, const google::protobuf::Message& msg, bool header_only /* = false */, int user_id /* = -1 */)
 {
-    const Descriptor* desc = msg.GetDescriptor();
     Bitset head_bits;
     Bitset body_bits;
     encode_internal(msg, header_only, head_bits, body_bits, user_id);
@@ -243,74 +248,167 @@ size_t dccl::Codec::encode(char* bytes, size_t max_len, const google::protobuf::
     {
         throw std::length_error("max_len must be >= head_byte_size");
     }
+
+    size_t body_byte_size = header_only ? 0 : ceil_bits2bytes(body_bits.size());
+    if (max_len < (head_byte_size + body_byte_size))
+    {
+        throw std::length_error("max_len must be >= (head_byte_size + body_byte_size)");
+    }
+
+    write_encoded(bytes, msg, header_only, head_bits, body_bits, user_id);
+    return head_byte_size + body_byte_size;
+}
+
+
+void dccl::Codec::encode(std::string* bytes, const google::protobuf::Message& msg, bool header_only /* = false */, int user_id /* = -1 */)
+{
+    Bitset head_bits;
+    Bitset body_bits;
+    encode_internal(msg, header_only, head_bits, body_bits, user_id);
+
+    size_t head_byte_size = ceil_bits2bytes(head_bits.size());
+    size_t body_byte_size = header_only ? 0 : ceil_bits2bytes(body_bits.size());
+
+    // append directly to the caller's string so that encryption can happen in place
+    size_t offset = bytes->size();
+    bytes->resize(offset + head_byte_size + body_byte_size);
+    write_encoded(&(*bytes)[offset], msg, header_only, head_bits, body_bits, user_id);
+}
+
+void dccl::Codec::write_encoded(char* bytes, const google::protobuf::Message& msg, bool header_only, Bitset& head_bits, Bitset& body_bits, int user_id, std::vector<CryptoRange>* deferred_crypto /* = 0 */)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    
+    size_t head_byte_size = ceil_bits2bytes(head_bits.size());
     head_bits.to_byte_string(bytes, head_byte_size);
 
     dlog.is(DEBUG2, ENCODE) && dlog << "Head bytes (bits): " << head_byte_size << "(" << head_bits.size() << ")" << std::endl;
     dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (bin): " << head_bits << std::endl;
     dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (hex): " << hex_encode(bytes, bytes+head_byte_size) << std::endl;
 
-    size_t body_byte_size = 0;
     if (!header_only)
     {
-        body_byte_size = ceil_bits2bytes(body_bits.size());
-        if (max_len < (head_byte_size + body_byte_size))
-        {
-            throw std::length_error("max_len must be >= (head_byte_size + body_byte_size)");
-        }
-        body_bits.to_byte_string(bytes+head_byte_size, max_len-head_byte_size);
+        char* body = bytes+head_byte_size;
+        size_t body_byte_size = ceil_bits2bytes(body_bits.size());
+        body_bits.to_byte_string(body, body_byte_size);
 
         dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (bin): " << body_bits << std::endl;
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (hex): " << hex_encode(bytes+head_byte_size, bytes+head_byte_size+body_byte_size) << std::endl;
+        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (hex): " << hex_encode(body, body+body_byte_size) << std::endl;
         dlog.is(DEBUG2, ENCODE) && dlog << "Body bytes (bits): " <<  body_byte_size << "(" << body_bits.size() << ")" <<  std::endl;
 
         unsigned dccl_id = (user_id < 0) ? id(desc) : user_id;
-        if(!crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id)) {
-            std::string head_bytes(bytes, bytes+head_byte_size);
-            std::string body_bytes(bytes+head_byte_size, bytes+head_byte_size+body_byte_size);
-            encrypt(&body_bytes, head_bytes);
-            std::memcpy(bytes+head_byte_size, body_bytes.data(), body_bytes.size());
+        if(!crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id))
+        {
+            if(deferred_crypto)
+            {
+                CryptoRange range = { body, body+body_byte_size, bytes, body };
+                deferred_crypto->push_back(range);
+            }
+            else
+            {
+                encrypt(body, body+body_byte_size, bytes, body);
+                dlog.is(logger::DEBUG3, logger::ENCODE) && dlog << "Encrypted Body (hex): " << hex_encode(body, body+body_byte_size) << std::endl;
+            }
         }
-
-        dlog.is(logger::DEBUG3, logger::ENCODE) && dlog << "Encrypted Body (hex): " << hex_encode(bytes+head_byte_size, bytes+head_byte_size+body_byte_size) << std::endl;
     }
 
     dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: " << desc->full_name() << std::endl;
-
-    return head_byte_size + body_byte_size;
 }
 
-
-void dccl::Codec::encode(std::string* bytes, const google::protobuf::Message& msg, bool header_only /* = false */, int user_id /* = -1 */)
+void dccl::Codec::encode_many(std::vector<std::string>* bytes, const std::vector<const google::protobuf::Message*>& msgs)
 {
-    const Descriptor* desc = msg.GetDescriptor();
-    Bitset head_bits;
-    Bitset body_bits;
-    encode_internal(msg, header_only, head_bits, body_bits, user_id);
+    // size the output first so the strings (and the ranges into them) do not move
+    bytes->assign(msgs.size(), std::string());
 
-    std::string head_bytes = head_bits.to_byte_string();
+    std::vector<CryptoRange> crypto_ranges;
+    crypto_ranges.reserve(msgs.size());
+    
+    for(std::vector<const google::protobuf::Message*>::size_type i = 0, n = msgs.size(); i < n; ++i)
+    {
+        Bitset head_bits;
+        Bitset body_bits;
+        encode_internal(*msgs[i], false, head_bits, body_bits, -1);
 
-    dlog.is(DEBUG2, ENCODE) && dlog << "Head bytes (bits): " << head_bytes.size() << "(" << head_bits.size() << ")" << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (bin): " << head_bits << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (hex): " << hex_encode(head_bytes) << std::endl;
+        std::string& out = (*bytes)[i];
+        out.resize(ceil_bits2bytes(head_bits.size()) + ceil_bits2bytes(body_bits.size()));
+        write_encoded(&out[0], *msgs[i], false, head_bits, body_bits, -1, &crypto_ranges);
+    }
 
-    std::string body_bytes;
-    if (!header_only)
+    if(!crypto_ranges.empty())
+        encrypt_many(crypto_ranges);
+}
+
+void dccl::Codec::decode_many(const std::vector<std::string>& bytes, std::vector<boost::shared_ptr<google::protobuf::Message> >* msgs)
+{
+    msgs->assign(bytes.size(), boost::shared_ptr<google::protobuf::Message>());
+
+    // messages to decrypt are copied into crypto_buffer, with
+    // decrypt_offset[i] their location in it (or npos if not encrypted)
+    std::vector<std::string::size_type> decrypt_offset(bytes.size(), std::string::npos);
+    std::vector<unsigned> decrypt_head_size(bytes.size(), 0);
+    std::string::size_type total_size = 0;
+    for(std::vector<std::string>::size_type i = 0, n = bytes.size(); i < n; ++i)
     {
-        body_bytes = body_bits.to_byte_string();
+        unsigned this_id = id(bytes[i]);
+        std::map<int32, const google::protobuf::Descriptor*>::const_iterator desc_it = id2desc_.find(this_id);
+        if(desc_it == id2desc_.end())
+            throw(Exception("Message id " + boost::lexical_cast<std::string>(this_id) + " has not been loaded. Call load() before decoding this type."));
 
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (bin): " << body_bits << std::endl;
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (hex): " << hex_encode(body_bytes) << std::endl;
-        dlog.is(DEBUG2, ENCODE) && dlog << "Body bytes (bits): " <<  body_bytes.size() << "(" << body_bits.size() << ")" <<  std::endl;
+        (*msgs)[i] = dccl::DynamicProtobufManager::new_protobuf_message(desc_it->second);
 
-        unsigned dccl_id = (user_id < 0) ? id(desc) : user_id;
-        if(!crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id))
-            encrypt(&body_bytes, head_bytes);
+        if(!crypto_key_.empty() && !skip_crypto_ids_.count(this_id))
+        {
+            decrypt_head_size[i] = head_byte_size(desc_it->second, this_id);
+            if(decrypt_head_size[i] > bytes[i].size())
+                throw(Exception("Message " + hex_encode(bytes[i]) + " is too small to contain its header"));
+            decrypt_offset[i] = total_size;
+            total_size += bytes[i].size();
+        }
+    }
+
+    std::vector<CryptoRange> crypto_ranges;
+    std::string crypto_buffer;
+    if(total_size > 0)
+    {
+        crypto_buffer.resize(total_size);
+        for(std::vector<std::string>::size_type i = 0, n = bytes.size(); i < n; ++i)
+        {
+            if(decrypt_offset[i] == std::string::npos)
+                continue;
 
-        dlog.is(logger::DEBUG3, logger::ENCODE) && dlog << "Encrypted Body (hex): " << hex_encode(body_bytes) << std::endl;
+            char* head = &crypto_buffer[decrypt_offset[i]];
+            std::copy(bytes[i].begin(), bytes[i].end(), head);
+            CryptoRange range = { head + decrypt_head_size[i], head + bytes[i].size(), head, head + decrypt_head_size[i] };
+            crypto_ranges.push_back(range);
+        }
+        decrypt_many(crypto_ranges);
     }
 
-    dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: " << desc->full_name() << std::endl;
-    *bytes += head_bytes + body_bytes;
+    for(std::vector<std::string>::size_type i = 0, n = bytes.size(); i < n; ++i)
+    {
+        if(decrypt_offset[i] == std::string::npos)
+        {
+            decode_internal(bytes[i].begin(), bytes[i].end(), (*msgs)[i].get(), false, false);
+        }
+        else
+        {
+            const char* begin = crypto_buffer.data() + decrypt_offset[i];
+            decode_internal(begin, begin + bytes[i].size(), (*msgs)[i].get(), false, true);
+        }
+    }
+}
+
+unsigned dccl::Codec::head_byte_size(const google::protobuf::Descriptor* desc, unsigned dccl_id) const
+{
+    boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
+    if(!codec)
+        throw(Exception("Failed to find (dccl.msg).codec `" + desc->options().GetExtension(dccl::msg).codec() + "`"));
+
+    unsigned head_size_bits = 0;
+    codec->base_max_size(&head_size_bits, desc, HEAD);
+    unsigned id_size = 0;
+    id_codec()->field_size(&id_size, dccl_id, 0);
+    return ceil_bits2bytes(head_size_bits + id_size);
 }
 
 unsigned dccl::Codec::id(const std::string& bytes) const
@@ -337,32 +435,9 @@ void dccl::Codec::load(const google::protobuf::Descriptor* desc, int user_id /*
 {
     try
     {
-        if(user_id <0 && !desc->options().GetExtension(dccl::msg).has_id())
-            throw(Exception("Missing message option `(dccl.msg).id`. Specify a unique id (e.g. 3) in the body of your .proto message using \"option (dccl.msg).id = 3\""));
-        if(!desc->options().GetExtension(dccl::msg).has_max_bytes())
-            throw(Exception("Missing message option `(dccl.msg).max_bytes`. Specify a maximum (encoded) message size in bytes (e.g. 32) in the body of your .proto message using \"option (dccl.msg).max_bytes = 32\""));
-
-        if(!desc->options().GetExtension(dccl::msg).has_codec_version())
-            dlog.is(WARN) && dlog << "** NOTE: No (dccl.msg).codec_version set for DCCL Message '" << desc->full_name() <<  "'. Unless you need backwards compatibility with Goby 2.0 (DCCL2), we highly recommend setting 'option (dccl.msg).codec_version = 3' in the message definition for " << desc->full_name() << " to use the default DCCL3 codecs. If you need compatibility with Goby 2.0, ignore this warning, or set 'option (dccl.msg).codec_version = 2' to remove this warning. **" << std::endl;
-
-        boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
-
-        unsigned dccl_id = (user_id < 0) ? id(desc) : user_id;
-        unsigned head_size_bits, body_size_bits;
-        codec->base_max_size(&head_size_bits, desc, HEAD);
-        codec->base_max_size(&body_size_bits, desc, BODY);
-
-        unsigned id_bits = 0;
-        id_codec()->field_size(&id_bits, dccl_id, 0);
-        head_size_bits += id_bits;
-
-        const unsigned byte_size = ceil_bits2bytes(head_size_bits) + ceil_bits2bytes(body_size_bits);
-
-        if(byte_size > desc->options().GetExtension(dccl::msg).max_bytes())
-            throw(Exception("Actual maximum size of message exceeds allowed maximum (dccl.max_bytes). Tighten bounds, remove fields, improve codecs, or increase the allowed dccl.max_bytes"));
-
-        codec->base_validate(desc, HEAD);
-        codec->base_validate(desc, BODY);
+        warn_codec_version(desc);
+        
+        unsigned dccl_id = validate(desc, user_id);
 
         if(id2desc_.count(dccl_id) && desc != id2desc_.find(dccl_id)->second)
             throw(Exception("`dccl id` " + boost::lexical_cast<std::string>(dccl_id) + " is already in use by Message " + id2desc_.find(dccl_id)->second->full_name() + ": " + boost::lexical_cast<std::string>(id2desc_.find(dccl_id)->second)));
@@ -374,19 +449,159 @@ void dccl::Codec::load(const google::protobuf::Descriptor* desc, int user_id /*
     }
     catch(Exception& e)
     {
+        log_validation_failure(desc, e);
+        throw;
+    }
+}
+
+void dccl::Codec::warn_codec_version(const google::protobuf::Descriptor* desc) const
+{
+    if(!desc->options().GetExtension(dccl::msg).has_codec_version())
+        dlog.is(WARN) && dlog << "** NOTE: No (dccl.msg).codec_version set for DCCL Message '" << desc->full_name() <<  "'. Unless you need backwards compatibility with Goby 2.0 (DCCL2), we highly recommend setting 'option (dccl.msg).codec_version = 3' in the message definition for " << desc->full_name() << " to use the default DCCL3 codecs. If you need compatibility with Goby 2.0, ignore this warning, or set 'option (dccl.msg).codec_version = 2' to remove this warning. **" << std::endl;
+}
+
+void dccl::Codec::log_validation_failure(const google::protobuf::Descriptor* desc, const Exception& e) const
+{
+    try
+    {
+        info(desc, &dlog);
+    }
+    catch(Exception& e)
+    { }
+    
+    dlog.is(DEBUG1) && dlog << "Message " << desc->full_name() << ": " << desc << " failed validation. Reason: "
+                            << e.what() <<  "\n"
+                            << "If possible, information about the Message are printed above. " << std::endl;
+}
+
+unsigned dccl::Codec::validate(const google::protobuf::Descriptor* desc, int user_id) const
+{
+    if(user_id <0 && !desc->options().GetExtension(dccl::msg).has_id())
+        throw(Exception("Missing message option `(dccl.msg).id`. Specify a unique id (e.g. 3) in the body of your .proto message using \"option (dccl.msg).id = 3\""));
+    if(!desc->options().GetExtension(dccl::msg).has_max_bytes())
+        throw(Exception("Missing message option `(dccl.msg).max_bytes`. Specify a maximum (encoded) message size in bytes (e.g. 32) in the body of your .proto message using \"option (dccl.msg).max_bytes = 32\""));
+
+    boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
+
+    unsigned dccl_id = (user_id < 0) ? id(desc) : user_id;
+    unsigned head_size_bits, body_size_bits;
+    codec->base_max_size(&head_size_bits, desc, HEAD);
+    codec->base_max_size(&body_size_bits, desc, BODY);
+
+    unsigned id_bits = 0;
+    id_codec()->field_size(&id_bits, dccl_id, 0);
+    head_size_bits += id_bits;
+
+    const unsigned byte_size = ceil_bits2bytes(head_size_bits) + ceil_bits2bytes(body_size_bits);
+
+    if(byte_size > desc->options().GetExtension(dccl::msg).max_bytes())
+        throw(Exception("Actual maximum size of message exceeds allowed maximum (dccl.max_bytes). Tighten bounds, remove fields, improve codecs, or increase the allowed dccl.max_bytes"));
+
+    codec->base_validate(desc, HEAD);
+    codec->base_validate(desc, BODY);
+
+    return dccl_id;
+}
+
+// shared by the load_all() threads
+struct dccl::Codec::LoadAllJob
+{
+    const Codec* codec;
+    const std::vector<const google::protobuf::Descriptor*>* descs;
+    std::vector<unsigned> ids;
+    std::vector<std::string> errors;
+    pthread_mutex_t next_mutex;
+    std::size_t next;
+};
+
+void* dccl::Codec::load_all_thread(void* job_ptr)
+{
+    LoadAllJob& job = *static_cast<LoadAllJob*>(job_ptr);
+    for(;;)
+    {
+        pthread_mutex_lock(&job.next_mutex);
+        std::size_t i = job.next++;
+        pthread_mutex_unlock(&job.next_mutex);
+        
+        if(i >= job.descs->size())
+            return 0;
+        
+        // each thread writes only its own elements of ids and errors
         try
         {
-            info(desc, &dlog);
+            job.ids[i] = job.codec->validate((*job.descs)[i], -1);
         }
-        catch(Exception& e)
-        { }
+        catch(std::exception& e)
+        {
+            job.errors[i] = e.what();
+            // an empty what() must still count as a failure
+            if(job.errors[i].empty())
+                job.errors[i] = "unknown error";
+        }
+    }
+}
 
-        dlog.is(DEBUG1) && dlog << "Message " << desc->full_name() << ": " << desc << " failed validation. Reason: "
-                                << e.what() <<  "\n"
-                                << "If possible, information about the Message are printed above. " << std::endl;
+void dccl::Codec::load_all(const std::vector<const google::protobuf::Descriptor*>& descs, unsigned num_threads /* = 0 */)
+{
+    for(std::size_t i = 0, n = descs.size(); i < n; ++i)
+        warn_codec_version(descs[i]);
+    
+    LoadAllJob job;
+    job.codec = this;
+    job.descs = &descs;
+    job.ids.resize(descs.size());
+    job.errors.resize(descs.size());
+    job.next = 0;
+    pthread_mutex_init(&job.next_mutex, 0);
+
+    if(num_threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? online : 1;
+    }
+    num_threads = std::min<std::size_t>(num_threads, descs.size());
+    
+    // the calling thread validates too
+    std::vector<pthread_t> threads;
+    for(unsigned t = 1; t < num_threads; ++t)
+    {
+        pthread_t thread;
+        if(pthread_create(&thread, 0, &Codec::load_all_thread, &job) == 0)
+            threads.push_back(thread);
+    }
+    load_all_thread(&job);
+    for(std::size_t t = 0, n = threads.size(); t < n; ++t)
+        pthread_join(threads[t], 0);
+    pthread_mutex_destroy(&job.next_mutex);
+
+    // register the valid messages, checking for clashing ids within descs and with those already loaded
+    std::string errors;
+    int num_errors = 0;
+    for(std::size_t i = 0, n = descs.size(); i < n; ++i)
+    {
+        const Descriptor* desc = descs[i];
+        if(job.errors[i].empty())
+        {
+            unsigned dccl_id = job.ids[i];
+            if(id2desc_.count(dccl_id) && desc != id2desc_.find(dccl_id)->second)
+                job.errors[i] = "`dccl id` " + boost::lexical_cast<std::string>(dccl_id) + " is already in use by Message " + id2desc_.find(dccl_id)->second->full_name();
+            else
+            {
+                id2desc_.insert(std::make_pair(dccl_id, desc));
+                dlog.is(DEBUG1) && dlog << "Successfully validated message of type: " << desc->full_name() << std::endl;
+            }
+        }
 
-        throw;
+        if(!job.errors[i].empty())
+        {
+            log_validation_failure(desc, Exception(job.errors[i]));
+            errors += "\n" + desc->full_name() + ": " + job.errors[i];
+            ++num_errors;
+        }
     }
+    
+    if(num_errors)
+        throw(Exception(boost::lexical_cast<std::string>(num_errors) + " of " + boost::lexical_cast<std::string>(descs.size()) + " messages failed validation:" + errors));
 }
 
 
@@ -433,6 +648,7 @@ unsigned dccl::Codec::size(const google::protobuf::Message& msg, int user_id /*
     boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
 
     unsigned dccl_id = (user_id < 0) ? id(desc) : user_id;
+    internal::FieldProfiler::Scope profiler_scope(profiling_ ? &profile_ : 0);
     unsigned head_size_bits;
     codec->base_size(&head_size_bits, msg, HEAD);
 
@@ -564,44 +780,114 @@ void dccl::Codec::info(const google::protobuf::Descriptor* desc, std::ostream* p
 }
 
 
-void dccl::Codec::encrypt(std::string* s, const std::string& nonce /* message head */)
-{
 #if DCCL_HAS_CRYPTOPP
-    using namespace CryptoPP;
+// Holds the keyed AES cipher and a CTR mode object that uses it, so the AES key schedule is
+// only run once per passphrase. Only the IV (the SHA256 hash of the message head) changes per message.
+class dccl::Codec::CryptoContext
+{
+  public:
+    CryptoContext(const std::string& key)
+        : cipher_((const unsigned char*)key.data(), key.size())
+    {
+        unsigned char zero_iv[CryptoPP::AES::BLOCKSIZE] = { 0 };
+        ctr_.SetCipherWithIV(cipher_, zero_iv);
+    }
 
-    std::string iv;
-    SHA256 hash;
-    StringSource unused(nonce, true, new HashFilter(hash, new StringSink(iv)));
+    // CTR mode: encryption and decryption are the same operation (XOR with the keystream),
+    // performed in place on [begin, end)
+    void process(char* begin, char* end, const char* nonce_begin, const char* nonce_end)
+    {
+        unsigned char iv[CryptoPP::SHA256::DIGESTSIZE];
+        CryptoPP::SHA256().CalculateDigest(iv, (const unsigned char*)nonce_begin, nonce_end - nonce_begin);
+        ctr_.Resynchronize(iv, CryptoPP::AES::BLOCKSIZE);
 
-    CTR_Mode<AES>::Encryption encryptor;
-    encryptor.SetKeyWithIV((byte*)crypto_key_.c_str(), crypto_key_.size(), (byte*)iv.c_str());
+        if(begin != end)
+            ctr_.ProcessData((unsigned char*)begin, (const unsigned char*)begin, end - begin);
+    }
 
-    std::string cipher;
-    StreamTransformationFilter in(encryptor, new StringSink(cipher));
-    in.Put((byte*)s->c_str(), s->size());
-    in.MessageEnd();
-    *s = cipher;
+    // as process() but for many messages: all the counter blocks are laid out together
+    // and run through the cipher in a single call so it can process blocks in parallel
+    void process_many(const std::vector<CryptoRange>& ranges)
+    {
+        const unsigned block_size = CryptoPP::AES::BLOCKSIZE;
+        
+        std::vector<CryptoRange>::size_type total_blocks = 0;
+        for(std::vector<CryptoRange>::const_iterator it = ranges.begin(), end = ranges.end(); it != end; ++it)
+            total_blocks += ((it->end - it->begin) + block_size - 1) / block_size;
+
+        if(total_blocks == 0)
+            return;
+        
+        counters_.resize(total_blocks*block_size);
+        keystream_.resize(total_blocks*block_size);
+
+        unsigned char* counter = &counters_[0];
+        for(std::vector<CryptoRange>::const_iterator it = ranges.begin(), end = ranges.end(); it != end; ++it)
+        {
+            unsigned char iv[CryptoPP::SHA256::DIGESTSIZE];
+            CryptoPP::SHA256().CalculateDigest(iv, (const unsigned char*)it->nonce_begin, it->nonce_end - it->nonce_begin);
+
+            for(int i = 0, n = ((it->end - it->begin) + block_size - 1) / block_size; i < n; ++i)
+            {
+                std::copy(iv, iv + block_size, counter);
+                counter += block_size;
+
+                // same big-endian increment of the whole block as CryptoPP's CTR_Mode
+                for(int j = block_size - 1; j >= 0 && ++iv[j] == 0; --j) {}
+            }
+        }
+
+        cipher_.AdvancedProcessBlocks(&counters_[0], 0, &keystream_[0], keystream_.size(), CryptoPP::BlockTransformation::BT_AllowParallel);
+
+        const unsigned char* keystream = &keystream_[0];
+        for(std::vector<CryptoRange>::const_iterator it = ranges.begin(), end = ranges.end(); it != end; ++it)
+        {
+            std::ptrdiff_t size = it->end - it->begin;
+            for(std::ptrdiff_t i = 0; i < size; ++i)
+                it->begin[i] ^= keystream[i];
+            keystream += ((size + block_size - 1) / block_size) * block_size;
+        }
+    }
+
+  private:
+    CryptoPP::AES::Encryption cipher_;
+    CryptoPP::CTR_Mode_ExternalCipher::Encryption ctr_;
+
+    // reused by process_many()
+    std::vector<unsigned char> counters_;
+    std::vector<unsigned char> keystream_;
+};
 #endif
-}
 
-void dccl::Codec::decrypt(std::string* s, const std::string& nonce)
+void dccl::Codec::encrypt(char* begin, char* end, const char* nonce_begin /* message head */, const char* nonce_end)
 {
 #if DCCL_HAS_CRYPTOPP
-    using namespace CryptoPP;
-
-    std::string iv;
-    SHA256 hash;
-    StringSource unused(nonce, true, new HashFilter(hash, new StringSink(iv)));
+    if(crypto_context_)
+        crypto_context_->process(begin, end, nonce_begin, nonce_end);
+#endif
+}
 
-    CTR_Mode<AES>::Decryption decryptor;
-    decryptor.SetKeyWithIV((byte*)crypto_key_.c_str(), crypto_key_.size(), (byte*)iv.c_str());
+void dccl::Codec::decrypt(char* begin, char* end, const char* nonce_begin, const char* nonce_end)
+{
+#if DCCL_HAS_CRYPTOPP
+    if(crypto_context_)
+        crypto_context_->process(begin, end, nonce_begin, nonce_end);
+#endif
+}
 
-    std::string recovered;
+void dccl::Codec::encrypt_many(const std::vector<CryptoRange>& ranges)
+{
+#if DCCL_HAS_CRYPTOPP
+    if(crypto_context_)
+        crypto_context_->process_many(ranges);
+#endif
+}
 
-    StreamTransformationFilter out(decryptor, new StringSink(recovered));
-    out.Put((byte*)s->c_str(), s->size());
-    out.MessageEnd();
-    *s = recovered;
+void dccl::Codec::decrypt_many(const std::vector<CryptoRange>& ranges)
+{
+#if DCCL_HAS_CRYPTOPP
+    if(crypto_context_)
+        crypto_context_->process_many(ranges);
 #endif
 }
 
@@ -642,13 +928,15 @@ void dccl::Codec::set_crypto_passphrase(const std::string& passphrase, const std
 {
     if(!crypto_key_.empty())
         crypto_key_.clear();
+    crypto_context_.reset();
     skip_crypto_ids_.clear();
 
 #if DCCL_HAS_CRYPTOPP
     using namespace CryptoPP;
 
-    SHA256 hash;
-    StringSource unused(passphrase, true, new HashFilter(hash, new StringSink(crypto_key_)));
+    crypto_key_.resize(SHA256::DIGESTSIZE);
+    SHA256().CalculateDigest((byte*)&crypto_key_[0], (const byte*)passphrase.data(), passphrase.size());
+    crypto_context_.reset(new CryptoContext(crypto_key_));
 
     dlog.is(DEBUG1) && dlog << "Cryptography enabled with given passphrase" << std::endl;
 #else
@@ -679,6 +967,244 @@ void dccl::Codec::info_all(std::ostream* param_os /*= 0 */) const
 
 }
 
+namespace dccl
+{
+    // ReferenceTimeFunction for Codec::set_reference_time()
+    struct FixedReferenceTime
+    {
+        FixedReferenceTime(double seconds) : seconds_(seconds) { }
+        double operator()() const { return seconds_; }
+    private:
+        double seconds_;
+    };
+}
+
+void dccl::Codec::set_reference_time(double seconds)
+{
+    reference_time_function_ = FixedReferenceTime(seconds);
+}
+
+void dccl::Codec::write_profile(std::ostream* param_os /*= 0 */) const
+{
+    std::ostream* os = (param_os) ? param_os : &dlog;
+
+    if(param_os || dlog.is(INFO))
+    {
+        std::string profile_str = "DCCL Field Profile";
+        std::string profile_guard = std::string((full_width-profile_str.size())/2, '|');
+        *os << profile_guard << " " << profile_str << " " << profile_guard << std::endl;
+        *os << "Times are the average per call in nanoseconds; bits are the average per call." << std::endl;
+
+        const int path_width = 28, column_width = 10;
+        char fill = os->fill(' ');
+        for(CodecProfile::const_iterator it = profile_.begin(), end = profile_.end(); it != end; ++it)
+        {
+            std::string guard = std::string((full_width-it->first.size())/2, '=');
+            *os << guard << " " << it->first << " " << guard << std::endl;
+            *os << std::left << std::setw(path_width) << "field" << std::right
+                << std::setw(column_width) << "encodes" << std::setw(column_width) << "enc bits"
+                << std::setw(column_width) << "enc ns"
+                << std::setw(column_width) << "decodes" << std::setw(column_width) << "dec bits"
+                << std::setw(column_width) << "dec ns"
+                << std::setw(column_width) << "sizes" << std::setw(column_width) << "size ns" << "\n";
+
+            for(std::map<std::string, FieldProfile>::const_iterator jt = it->second.begin(), jend = it->second.end(); jt != jend; ++jt)
+            {
+                const FieldProfile& p = jt->second;
+                *os << std::left << std::setw(path_width) << jt->first << std::right << std::fixed << std::setprecision(1)
+                    << std::setw(column_width) << p.encode.count
+                    << std::setw(column_width) << p.encode.average_bits()
+                    << std::setw(column_width) << p.encode.average_nanoseconds()
+                    << std::setw(column_width) << p.decode.count
+                    << std::setw(column_width) << p.decode.average_bits()
+                    << std::setw(column_width) << p.decode.average_nanoseconds()
+                    << std::setw(column_width) << p.size.count
+                    << std::setw(column_width) << p.size.average_nanoseconds() << "\n";
+            }
+        }
+        os->unsetf(std::ios::floatfield);
+        os->fill(fill);
+        *os << std::flush;
+    }
+}
+
+// 64-bit FNV-1a: stable across builds and platforms, unlike boost::hash
+static dccl::uint64 fnv1a_hash(const std::string& data)
+{
+    dccl::uint64 hash = 14695981039346656037ULL;
+    for(std::string::const_iterator it = data.begin(), end = data.end(); it != end; ++it)
+    {
+        hash ^= static_cast<unsigned char>(*it);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// appends the descriptors of desc and the types of its fields, and the field codecs they resolve to, to data
+// (parents holds the message types enclosing desc, so that a recursive schema is not followed forever)
+static void append_fingerprint_data(const Descriptor* desc,
+                                    bool has_codec_group, const std::string& codec_group,
+                                    const std::string& prefix,
+                                    std::set<const void*>* described,
+                                    std::set<const Descriptor*>* parents,
+                                    std::string* data,
+                                    std::vector<std::pair<std::string, std::string> >* field_codecs)
+{
+    parents->insert(desc);
+    if(described->insert(desc).second)
+    {
+        google::protobuf::DescriptorProto desc_proto;
+        desc->CopyTo(&desc_proto);
+        *data += desc->full_name();
+        *data += desc_proto.SerializeAsString();
+    }
+    
+    for(int i = 0, n = desc->field_count(); i < n; ++i)
+    {
+        const FieldDescriptor* field = desc->field(i);
+        boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(field, has_codec_group, codec_group);
+        const std::string field_name = prefix + field->name();
+
+        // the implementing class, in case a different codec was added under the same name
+        *data += field_name + ":" + codec->name() + ":" + typeid(*codec).name() + ";";
+        if(field_codecs)
+            field_codecs->push_back(std::make_pair(field_name, codec->name()));
+
+        if(field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+        {
+            if(parents->count(field->message_type()))
+                *data += field_name + ":recursive;";
+            else
+                append_fingerprint_data(field->message_type(), has_codec_group, codec_group,
+                                        field_name + ".", described, parents, data, field_codecs);
+        }
+        else if(field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+                described->insert(field->enum_type()).second)
+        {
+            google::protobuf::EnumDescriptorProto enum_proto;
+            field->enum_type()->CopyTo(&enum_proto);
+            *data += field->enum_type()->full_name();
+            *data += enum_proto.SerializeAsString();
+        }
+    }
+    parents->erase(desc);
+}
+
+dccl::uint64 dccl::Codec::fingerprint(const google::protobuf::Descriptor* desc, std::vector<std::pair<std::string, std::string> >* field_codecs /* = 0 */) const
+{
+    boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
+    boost::shared_ptr<FieldCodecBase> id = id_codec();
+    std::string data = codec->name() + ":" + typeid(*codec).name() + ";" +
+        id->name() + ":" + typeid(*id).name() + ";" + VERSION_STRING + ";";
+
+    const dccl::DCCLMessageOptions& msg_options = desc->options().GetExtension(dccl::msg);
+    bool has_codec_group = msg_options.has_codec_group() || msg_options.has_codec_version();
+    
+    std::set<const void*> described;
+    std::set<const Descriptor*> parents;
+    append_fingerprint_data(desc, has_codec_group, FieldCodecBase::codec_group(desc), "",
+                            &described, &parents, &data, field_codecs);
+    return fnv1a_hash(data);
+}
+
+void dccl::Codec::write_snapshot(const std::string& snapshot_path) const
+{
+    CodecSnapshot snapshot;
+    snapshot.set_id_codec(id_codec_);
+    
+    for(std::map<int32, const google::protobuf::Descriptor*>::const_iterator it = id2desc_.begin(), n = id2desc_.end(); it != n; ++it)
+    {
+        const Descriptor* desc = it->second;
+        CodecSnapshot::LoadedMessage* snapshot_msg = snapshot.add_message();
+        snapshot_msg->set_full_name(desc->full_name());
+        snapshot_msg->set_dccl_id(it->first);
+        if(!desc->options().GetExtension(dccl::msg).has_id() ||
+           desc->options().GetExtension(dccl::msg).id() != it->first)
+            snapshot_msg->set_user_id(true);
+
+        std::vector<std::pair<std::string, std::string> > field_codecs;
+        snapshot_msg->set_fingerprint(fingerprint(desc, &field_codecs));
+        for(int i = 0, m = field_codecs.size(); i < m; ++i)
+        {
+            CodecSnapshot::LoadedMessage::Field* field = snapshot_msg->add_field();
+            field->set_name(field_codecs[i].first);
+            field->set_codec(field_codecs[i].second);
+        }
+
+        unsigned head_size_bits = 0, body_size_bits = 0, id_bits = 0;
+        boost::shared_ptr<FieldCodecBase> codec = FieldCodecManager::find(desc);
+        codec->base_max_size(&head_size_bits, desc, HEAD);
+        codec->base_max_size(&body_size_bits, desc, BODY);
+        id_codec()->field_size(&id_bits, static_cast<uint32>(it->first), 0);
+        snapshot_msg->set_head_size_bits(head_size_bits + id_bits);
+        snapshot_msg->set_body_size_bits(body_size_bits);
+    }
+
+    std::ofstream fout(snapshot_path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!fout.is_open() || !snapshot.SerializeToOstream(&fout))
+        throw(Exception("Failed to write DCCL codec snapshot: " + snapshot_path));
+}
+
+bool dccl::Codec::load_snapshot(const std::string& snapshot_path)
+{
+    std::ifstream fin(snapshot_path.c_str(), std::ios::binary);
+    CodecSnapshot snapshot;
+    if(!fin.is_open() || !snapshot.ParseFromIstream(&fin))
+    {
+        dlog.is(DEBUG1) && dlog << "Could not read DCCL codec snapshot: " << snapshot_path << std::endl;
+        return false;
+    }
+    
+    if(snapshot.id_codec() != id_codec_)
+    {
+        dlog.is(DEBUG1) && dlog << "DCCL codec snapshot " << snapshot_path << " was written with id codec " << snapshot.id_codec() << ", not " << id_codec_ << std::endl;
+        return false;
+    }
+
+    for(int i = 0, n = snapshot.message_size(); i < n; ++i)
+    {
+        const CodecSnapshot::LoadedMessage& snapshot_msg = snapshot.message(i);
+        const Descriptor* desc = DynamicProtobufManager::find_descriptor(snapshot_msg.full_name());
+        if(!desc)
+            throw(Exception("Message " + snapshot_msg.full_name() + " in DCCL codec snapshot " + snapshot_path + " is not known. Load it (e.g. by linking its generated code or loading its .proto file) before calling load_snapshot()"));
+
+        const int32 dccl_id = snapshot_msg.dccl_id();
+        bool unchanged = false;
+        try
+        {
+            std::vector<std::pair<std::string, std::string> > field_codecs;
+            unchanged = (fingerprint(desc, &field_codecs) == snapshot_msg.fingerprint());
+
+            // the fingerprint covers the field codecs (and so the sizes), but compare the codecs too in case of a hash collision or an edited snapshot
+            if(unchanged)
+            {
+                unchanged = (static_cast<int>(field_codecs.size()) == snapshot_msg.field_size());
+                for(int j = 0, m = snapshot_msg.field_size(); unchanged && j < m; ++j)
+                {
+                    unchanged = (field_codecs[j].first == snapshot_msg.field(j).name() &&
+                                 field_codecs[j].second == snapshot_msg.field(j).codec());
+                }
+            }
+        }
+        catch(Exception& e)
+        {
+            // e.g. a field codec is no longer available: load() will give the full reason
+        }
+        
+        if(unchanged && !(id2desc_.count(dccl_id) && desc != id2desc_.find(dccl_id)->second))
+        {
+            id2desc_.insert(std::make_pair(dccl_id, desc));
+            dlog.is(DEBUG1) && dlog << "Loaded message of type: " << desc->full_name() << " from snapshot" << std::endl;
+        }
+        else
+        {
+            dlog.is(DEBUG1) && dlog << "Message " << desc->full_name() << " has changed since the snapshot was written, validating" << std::endl;
+            load(desc, snapshot_msg.user_id() ? dccl_id : -1);
+        }
+    }
+    return true;
+}
+
 void dccl::Codec::set_id_codec(const std::string& id_codec_name)
 {
     // we must reload messages after setting the id_codec
@@ -22,6 +22,8 @@
 #ifndef DCCL20091211H
 #define DCCL20091211H
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <set>
 #include <map>
@@ -52,6 +54,8 @@ namespace dccl
     class FieldCodec;
   
     /// \brief The Dynamic CCL enCODer/DECoder. This is the main class you will use to load, encode and decode DCCL messages. Many users will not need any other DCCL classes than this one.
+    ///
+    /// A Codec (including its encryption state) must not be used from more than one thread at a time; use one Codec per thread instead.
     /// \ingroup dccl_api
     class Codec
     {
@@ -115,6 +119,14 @@ namespace dccl
         /// \throw dccl::Exception if message is invalid.
         void load(const google::protobuf::Descriptor* desc, int user_id = - 1);
 
+        /// \brief Load and validate many messages at once, validating them in parallel.
+        ///
+        /// Each message is validated as by load(desc), but on up to num_threads threads. Messages that pass validation are then loaded together, so the messages which are valid are loaded even if others fail. Any custom field codecs used must be safe to validate from more than one thread at a time (the default codecs are).
+        /// \param descs Descriptors of the messages to load. The DCCL id of each is taken from (dccl.msg).id.
+        /// \param num_threads Maximum number of threads to validate on (including the calling thread). 0 uses one per online processor.
+        /// \throw Exception listing every message that failed validation (or whose DCCL id is already in use) and why
+        void load_all(const std::vector<const google::protobuf::Descriptor*>& descs, unsigned num_threads = 0);
+        
         /// \brief An alterative form for unloading messages for message types <i>not</i> known at compile-time ("dynamic").
         ///
         /// \param desc The Google Protobuf "Descriptor" (meta-data) of the message to validate.
@@ -146,6 +158,19 @@ namespace dccl
         /// \param mode "true" sets strict mode, "false" disables strict mode
         void set_strict(bool mode) { strict_ = mode; }
         
+        /// \brief Enable (or disable) profiling, which collects the call counts, cumulative time and bits of encode(), decode() and size() for each message type and field (see profile()). Off by default.
+        void set_profiling(bool enable) { profiling_ = enable; }
+
+        /// \brief Set the function giving "now" (seconds since the UNIX epoch) for decoding fields that only encode part of the time, such as the time of day encoded by dccl.time2. This is called at most once per decoded message.
+        ///
+        /// \param f Reference time function (e.g. the time of a simulation). If empty (the default), the system clock is used.
+        void set_reference_time_function(FieldCodecBase::ReferenceTimeFunction f) { reference_time_function_ = f; }
+
+        /// \brief Decode fields that only encode part of the time relative to a fixed time, rather than the system clock (e.g. the time a log that is being replayed was recorded).
+        ///
+        /// \param seconds Reference time (seconds since the UNIX epoch).
+        void set_reference_time(double seconds);
+        
         //@}
             
         /// \name Informational Methods.
@@ -174,6 +199,17 @@ namespace dccl
         ///
         /// \param os Pointer to a stream to write this information (if 0, writes to dccl::dlog)        
         void info_all(std::ostream* os = 0) const;
+
+        /// \brief The profile collected while profiling was enabled (see set_profiling()), since the last call to reset_profile()
+        const CodecProfile& profile() const { return profile_; }
+
+        /// \brief Clears the collected profile
+        void reset_profile() { profile_.clear(); }
+        
+        /// \brief Writes a human readable table of the collected profile: for each message type and field, the average bits and time of each call of encode, decode and size.
+        ///
+        /// \param os Pointer to a stream to write this information (if 0, writes to dccl::dlog)        
+        void write_profile(std::ostream* os = 0) const;
             
         /// \brief Gives the DCCL id (defined by the custom message option extension "(dccl.msg).id" in the .proto file). This ID is used on the wire to unique identify incoming message types.
         ///
@@ -221,6 +257,21 @@ namespace dccl
 
         /// \brief Provides a map of all loaded DCCL IDs to the equivalent Protobuf descriptor
         const std::map<int32, const google::protobuf::Descriptor*>& loaded() const { return id2desc_; }
+
+        /// \brief Write the validated state of all loaded messages (ids, field codecs, a fingerprint and the maximum head and body sizes of each) to a file, for later use by load_snapshot()
+        ///
+        /// The maximum sizes are only written for other tools reading the snapshot: load_snapshot() does not recompute or check them.
+        /// \throw Exception if the file cannot be written
+        void write_snapshot(const std::string& snapshot_path) const;
+
+        /// \brief Load the messages in a snapshot written by write_snapshot(), skipping validation for those whose fingerprint is unchanged.
+        ///
+        /// The fingerprint covers the Protobuf descriptors of the message and the types it uses, the field codecs they resolve to, and the identifier codec. Only the ids, field codec names and fingerprints stored in the snapshot are checked: the field codec names are compared against the current ones as well, in case of a hash collision. Messages whose fingerprint or field codecs differ are loaded (and validated) normally using load().
+        ///
+        /// Messages loaded from the snapshot are not validated, so the validate() of their field codecs is not called. Custom field codecs that rely on validate() for side effects (e.g. setting up state used while encoding) must not be used with snapshots.
+        /// \return false if the snapshot cannot be read or was written by a Codec with a different identifier codec (no messages are loaded), true otherwise
+        /// \throw Exception if a message in the snapshot is unknown to DynamicProtobufManager, or fails validation
+        bool load_snapshot(const std::string& snapshot_path);
         
         //@}
             
@@ -278,6 +329,22 @@ namespace dccl
         /// \throw Exception if message cannot be decoded.
         void decode(std::string* bytes, google::protobuf::Message* msg);
 
+        /// \brief Encodes many DCCL messages at once, one encoded message per element of msgs.
+        ///
+        /// The result is identical to calling encode() on each message, but when encryption is enabled (set_crypto_passphrase()) the keystream for all the messages is generated in a single pass, which is considerably faster for large batches.
+        /// \param bytes Pointer to vector to store encoded messages (any previous contents are replaced)
+        /// \param msgs Messages to encode (must already have been validated)
+        /// \throw Exception if any message cannot be encoded.
+        void encode_many(std::vector<std::string>* bytes, const std::vector<const google::protobuf::Message*>& msgs);
+
+        /// \brief Decodes many DCCL messages at once, one decoded message per element of bytes.
+        ///
+        /// The result is identical to calling decode() on each encoded message, but when encryption is enabled (set_crypto_passphrase()) the keystream for all the messages is generated in a single pass, which is considerably faster for large batches.
+        /// \param bytes Encoded messages, each as returned by encode()
+        /// \param msgs Pointer to vector to store decoded messages (any previous contents are replaced). The message types are determined from the DCCL id of each message, which must already be loaded.
+        /// \throw Exception if any message cannot be decoded.
+        void decode_many(const std::vector<std::string>& bytes, std::vector<boost::shared_ptr<google::protobuf::Message> >* msgs);
+
         /// \brief An alterative form for decoding messages for message types <i>not</i> known at compile-time ("dynamic").
         ///
         /// \tparam GoogleProtobufMessagePointer anything that acts like a pointer (has operator*) to a google::protobuf::Message (smart pointers like boost::shared_ptr included)
@@ -355,8 +422,44 @@ namespace dccl
 
         void encode_internal(const google::protobuf::Message& msg, bool header_only, Bitset& header_bits, Bitset& body_bits, int user_id);
 
-        void encrypt(std::string* s, const std::string& nonce);
-        void decrypt(std::string* s, const std::string& nonce);
+        // region of an encoded message to encrypt or decrypt in place, and the message head to generate the IV from
+        struct CryptoRange
+        {
+            char* begin;
+            char* end;
+            const char* nonce_begin;
+            const char* nonce_end;
+        };
+        
+        // writes the encoded (and if applicable, encrypted) head and body to bytes, which must be large enough to hold both.
+        // If deferred_crypto is given, the body is not encrypted but is instead added to deferred_crypto for a later call to encrypt_many()
+        void write_encoded(char* bytes, const google::protobuf::Message& msg, bool header_only, Bitset& head_bits, Bitset& body_bits, int user_id, std::vector<CryptoRange>* deferred_crypto = 0);
+
+        template <typename CharIterator>
+            CharIterator decode_internal(CharIterator begin, CharIterator end, google::protobuf::Message* msg, bool header_only, bool body_decrypted);
+        
+        // checks that desc is a valid DCCL message, throwing Exception if not, and returns its DCCL id.
+        // Doesn't touch the Codec's state, so may be called from many threads at once.
+        unsigned validate(const google::protobuf::Descriptor* desc, int user_id) const;
+        void warn_codec_version(const google::protobuf::Descriptor* desc) const;
+        void log_validation_failure(const google::protobuf::Descriptor* desc, const Exception& e) const;
+
+        struct LoadAllJob;
+        static void* load_all_thread(void* job);
+        
+        // hash of everything load() validates for a message (see load_snapshot()). If given, field_codecs is filled with the (field name, codec name) of every field
+        uint64 fingerprint(const google::protobuf::Descriptor* desc, std::vector<std::pair<std::string, std::string> >* field_codecs = 0) const;
+        
+        // size of the head (including the id) of a loaded message, in bytes
+        unsigned head_byte_size(const google::protobuf::Descriptor* desc, unsigned dccl_id) const;
+
+        // encrypt or decrypt [begin, end) in place, using [nonce_begin, nonce_end) (the message head) to generate the IV
+        void encrypt(char* begin, char* end, const char* nonce_begin, const char* nonce_end);
+        void decrypt(char* begin, char* end, const char* nonce_begin, const char* nonce_end);
+
+        // as encrypt/decrypt but for many messages at once
+        void encrypt_many(const std::vector<CryptoRange>& ranges);
+        void decrypt_many(const std::vector<CryptoRange>& ranges);
 
         void set_default_codecs();
 
@@ -370,8 +473,22 @@ namespace dccl
         // SHA256 hash of the crypto passphrase
         std::string crypto_key_;
 
+        // AES cipher keyed with crypto_key_ (defined in codec.cpp, as it depends on Crypto++)
+        class CryptoContext;
+        boost::shared_ptr<CryptoContext> crypto_context_;
+
+        // encrypted messages up to this size are copied to the stack for in place decryption by decode()
+        enum { CRYPTO_STACK_BUFFER_BYTES = 256 };
+
         // strict mode setting
         bool strict_;
+
+        // collect profile_ during encode, decode and size
+        bool profiling_;
+        CodecProfile profile_;
+
+        // "now" for decoding partial time fields (system clock if empty)
+        FieldCodecBase::ReferenceTimeFunction reference_time_function_;
         
 	// set of DCCL IDs *not* to encrypt        
 	std::set<unsigned> skip_crypto_ids_;
@@ -445,6 +562,12 @@ unsigned dccl::Codec::id(CharIterator begin, CharIterator end) const
 
 template <typename CharIterator>
 CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, google::protobuf::Message* msg, bool header_only /*= false*/)
+{
+    return decode_internal(begin, end, msg, header_only, false);
+}
+
+template <typename CharIterator>
+CharIterator dccl::Codec::decode_internal(CharIterator begin, CharIterator end, google::protobuf::Message* msg, bool header_only, bool body_decrypted)
 {
     try
     {
@@ -493,6 +616,8 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, google::p
 
             internal::MessageStack msg_stack;
             msg_stack.push(msg->GetDescriptor());
+            internal::FieldProfiler::Scope profiler_scope(profiling_ ? &profile_ : 0);
+            FieldCodecBase::ReferenceTimeRAII reference_time_scope(&reference_time_function_);
 
             codec->base_decode(&head_bits, msg, HEAD);
             dlog.is(logger::DEBUG2, logger::DECODE) && dlog  << "after header decode, message is: " << *msg << std::endl;
@@ -508,13 +633,25 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, google::p
                 dlog.is(logger::DEBUG3, logger::DECODE) && dlog  << "Encrypted Body (hex): " << hex_encode(head_bytes_end, end) << std::endl;
 
                 Bitset body_bits;
-                if(!crypto_key_.empty() && !skip_crypto_ids_.count(this_id))
+                if(!body_decrypted && !crypto_key_.empty() && !skip_crypto_ids_.count(this_id))
                 {
-                    std::string head_bytes(begin, head_bytes_end);
-                    std::string body_bytes(head_bytes_end, end);
-                    decrypt(&body_bytes, head_bytes);
-                    dlog.is(logger::DEBUG3, logger::DECODE) && dlog  << "Unencrypted Body (hex): " << hex_encode(body_bytes) << std::endl;
-                    body_bits.from_byte_stream(body_bytes.begin(), body_bytes.end());
+                    // decrypt a local copy (on the stack unless the message is unusually large)
+                    // so that decode does not write to the Codec
+                    char stack_buffer[CRYPTO_STACK_BUFFER_BYTES];
+                    std::string heap_buffer;
+                    const std::size_t message_size = std::distance(begin, end);
+                    char* head = stack_buffer;
+                    if(message_size > sizeof(stack_buffer))
+                    {
+                        heap_buffer.resize(message_size);
+                        head = &heap_buffer[0];
+                    }
+                    std::copy(begin, end, head);
+                    char* body = head + head_size_bytes;
+                    char* body_end = head + message_size;
+                    decrypt(body, body_end, head, body);
+                    dlog.is(logger::DEBUG3, logger::DECODE) && dlog  << "Unencrypted Body (hex): " << hex_encode(body, body_end) << std::endl;
+                    body_bits.from_byte_stream(body, body_end);
                 }
                 else
                 {
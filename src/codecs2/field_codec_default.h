@@ -260,9 +260,7 @@ namespace dccl
             TimeType post_decode(const time_wire_type& encoded_time) {
 
                 int64 max_secs = (int64)max();
-                timeval t;
-                gettimeofday(&t, 0);
-                int64 now = t.tv_sec;
+                int64 now = std::floor(FieldCodecBase::reference_time());
                 int64 daystart = now - (now % max_secs);
                 int64 today_time = now - daystart;
 
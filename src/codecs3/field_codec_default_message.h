@@ -34,7 +34,7 @@ namespace dccl
         /// \brief Provides the default codec for encoding a base Google Protobuf message or an embedded message by calling the appropriate field codecs for every field.
         class DefaultMessageCodec : public FieldCodecBase
         {
-          private:
+          protected:
             
             void any_encode(Bitset* bits, const boost::any& wire_value);
             void any_decode(Bitset* bits, boost::any* wire_value); 
@@ -0,0 +1,145 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FIELD_CODEC_GENERATED_20261019H
+#define FIELD_CODEC_GENERATED_20261019H
+
+#include <algorithm>
+
+#include <boost/numeric/conversion/cast.hpp>
+
+#include "dccl/codecs3/field_codec_default_message.h"
+#include "dccl/internal/field_profiler.h"
+#include "dccl/exception.h"
+
+namespace dccl
+{
+    namespace v3
+    {
+        /// \brief Base class for the message codecs written by protoc-gen-dccl (plugin parameter "generate_codecs").
+        ///
+        /// The generated child encodes the fields of a root ProtobufMessage in straight-line code using the generated accessors, producing exactly the bits of DefaultMessageCodec. Everything the generated code does not cover (the message embedded in another message, a google::protobuf::DynamicMessage of the same type, profiling, validation and info) is passed on to DefaultMessageCodec.
+        /// \tparam ProtobufMessage The generated Protobuf message class
+        template<typename ProtobufMessage>
+            class GeneratedMessageCodec : public DefaultMessageCodec
+        {
+          protected:
+            /// \brief Append the fields of msg in the current part() to bits
+            virtual void encode_fields(Bitset* bits, const ProtobufMessage& msg) = 0;
+            /// \brief Decode the fields of the current part() from bits into msg
+            virtual void decode_fields(Bitset* bits, ProtobufMessage* msg) = 0;
+            /// \brief Size (in bits) of the fields of msg in the current part()
+            virtual unsigned size_fields(const ProtobufMessage& msg) = 0;
+            /// \brief Largest size (in bits) of the fields in the current part()
+            virtual unsigned max_size_fields() = 0;
+            /// \brief Smallest size (in bits) of the fields in the current part()
+            virtual unsigned min_size_fields() = 0;
+
+            /// \brief Append the num_bits least significant bits of value to the most significant end of bits
+            static void append_bits(Bitset* bits, dccl::uint64 value, unsigned num_bits)
+            {
+                for(unsigned i = 0; i < num_bits; ++i)
+                    bits->push_back(i < 64 && (value >> i) & 1);
+            }
+
+            /// \brief Remove num_bits (at most 64) from the least significant end of bits and return them, first getting more bits from the parent Bitset if needed
+            static dccl::uint64 take_bits(Bitset* bits, unsigned num_bits)
+            {
+                if(bits->size() < num_bits)
+                    bits->get_more_bits(num_bits - bits->size());
+
+                dccl::uint64 value = 0;
+                for(unsigned i = 0; i < num_bits; ++i)
+                {
+                    if(bits->front())
+                        value |= static_cast<dccl::uint64>(1) << i;
+                    bits->pop_front();
+                }
+                return value;
+            }
+
+            /// \brief Handle a value outside of (dccl.field).min/max the same way as DefaultNumericFieldCodec: throw in strict mode, otherwise encode zeros
+            void out_of_range(Bitset* bits, unsigned num_bits, int field_number)
+            {
+                const google::protobuf::FieldDescriptor* field = ProtobufMessage::descriptor()->FindFieldByNumber(field_number);
+                if(this->strict())
+                    throw(dccl::OutOfRangeException(std::string("Value exceeds min/max bounds for field: ") + field->DebugString(), field));
+                append_bits(bits, 0, num_bits);
+            }
+
+            /// \brief Refuse more than (dccl.field).max_repeat values, as FieldCodecBase does
+            void check_repeat(int repeat_size, int max_repeat, int field_number)
+            {
+                if(repeat_size > max_repeat)
+                {
+                    const google::protobuf::FieldDescriptor* field = ProtobufMessage::descriptor()->FindFieldByNumber(field_number);
+                    throw(dccl::OutOfRangeException(std::string("Repeated size exceeds max_repeat for field: ") + field->DebugString(), field));
+                }
+            }
+
+          private:
+            // only the root message is generated: embedded messages depend on the (dccl.field) options of the enclosing field
+            bool use_generated()
+            { return !this->this_field() && !internal::FieldProfiler().active(); }
+
+            void any_encode(Bitset* bits, const boost::any& wire_value)
+            {
+                const ProtobufMessage* msg = use_generated() ? cast<const ProtobufMessage, const google::protobuf::Message>(wire_value) : 0;
+                if(msg)
+                    encode_fields(bits, *msg);
+                else
+                    DefaultMessageCodec::any_encode(bits, wire_value);
+            }
+
+            void any_decode(Bitset* bits, boost::any* wire_value)
+            {
+                ProtobufMessage* msg = use_generated() ? cast<ProtobufMessage, google::protobuf::Message>(*wire_value) : 0;
+                if(msg)
+                    decode_fields(bits, msg);
+                else
+                    DefaultMessageCodec::any_decode(bits, wire_value);
+            }
+
+            unsigned any_size(const boost::any& wire_value)
+            {
+                const ProtobufMessage* msg = use_generated() ? cast<const ProtobufMessage, const google::protobuf::Message>(wire_value) : 0;
+                return msg ? size_fields(*msg) : DefaultMessageCodec::any_size(wire_value);
+            }
+
+            unsigned max_size()
+            { return this->this_field() ? DefaultMessageCodec::max_size() : max_size_fields(); }
+
+            unsigned min_size()
+            { return this->this_field() ? DefaultMessageCodec::min_size() : min_size_fields(); }
+
+            template<typename Generated, typename Base>
+                static Generated* cast(const boost::any& wire_value)
+            {
+                Base* const* msg = boost::any_cast<Base*>(&wire_value);
+                return msg ? dynamic_cast<Generated*>(*msg) : 0;
+            }
+        };
+    }
+}
+
+#endif
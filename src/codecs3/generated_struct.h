@@ -0,0 +1,187 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GENERATED_STRUCT_20261019H
+#define GENERATED_STRUCT_20261019H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include <boost/numeric/conversion/cast.hpp>
+
+#include "dccl/common.h"
+#include "dccl/exception.h"
+
+namespace dccl
+{
+    namespace v3
+    {
+        /// \brief Writes encoded bits into a caller provided buffer, for the structs written by protoc-gen-dccl (plugin parameter "generate_structs").
+        ///
+        /// Bits are written least significant first, giving the same bytes as Bitset::to_byte_string(), without allocating.
+        class StructBitWriter
+        {
+          public:
+            /// \param bytes Buffer to write into
+            /// \param max_len Length of bytes
+            StructBitWriter(char* bytes, std::size_t max_len)
+                : bytes_(bytes), max_bits_(max_len * BITS_IN_BYTE), size_(0)
+            { }
+
+            /// \brief Append the num_bits (at most 64) least significant bits of value
+            /// \throw std::length_error if the buffer is too short
+            void append(dccl::uint64 value, unsigned num_bits)
+            {
+                if(size_ + num_bits > max_bits_)
+                    throw(std::length_error("max_len must be >= encoded length"));
+
+                while(num_bits)
+                {
+                    const unsigned offset = size_ % BITS_IN_BYTE;
+                    const unsigned n = std::min(BITS_IN_BYTE - offset, num_bits);
+                    if(!offset)
+                        bytes_[size_ / BITS_IN_BYTE] = 0;
+                    bytes_[size_ / BITS_IN_BYTE] |= static_cast<char>((value & ((1u << n) - 1)) << offset);
+                    value >>= n;
+                    size_ += n;
+                    num_bits -= n;
+                }
+            }
+
+            /// \brief Append zeros up to the next whole byte
+            void pad()
+            { append(0, (BITS_IN_BYTE - size_ % BITS_IN_BYTE) % BITS_IN_BYTE); }
+
+            /// \brief Number of bytes written to so far
+            std::size_t bytes() const
+            { return (size_ + BITS_IN_BYTE - 1) / BITS_IN_BYTE; }
+
+          private:
+            char* bytes_;
+            std::size_t max_bits_;
+            std::size_t size_;
+        };
+
+        /// \brief Reads encoded bits from a buffer, for the structs written by protoc-gen-dccl (plugin parameter "generate_structs").
+        class StructBitReader
+        {
+          public:
+            /// \param bytes Buffer to read from
+            /// \param len Length of bytes
+            StructBitReader(const char* bytes, std::size_t len)
+                : bytes_(bytes), max_bits_(len * BITS_IN_BYTE), size_(0)
+            { }
+
+            /// \brief Remove num_bits (at most 64) and return them as the least significant bits of the result
+            /// \throw Exception if the buffer is too short
+            dccl::uint64 take(unsigned num_bits)
+            {
+                if(size_ + num_bits > max_bits_)
+                    throw(Exception("Not enough bytes to decode message"));
+
+                dccl::uint64 value = 0;
+                for(unsigned shift = 0; num_bits; )
+                {
+                    const unsigned offset = size_ % BITS_IN_BYTE;
+                    const unsigned n = std::min(BITS_IN_BYTE - offset, num_bits);
+                    const unsigned char byte = static_cast<unsigned char>(bytes_[size_ / BITS_IN_BYTE]);
+                    value |= static_cast<dccl::uint64>((byte >> offset) & ((1u << n) - 1)) << shift;
+                    shift += n;
+                    size_ += n;
+                    num_bits -= n;
+                }
+                return value;
+            }
+
+            /// \brief Skip to the start of byte number byte (used to skip the unused bits of the head)
+            void seek_byte(std::size_t byte)
+            { size_ = byte * BITS_IN_BYTE; }
+
+            /// \brief Skip to the next whole byte
+            void pad()
+            { seek_byte(bytes()); }
+
+            /// \brief Number of bytes read from so far
+            std::size_t bytes() const
+            { return (size_ + BITS_IN_BYTE - 1) / BITS_IN_BYTE; }
+
+          private:
+            const char* bytes_;
+            std::size_t max_bits_;
+            std::size_t size_;
+        };
+
+        // the generated code calls these unqualified, so that the same code encodes a protobuf message
+        // (GeneratedMessageCodec members) or a struct (found by argument dependent lookup)
+
+        inline void append_bits(StructBitWriter* bits, dccl::uint64 value, unsigned num_bits)
+        { bits->append(value, num_bits); }
+
+        inline void append_zeros(StructBitWriter* bits, std::size_t num_bits)
+        {
+            for(; num_bits > 64; num_bits -= 64)
+                bits->append(0, 64);
+            bits->append(0, static_cast<unsigned>(num_bits));
+        }
+
+        inline void append_bytes(StructBitWriter* bits, const char* data, std::size_t length)
+        {
+            for(std::size_t i = 0; i < length; ++i)
+                bits->append(static_cast<unsigned char>(data[i]), BITS_IN_BYTE);
+        }
+
+        /// \brief The structs encode as a non-strict Codec: values outside of (dccl.field).min/max are encoded as zeros
+        inline void out_of_range(StructBitWriter* bits, unsigned num_bits, int /*field_number*/)
+        { append_zeros(bits, num_bits); }
+
+        inline dccl::uint64 take_bits(StructBitReader* bits, unsigned num_bits)
+        { return bits->take(num_bits); }
+
+        inline void take_bytes(StructBitReader* bits, char* data, std::size_t length)
+        {
+            for(std::size_t i = 0; i < length; ++i)
+                data[i] = static_cast<char>(bits->take(BITS_IN_BYTE));
+        }
+
+        /// \brief Append id as DefaultIdentifierCodec: one byte for ids up to 127, otherwise two bytes with the least significant bit set
+        inline void append_id(StructBitWriter* bits, unsigned id)
+        {
+            if(id < (1u << 7))
+                bits->append(id << 1, BITS_IN_BYTE);
+            else
+                bits->append((id << 1) | 1, 2 * BITS_IN_BYTE);
+        }
+
+        /// \brief Take an id written by DefaultIdentifierCodec
+        inline unsigned take_id(StructBitReader* bits)
+        {
+            unsigned id = static_cast<unsigned>(bits->take(BITS_IN_BYTE));
+            if(id & 1)
+                id |= static_cast<unsigned>(bits->take(BITS_IN_BYTE)) << BITS_IN_BYTE;
+            return id >> 1;
+        }
+    }
+}
+
+#endif
@@ -36,6 +36,14 @@
 #include "dccl/bitset.h"
 
 
+// thread-local storage for the state DCCL keeps while traversing a message, so that
+// separate threads can encode, decode and validate messages at the same time
+#if __cplusplus >= 201103L
+#define DCCL_THREAD_LOCAL thread_local
+#else
+#define DCCL_THREAD_LOCAL __thread
+#endif
+
 namespace dccl
 {
     inline unsigned floor_bits2bytes(unsigned bits)
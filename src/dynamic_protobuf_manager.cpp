@@ -20,13 +20,48 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "dynamic_protobuf_manager.h"
-#include "logger.h"
+#include "dccl/logger.h"
+#include "dccl/descriptor_cache.pb.h"
 #include "exception.h"
 
 boost::shared_ptr<dccl::DynamicProtobufManager> dccl::DynamicProtobufManager::inst_;
 
+namespace dccl
+{
+    namespace internal
+    {
+        /// 64-bit FNV-1a hash and size of the contents of a file, used to tell if a proto cache source has changed
+        bool hash_file(const std::string& path, google::protobuf::uint64* hash, google::protobuf::int64* size)
+        {
+            std::ifstream file(path.c_str(), std::ios::binary);
+            if(!file.is_open())
+                return false;
+
+            *hash = 14695981039346656037ULL;
+            *size = 0;
+            char buffer[4096];
+            while(file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+            {
+                for(std::streamsize i = 0, n = file.gcount(); i < n; ++i)
+                {
+                    *hash ^= static_cast<unsigned char>(buffer[i]);
+                    *hash *= 1099511628211ULL;
+                }
+                *size += file.gcount();
+            }
+            return !file.bad();
+        }
+    }
+}
+
 const google::protobuf::FileDescriptor* dccl::DynamicProtobufManager::add_protobuf_file(const google::protobuf::FileDescriptorProto& proto)
 {
     simple_database().Add(proto);
@@ -59,10 +94,134 @@ void dccl::DynamicProtobufManager::enable_disk_source_database()
 const google::protobuf::FileDescriptor*
 dccl::DynamicProtobufManager::load_from_proto_file(const std::string& protofile_absolute_path)
 {
-    if(!get_instance()->source_database_)
+    DynamicProtobufManager* inst = get_instance();
+    if(!inst->source_database_)
         throw(dccl::Exception("Must called enable_compilation() before loading proto files directly"));
 
-    return user_descriptor_pool().FindFileByName(protofile_absolute_path);
+    if(inst->proto_cache_dir_.empty())
+        return user_descriptor_pool().FindFileByName(protofile_absolute_path);
+
+    const google::protobuf::FileDescriptor* file_desc = inst->load_from_proto_cache(protofile_absolute_path);
+    if(!file_desc)
+    {
+        file_desc = user_descriptor_pool().FindFileByName(protofile_absolute_path);
+        if(file_desc)
+            inst->write_proto_cache(protofile_absolute_path, file_desc);
+    }
+    return file_desc;
+}
+
+std::string dccl::DynamicProtobufManager::proto_cache_path(const std::string& protofile_absolute_path)
+{
+    // flatten the path into a file name; collisions are caught by checking DescriptorCache::proto_file
+    std::string name = protofile_absolute_path;
+    std::replace(name.begin(), name.end(), '/', '_');
+    return proto_cache_dir_ + "/" + name + ".pb";
+}
+
+const google::protobuf::FileDescriptor*
+dccl::DynamicProtobufManager::load_from_proto_cache(const std::string& protofile_absolute_path)
+{
+    const std::string cache_path = proto_cache_path(protofile_absolute_path);
+    std::ifstream cache_file(cache_path.c_str(), std::ios::binary);
+    
+    dccl::DescriptorCache cache;
+    if(!cache_file.is_open() || !cache.ParseFromIstream(&cache_file) ||
+       cache.proto_file() != protofile_absolute_path)
+        return 0;
+    
+    for(int i = 0, n = cache.source_size(); i < n; ++i)
+    {
+        const dccl::DescriptorCache::Source& source = cache.source(i);
+        std::string disk_path;
+        google::protobuf::uint64 hash;
+        google::protobuf::int64 size;
+        if(!disk_source_tree_->VirtualFileToDiskFile(source.name(), &disk_path) ||
+           disk_path != source.disk_path() ||
+           !internal::hash_file(disk_path, &hash, &size) ||
+           size != source.size() ||
+           hash != source.content_hash())
+        {
+            dlog.is(logger::DEBUG1) && dlog << "Proto cache " << cache_path << " is out of date (" << source.name() << " changed)" << std::endl;
+            return 0;
+        }
+    }
+    
+    // the simple database is searched before the disk source database, so these are used in place of parsing the sources
+    for(int i = 0, n = cache.files().file_size(); i < n; ++i)
+    {
+        const google::protobuf::FileDescriptorProto& proto = cache.files().file(i);
+        google::protobuf::FileDescriptorProto existing;
+        if(!simple_database_->FindFileByName(proto.name(), &existing))
+            simple_database_->Add(proto);
+    }
+
+    dlog.is(logger::DEBUG1) && dlog << "Loaded " << protofile_absolute_path << " from proto cache " << cache_path << std::endl;
+    return user_descriptor_pool_->FindFileByName(protofile_absolute_path);
+}
+
+void dccl::DynamicProtobufManager::write_proto_cache(const std::string& protofile_absolute_path,
+                                                     const google::protobuf::FileDescriptor* file_desc)
+{
+    dccl::DescriptorCache cache;
+    cache.set_proto_file(protofile_absolute_path);
+
+    // walk the imports depth first, leaving out those that are compiled in
+    std::set<std::string> visited;
+    std::vector<const google::protobuf::FileDescriptor*> to_visit(1, file_desc);
+    while(!to_visit.empty())
+    {
+        const google::protobuf::FileDescriptor* desc = to_visit.back();
+        to_visit.pop_back();
+
+        if(!visited.insert(desc->name()).second ||
+           google::protobuf::DescriptorPool::generated_pool()->FindFileByName(desc->name()))
+            continue;
+        
+        desc->CopyTo(cache.mutable_files()->add_file());
+        
+        std::string disk_path;
+        google::protobuf::uint64 hash;
+        google::protobuf::int64 size;
+        if(disk_source_tree_->VirtualFileToDiskFile(desc->name(), &disk_path) &&
+           internal::hash_file(disk_path, &hash, &size))
+        {
+            dccl::DescriptorCache::Source* source = cache.add_source();
+            source->set_name(desc->name());
+            source->set_disk_path(disk_path);
+            source->set_size(size);
+            source->set_content_hash(hash);
+        }
+
+        for(int i = 0, n = desc->dependency_count(); i < n; ++i)
+            to_visit.push_back(desc->dependency(i));
+    }
+
+    // write to a uniquely named temporary file and rename, so concurrent readers never see a partial cache
+    // and concurrent writers (in this or other processes) don't write to the same temporary file
+    const std::string cache_path = proto_cache_path(protofile_absolute_path);
+    std::string tmp_path = cache_path + ".XXXXXX";
+    int fd = mkstemp(&tmp_path[0]);
+    if(fd < 0)
+    {
+        dlog.is(logger::WARN) && dlog << "Failed to create temporary file for proto cache: " << tmp_path << std::endl;
+        return;
+    }
+    // mkstemp creates the file readable only by its owner
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    bool written = cache.SerializeToFileDescriptor(fd);
+    if(close(fd) != 0 || !written)
+    {
+        dlog.is(logger::WARN) && dlog << "Failed to write proto cache: " << tmp_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    
+    if(std::rename(tmp_path.c_str(), cache_path.c_str()) != 0)
+    {
+        dlog.is(logger::WARN) && dlog << "Failed to write proto cache: " << cache_path << std::endl;
+        std::remove(tmp_path.c_str());
+    }
 }
 
 
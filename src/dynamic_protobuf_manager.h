@@ -23,6 +23,7 @@
 #define DCCLDYNAMICPROTOBUFMANAGER20110419H
 
 #include <dlfcn.h>
+#include <pthread.h>
 
 #include <set>
 #include <stdexcept>
@@ -35,10 +36,51 @@
 #include <google/protobuf/compiler/importer.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/version.hpp>
 
 namespace dccl
 {
+    namespace internal
+    {
+        /// MergedDescriptorDatabase that can have databases appended to it after construction, so that a DescriptorPool built on it keeps its already built descriptors when databases are added
+        class AppendableMergedDescriptorDatabase : public google::protobuf::DescriptorDatabase
+        {
+          public:
+            AppendableMergedDescriptorDatabase()
+                : merged_(new google::protobuf::MergedDescriptorDatabase(databases_))
+            { }
+            
+            void add(google::protobuf::DescriptorDatabase* database)
+            {
+                databases_.push_back(database);
+                // MergedDescriptorDatabase only holds the vector of pointers, so this is cheap
+                merged_.reset(new google::protobuf::MergedDescriptorDatabase(databases_));
+            }
+            
+            bool FindFileByName(const std::string& filename,
+                                google::protobuf::FileDescriptorProto* output)
+            { return merged_->FindFileByName(filename, output); }
+            
+            bool FindFileContainingSymbol(const std::string& symbol_name,
+                                          google::protobuf::FileDescriptorProto* output)
+            { return merged_->FindFileContainingSymbol(symbol_name, output); }
+            
+            bool FindFileContainingExtension(const std::string& containing_type,
+                                             int field_number,
+                                             google::protobuf::FileDescriptorProto* output)
+            { return merged_->FindFileContainingExtension(containing_type, field_number, output); }
+            
+            bool FindAllExtensionNumbers(const std::string& extendee_type,
+                                         std::vector<int>* output)
+            { return merged_->FindAllExtensionNumbers(extendee_type, output); }
+
+          private:
+            std::vector<google::protobuf::DescriptorDatabase*> databases_;
+            boost::shared_ptr<google::protobuf::MergedDescriptorDatabase> merged_;
+        };
+    }
+    
     /// Helper class for creating google::protobuf::Message objects that are not statically compiled into the application.
     class DynamicProtobufManager
     {
@@ -51,14 +93,35 @@ namespace dccl
         /// message A { }
         /// \endcode
         /// would result in protobuf_type_name == "dccl.protobuf.A"
+        ///
+        /// May be called from more than one thread at a time.
         static const google::protobuf::Descriptor* find_descriptor(const std::string& protobuf_type_name)
         {
+            DynamicProtobufManager* inst = get_instance();
+            pthread_mutex_lock(&inst->descriptor_cache_mutex_);
+            DescriptorCache::const_iterator it = inst->descriptor_cache_.find(protobuf_type_name);
+            const google::protobuf::Descriptor* cached = (it != inst->descriptor_cache_.end()) ? it->second : 0;
+            pthread_mutex_unlock(&inst->descriptor_cache_mutex_);
+            if(cached)
+                return cached;
+            
+            // DescriptorPool lookups are thread safe, so the mutex isn't held for these
+
             // try the generated pool
             const google::protobuf::Descriptor* desc = google::protobuf::DescriptorPool::generated_pool()->FindMessageTypeByName(protobuf_type_name);
-            if(desc) return desc;
                 
             // try the user pool
-            desc = user_descriptor_pool().FindMessageTypeByName(protobuf_type_name);
+            if(!desc)
+                desc = user_descriptor_pool().FindMessageTypeByName(protobuf_type_name);
+
+            // only cache successful lookups, as the type may be added later
+            if(desc)
+            {
+                pthread_mutex_lock(&inst->descriptor_cache_mutex_);
+                inst->descriptor_cache_.insert(std::make_pair(protobuf_type_name, desc));
+                pthread_mutex_unlock(&inst->descriptor_cache_mutex_);
+            }
+            
             return desc;
         }
 
@@ -111,10 +174,12 @@ namespace dccl
             
             
         /// \brief Add a Google Protobuf DescriptorDatabase to the set of databases searched for Message Descriptors.
+        ///
+        /// Descriptors already found remain valid (the user descriptor pool is not rebuilt).
         static void add_database(boost::shared_ptr<google::protobuf::DescriptorDatabase> database)
         {
             get_instance()->databases_.push_back(database);
-            get_instance()->update_databases();
+            get_instance()->update_databases(database.get());
         }
 
         /// \brief Enable on the fly compilation of .proto files on the local disk. Must be called before load_from_proto_file() is called.
@@ -137,6 +202,15 @@ namespace dccl
             load_from_proto_file(const std::string& protofile_absolute_path);
 
 
+        /// \brief Cache the descriptors of .proto files loaded with load_from_proto_file() in a directory, so that later processes can skip parsing them.
+        ///
+        /// For each file loaded, the cache holds a serialized FileDescriptorSet of that file and all its imports (except those compiled in), along with the disk path, size and a hash of the contents of each source. The cache is used when all of these sources are unchanged; otherwise the file is parsed from source again and the cache rewritten.
+        /// \param cache_dir Existing directory writable by this process
+        static void enable_proto_cache(const std::string& cache_dir)
+        {
+            get_instance()->proto_cache_dir_ = cache_dir;
+        }
+        
         /// \brief Add a path for searching for import messages when loading .proto files using load_from_proto_file()
         ///
         /// \throw Exception If enable_compilation() has not been called before using this function.
@@ -206,18 +280,22 @@ namespace dccl
       DynamicProtobufManager()
           : generated_database_(new google::protobuf::DescriptorPoolDatabase(*google::protobuf::DescriptorPool::generated_pool())),
             simple_database_(new google::protobuf::SimpleDescriptorDatabase),
+            merged_database_(new internal::AppendableMergedDescriptorDatabase),
+            user_descriptor_pool_(new google::protobuf::DescriptorPool(merged_database_.get())),
             msg_factory_(new google::protobuf::DynamicMessageFactory)
             {
                 databases_.push_back(simple_database_); 
                 databases_.push_back(generated_database_);
-
+                merged_database_->add(simple_database_.get());
+                merged_database_->add(generated_database_.get());
+                
                 msg_factory_->SetDelegateToGeneratedFactory(true);
-
-                update_databases();
+                pthread_mutex_init(&descriptor_cache_mutex_, 0);
             }
             
         ~DynamicProtobufManager()
         {
+            pthread_mutex_destroy(&descriptor_cache_mutex_);
         }
         
         
@@ -231,18 +309,18 @@ namespace dccl
         }
             
             
-        void update_databases()
+        void update_databases(google::protobuf::DescriptorDatabase* database)
         {
-            std::vector<google::protobuf::DescriptorDatabase*> databases;
-
-            for(std::vector<boost::shared_ptr<google::protobuf::DescriptorDatabase> >::const_iterator it = databases_.begin(), end = databases_.end(); it != end; ++it)
-                databases.push_back(it->get());
-            
-            merged_database_.reset(new google::protobuf::MergedDescriptorDatabase(databases));
-            user_descriptor_pool_.reset(new google::protobuf::DescriptorPool(merged_database_.get()));
+            // the pool queries merged_database_ again for any name it doesn't yet have, so there's no need to rebuild it
+            merged_database_->add(database);
         }
 
         void enable_disk_source_database();
+
+        std::string proto_cache_path(const std::string& protofile_absolute_path);
+        const google::protobuf::FileDescriptor* load_from_proto_cache(const std::string& protofile_absolute_path);
+        void write_proto_cache(const std::string& protofile_absolute_path,
+                               const google::protobuf::FileDescriptor* file_desc);
             
         DynamicProtobufManager(const DynamicProtobufManager&);
         DynamicProtobufManager& operator= (const DynamicProtobufManager&);
@@ -253,13 +331,19 @@ namespace dccl
         // always used
         boost::shared_ptr<google::protobuf::DescriptorPoolDatabase> generated_database_;
         boost::shared_ptr<google::protobuf::SimpleDescriptorDatabase> simple_database_;
-        boost::shared_ptr<google::protobuf::MergedDescriptorDatabase> merged_database_;
+        boost::shared_ptr<internal::AppendableMergedDescriptorDatabase> merged_database_;
         boost::shared_ptr<google::protobuf::DescriptorPool> user_descriptor_pool_;
         boost::shared_ptr<google::protobuf::DynamicMessageFactory> msg_factory_;
 
+        // results of find_descriptor() by full name
+        typedef boost::unordered_map<std::string, const google::protobuf::Descriptor*> DescriptorCache;
+        DescriptorCache descriptor_cache_;
+        pthread_mutex_t descriptor_cache_mutex_;
+
         // sometimes used
         boost::shared_ptr<google::protobuf::compiler::DiskSourceTree> disk_source_tree_;
         boost::shared_ptr<google::protobuf::compiler::SourceTreeDescriptorDatabase> source_database_;
+        std::string proto_cache_dir_;
 
         class DLogMultiFileErrorCollector
             : public google::protobuf::compiler::MultiFileErrorCollector
@@ -19,27 +19,68 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <sys/time.h>
+
 #include <boost/algorithm/string.hpp> // for replace_all
 
 #include "field_codec.h"
 #include "exception.h"
 #include "dccl/codec.h"
 
-dccl::MessagePart dccl::FieldCodecBase::part_ =
+DCCL_THREAD_LOCAL dccl::MessagePart dccl::FieldCodecBase::part_ =
     dccl::UNKNOWN;
 
-bool dccl::FieldCodecBase::strict_ = false;
+DCCL_THREAD_LOCAL bool dccl::FieldCodecBase::strict_ = false;
+
+DCCL_THREAD_LOCAL const google::protobuf::Message* dccl::FieldCodecBase::root_message_ = 0;
+DCCL_THREAD_LOCAL const google::protobuf::Descriptor* dccl::FieldCodecBase::root_descriptor_ = 0;
 
-const google::protobuf::Message* dccl::FieldCodecBase::root_message_ = 0;
-const google::protobuf::Descriptor* dccl::FieldCodecBase::root_descriptor_ = 0;
+DCCL_THREAD_LOCAL const dccl::FieldCodecBase::ReferenceTimeFunction* dccl::FieldCodecBase::reference_time_function_ = 0;
+DCCL_THREAD_LOCAL double dccl::FieldCodecBase::reference_time_ = 0;
+DCCL_THREAD_LOCAL bool dccl::FieldCodecBase::reference_time_valid_ = false;
 
 using dccl::dlog;
 using namespace dccl::logger;
 
+// decoded embedded messages are mutable, but are encoded (and sized) as const
+static boost::any as_encoded(const boost::any& wire_value)
+{
+    if(wire_value.type() == typeid(google::protobuf::Message*))
+        return static_cast<const google::protobuf::Message*>(boost::any_cast<google::protobuf::Message*>(wire_value));
+    else
+        return wire_value;
+}
+
 //
 // FieldCodecBase public
 //
 dccl::FieldCodecBase::FieldCodecBase() : force_required_(false) { }
+
+double dccl::FieldCodecBase::reference_time()
+{
+    if(reference_time_valid_)
+        return reference_time_;
+    
+    double now;
+    if(reference_time_function_ && !reference_time_function_->empty())
+    {
+        now = (*reference_time_function_)();
+    }
+    else
+    {
+        timeval t;
+        gettimeofday(&t, 0);
+        now = t.tv_sec + t.tv_usec / 1.0e6;
+    }
+
+    // only cached within a ReferenceTimeRAII (i.e. while decoding a message)
+    if(reference_time_function_)
+    {
+        reference_time_ = now;
+        reference_time_valid_ = true;
+    }
+    return now;
+}
             
 void dccl::FieldCodecBase::base_encode(Bitset* bits,
                                        const google::protobuf::Message& field_value,
@@ -61,6 +102,7 @@ void dccl::FieldCodecBase::field_encode(Bitset* bits,
                                         const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
 
     if(field)
         dlog.is(DEBUG2, ENCODE) && dlog << "Starting encode for field: " << field->DebugString() << std::flush;
@@ -70,8 +112,9 @@ void dccl::FieldCodecBase::field_encode(Bitset* bits,
     
     Bitset new_bits;
     any_encode(&new_bits, wire_value);
-    disp_size(field, new_bits, msg_handler.field_.size());
+    disp_size(field, new_bits, msg_handler.stack().field.size());
     bits->append(new_bits);
+    profiler.record(internal::FieldProfiler::ENCODE, root_descriptor_, msg_handler.stack().field, part_, new_bits.size());
 }
 
 void dccl::FieldCodecBase::field_encode_repeated(Bitset* bits,
@@ -79,14 +122,16 @@ void dccl::FieldCodecBase::field_encode_repeated(Bitset* bits,
                                                  const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
 
     std::vector<boost::any> wire_values;
     field_pre_encode_repeated(&wire_values, field_values);
     
     Bitset new_bits;
     any_encode_repeated(&new_bits, wire_values);
-    disp_size(field, new_bits, msg_handler.field_.size(), wire_values.size());
+    disp_size(field, new_bits, msg_handler.stack().field.size(), wire_values.size());
     bits->append(new_bits);
+    profiler.record(internal::FieldProfiler::ENCODE, root_descriptor_, msg_handler.stack().field, part_, new_bits.size());
 }
 
             
@@ -107,11 +152,14 @@ void dccl::FieldCodecBase::field_size(unsigned* bit_size,
                                       const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
 
     boost::any wire_value;
     field_pre_encode(&wire_value, field_value);
 
-    *bit_size += any_size(wire_value);
+    unsigned size = any_size(wire_value);
+    *bit_size += size;
+    profiler.record(internal::FieldProfiler::SIZE, root_descriptor_, msg_handler.stack().field, part_, size);
 }
 
 void dccl::FieldCodecBase::field_size_repeated(unsigned* bit_size,
@@ -119,11 +167,14 @@ void dccl::FieldCodecBase::field_size_repeated(unsigned* bit_size,
                                                const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
 
     std::vector<boost::any> wire_values;
     field_pre_encode_repeated(&wire_values, field_values);
 
-    *bit_size += any_size_repeated(wire_values);
+    unsigned size = any_size_repeated(wire_values);
+    *bit_size += size;
+    profiler.record(internal::FieldProfiler::SIZE, root_descriptor_, msg_handler.stack().field, part_, size);
 }
 
 
@@ -144,6 +195,7 @@ void dccl::FieldCodecBase::field_decode(Bitset* bits,
                                         const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
     
     if(!field_value)
         throw(Exception("Decode called with NULL boost::any"));
@@ -169,6 +221,19 @@ void dccl::FieldCodecBase::field_decode(Bitset* bits,
     any_decode(&these_bits, &wire_value);
     
     field_post_decode(wire_value, field_value);  
+
+    if(profiler.active())
+    {
+        // the fields of embedded messages get their bits through these_bits (leaving it empty), so
+        // the bits decoded are counted by sizing the decoded value instead
+        profiler.stop();
+        unsigned size = 0;
+        {
+            internal::FieldProfiler::Scope not_profiled(0);
+            size = any_size(as_encoded(wire_value));
+        }
+        profiler.record(internal::FieldProfiler::DECODE, root_descriptor_, msg_handler.stack().field, part_, size);
+    }
 }
 
 void dccl::FieldCodecBase::field_decode_repeated(Bitset* bits,
@@ -176,6 +241,7 @@ void dccl::FieldCodecBase::field_decode_repeated(Bitset* bits,
                                                  const google::protobuf::FieldDescriptor* field)
 {
     internal::MessageStack msg_handler(field);
+    internal::FieldProfiler profiler;
     
     if(!field_values)
         throw(Exception("Decode called with NULL field_values"));
@@ -199,6 +265,21 @@ void dccl::FieldCodecBase::field_decode_repeated(Bitset* bits,
 
     field_values->clear();
     field_post_decode_repeated(wire_values, field_values);
+
+    if(profiler.active())
+    {
+        // see field_decode()
+        profiler.stop();
+        unsigned size = 0;
+        {
+            internal::FieldProfiler::Scope not_profiled(0);
+            std::vector<boost::any> encoded_wire_values;
+            for(std::vector<boost::any>::const_iterator it = wire_values.begin(), end = wire_values.end(); it != end; ++it)
+                encoded_wire_values.push_back(as_encoded(*it));
+            size = any_size_repeated(encoded_wire_values);
+        }
+        profiler.record(internal::FieldProfiler::DECODE, root_descriptor_, msg_handler.stack().field, part_, size);
+    }
 }
 
 
@@ -26,6 +26,7 @@
 #include <string>
 
 #include <boost/any.hpp>
+#include <boost/function.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <google/protobuf/message.h>
@@ -37,6 +38,7 @@
 #include "dccl/option_extensions.pb.h"
 #include "internal/type_helper.h"
 #include "internal/field_codec_message_stack.h"
+#include "internal/field_profiler.h"
 #include "dccl/binary.h"
 
 namespace dccl
@@ -73,7 +75,7 @@ namespace dccl
         ///
         /// \return FieldDescriptor for the current field or 0 if this codec is encoding the base message.
         const google::protobuf::FieldDescriptor* this_field() const 
-        { return !internal::MessageStack::field_.empty() ? internal::MessageStack::field_.back() : 0; }
+        { return !internal::MessageStack::stack().field.empty() ? internal::MessageStack::stack().field.back() : 0; }
             
         /// \brief Returns the Descriptor (message schema meta-data) for the immediate parent Message
         ///
@@ -89,7 +91,7 @@ namespace dccl
         /// returns Descriptor for Foo if this_field() == FieldDescriptor for bar
         /// returns Descriptor for FooBar if this_field() == FieldDescriptor for baz
         static const google::protobuf::Descriptor* this_descriptor()
-        { return !internal::MessageStack::desc_.empty() ? internal::MessageStack::desc_.back() : 0; }
+        { return !internal::MessageStack::stack().desc.empty() ? internal::MessageStack::stack().desc.back() : 0; }
 
         // currently encoded or (partially) decoded root message
         static const google::protobuf::Message* root_message()
@@ -118,6 +120,38 @@ namespace dccl
         static MessagePart part() { return part_; }
 
         static bool strict() { return strict_; }
+
+        /// \brief Function returning the current time in seconds since the UNIX epoch (see Codec::set_reference_time_function())
+        typedef boost::function<double ()> ReferenceTimeFunction;
+
+        /// \brief the time (seconds since the UNIX epoch) relative to which fields that only encode part of the time (e.g. the time of day for dccl.time2) are decoded.
+        ///
+        /// While decoding a message, this is read (once per message) from the Codec's reference time function (the system clock by default), otherwise it is read from the system clock.
+        static double reference_time();
+        
+        /// \brief RAII: within its lifetime, reference_time() is read once (when first needed) from *function, or from the system clock if *function is empty
+        class ReferenceTimeRAII
+        {
+          public:
+            ReferenceTimeRAII(const ReferenceTimeFunction* function)
+                : previous_function_(reference_time_function_),
+                previous_time_(reference_time_),
+                previous_valid_(reference_time_valid_)
+                {
+                    reference_time_function_ = function;
+                    reference_time_valid_ = false;
+                }
+            ~ReferenceTimeRAII()
+                {
+                    reference_time_function_ = previous_function_;
+                    reference_time_ = previous_time_;
+                    reference_time_valid_ = previous_valid_;
+                }
+          private:
+            const ReferenceTimeFunction* previous_function_;
+            double previous_time_;
+            bool previous_valid_;
+        };
         
         /// \brief Force the codec to always use the "required" field encoding, regardless of the FieldDescriptor setting. Useful when wrapping this codec in another that handles optional and repeated fields
         void set_force_use_required(bool force_required = true)
@@ -494,10 +528,16 @@ namespace dccl
         };
         
         
-        static MessagePart part_;
-        static bool strict_;
-        static const google::protobuf::Message* root_message_;
-        static const google::protobuf::Descriptor* root_descriptor_;
+        // per thread, so that messages can be validated in parallel (see Codec::load_all())
+        static DCCL_THREAD_LOCAL MessagePart part_;
+        static DCCL_THREAD_LOCAL bool strict_;
+        static DCCL_THREAD_LOCAL const google::protobuf::Message* root_message_;
+        static DCCL_THREAD_LOCAL const google::protobuf::Descriptor* root_descriptor_;
+
+        // reference_time() for the message being decoded: reference_time_ is valid once read from reference_time_function_
+        static DCCL_THREAD_LOCAL const ReferenceTimeFunction* reference_time_function_;
+        static DCCL_THREAD_LOCAL double reference_time_;
+        static DCCL_THREAD_LOCAL bool reference_time_valid_;
         
         std::string name_;
         google::protobuf::FieldDescriptor::Type field_type_;
@@ -73,6 +73,14 @@ namespace dccl
             >,
             void>::type
             static add(const std::string& name, compiler::dummy_fcm<1> dummy_fcm = 0);
+
+        /// \brief Add a new field codec used only for one message type, leaving the value passed to the codec as google::protobuf::Message* (used for the message codecs generated by protoc-gen-dccl).
+        ///
+        /// \tparam Codec A child of FieldCodecBase
+        /// \param name Name to use for this codec. Corresponds to (dccl.msg).codec="name" or the codec group in the .proto file.
+        /// \param desc Descriptor of the message type this codec is used for.
+        template<class Codec>
+            static void add(const std::string& name, const google::protobuf::Descriptor* desc);
                 
         /// \brief Add a new field codec only valid for a specific google::protobuf::FieldDescriptor::Type. This is useful if a given codec is designed to work with only a specific Protobuf type that shares an underlying C++ type (e.g. Protobuf types `bytes` and `string`)
         ///
@@ -107,6 +115,14 @@ namespace dccl
             >,
             void>::type
             static remove(const std::string& name, compiler::dummy_fcm<1> dummy_fcm = 0);
+
+        /// \brief Remove a field codec added for a single message type with add(const std::string&, const google::protobuf::Descriptor*).
+        ///
+        /// \tparam Codec A child of FieldCodecBase
+        /// \param name Name of this codec.
+        /// \param desc Descriptor of the message type this codec is used for.
+        template<class Codec>
+            static void remove(const std::string& name, const google::protobuf::Descriptor* desc);
                 
         /// \brief Remove a new field codec only valid for a specific google::protobuf::FieldDescriptor::Type. This is useful if a given codec is designed to work with only a specific Protobuf type that shares an underlying C++ type (e.g. Protobuf types `bytes` and `string`)
         ///
@@ -260,6 +276,14 @@ template<class Codec, google::protobuf::FieldDescriptor::Type type>
     add_single_type<Codec>(name, type, google::protobuf::FieldDescriptor::TypeToCppType(type));
 }
 
+template<class Codec>
+    void dccl::FieldCodecManager::add(const std::string& name, const google::protobuf::Descriptor* desc)
+{
+    add_single_type<Codec>(__mangle_name(name, desc->full_name()),
+                           google::protobuf::FieldDescriptor::TYPE_MESSAGE,
+                           google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE);
+}
+
 
 template<typename WireType, typename FieldType, class Codec>
     void dccl::FieldCodecManager::add_all_types(const std::string& name)
@@ -343,6 +367,14 @@ template<class Codec, google::protobuf::FieldDescriptor::Type type>
     remove_single_type<Codec>(name, type, google::protobuf::FieldDescriptor::TypeToCppType(type));
 }
 
+template<class Codec>
+    void dccl::FieldCodecManager::remove(const std::string& name, const google::protobuf::Descriptor* desc)
+{
+    remove_single_type<Codec>(__mangle_name(name, desc->full_name()),
+                              google::protobuf::FieldDescriptor::TYPE_MESSAGE,
+                              google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE);
+}
+
 
 template<typename WireType, typename FieldType, class Codec>
     void dccl::FieldCodecManager::remove_all_types(const std::string& name)
@@ -19,12 +19,34 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <pthread.h>
+
 #include "field_codec_message_stack.h"
 #include "dccl/field_codec.h"
 
-std::vector<const google::protobuf::FieldDescriptor*> dccl::internal::MessageStack::field_;
-std::vector<const google::protobuf::Descriptor*> dccl::internal::MessageStack::desc_;
-std::vector<dccl::MessagePart> dccl::internal::MessageStack::parts_;
+DCCL_THREAD_LOCAL dccl::internal::MessageStack::Stack* dccl::internal::MessageStack::stack_ = 0;
+
+static pthread_key_t stack_key;
+static pthread_once_t stack_key_once = PTHREAD_ONCE_INIT;
+
+void dccl::internal::MessageStack::delete_stack(void* stack)
+{
+    delete static_cast<Stack*>(stack);
+}
+
+void dccl::internal::MessageStack::create_stack_key()
+{
+    pthread_key_create(&stack_key, &MessageStack::delete_stack);
+}
+
+dccl::internal::MessageStack::Stack* dccl::internal::MessageStack::new_stack()
+{
+    // stack_ is a plain pointer for fast access: the key only deletes the stack when its thread exits
+    pthread_once(&stack_key_once, &MessageStack::create_stack_key);
+    Stack* stack = new Stack;
+    pthread_setspecific(stack_key, stack);
+    return stack;
+}
 
 //
 // MessageStack
@@ -33,39 +55,39 @@ std::vector<dccl::MessagePart> dccl::internal::MessageStack::parts_;
 void dccl::internal::MessageStack::push(const google::protobuf::Descriptor* desc)
  
 {
-    desc_.push_back(desc);
+    stack().desc.push_back(desc);
     ++descriptors_pushed_;
 }
 
 void dccl::internal::MessageStack::push(const google::protobuf::FieldDescriptor* field)
 {
-    field_.push_back(field);
+    stack().field.push_back(field);
     ++fields_pushed_;
 }
 
 void dccl::internal::MessageStack::push(MessagePart part)
 {
-    parts_.push_back(part);
+    stack().parts.push_back(part);
     ++parts_pushed_;
 }
 
 
 void dccl::internal::MessageStack::__pop_desc()
 {
-    if(!desc_.empty())
-        desc_.pop_back();
+    if(!stack().desc.empty())
+        stack().desc.pop_back();
 }
 
 void dccl::internal::MessageStack::__pop_field()
 {
-    if(!field_.empty())
-        field_.pop_back();
+    if(!stack().field.empty())
+        stack().field.pop_back();
 }
 
 void dccl::internal::MessageStack::__pop_parts()
 {
-    if(!parts_.empty())
-        parts_.pop_back();
+    if(!stack().parts.empty())
+        stack().parts.pop_back();
 }
 
 
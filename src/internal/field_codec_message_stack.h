@@ -41,15 +41,19 @@ namespace dccl
             ~MessageStack();
             
             bool first() 
-            { return desc_.empty(); }
+            { return stack().desc.empty(); }
             int count() 
-            { return desc_.size(); }
+            { return stack().desc.size(); }
 
             void push(const google::protobuf::Descriptor* desc);
             void push(const google::protobuf::FieldDescriptor* field);
             void push(MessagePart part);
 
-            static MessagePart current_part() { return parts_.empty() ? UNKNOWN : parts_.back(); }
+            static MessagePart current_part()
+            {
+                const std::vector<MessagePart>& parts = stack().parts;
+                return parts.empty() ? UNKNOWN : parts.back();
+            }
         
             friend class ::dccl::FieldCodecBase;
           private:
@@ -57,9 +61,24 @@ namespace dccl
             void __pop_field();
             void __pop_parts();
                 
-            static std::vector<const google::protobuf::Descriptor*> desc_;
-            static std::vector<const google::protobuf::FieldDescriptor*> field_;
-            static std::vector<MessagePart> parts_;
+            struct Stack
+            {
+                std::vector<const google::protobuf::Descriptor*> desc;
+                std::vector<const google::protobuf::FieldDescriptor*> field;
+                std::vector<MessagePart> parts;
+            };
+
+            // the stack of the calling thread
+            static Stack& stack()
+            {
+                if(!stack_) stack_ = new_stack();
+                return *stack_;
+            }
+            static Stack* new_stack();
+            static void delete_stack(void* stack);
+            static void create_stack_key();
+            
+            static DCCL_THREAD_LOCAL Stack* stack_;
             int descriptors_pushed_;
             int fields_pushed_;
             int parts_pushed_;
@@ -0,0 +1,63 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <time.h>
+
+#include "field_profiler.h"
+
+DCCL_THREAD_LOCAL dccl::CodecProfile* dccl::internal::FieldProfiler::profile_ = 0;
+
+void dccl::internal::FieldProfiler::do_record(Operation operation,
+                                              const google::protobuf::Descriptor* root_descriptor,
+                                              const std::vector<const google::protobuf::FieldDescriptor*>& fields,
+                                              MessagePart part,
+                                              unsigned bits)
+{
+    uint64 elapsed = (stop_ns_ ? stop_ns_ : now()) - start_ns_;
+    
+    std::string path;
+    if(fields.empty())
+    {
+        path = (part == HEAD) ? "(head)" : "(body)";
+    }
+    else
+    {
+        for(std::vector<const google::protobuf::FieldDescriptor*>::const_iterator it = fields.begin(), end = fields.end(); it != end; ++it)
+        {
+            if(!path.empty())
+                path += ".";
+            path += (*it)->name();
+        }
+    }
+
+    FieldProfile& profile = (*profile_)[root_descriptor->full_name()][path];
+    FieldProfile::Operation& op = (operation == ENCODE) ? profile.encode : ((operation == DECODE) ? profile.decode : profile.size);
+    ++op.count;
+    op.nanoseconds += elapsed;
+    op.bits += bits;
+}
+
+dccl::uint64 dccl::internal::FieldProfiler::now()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<uint64>(t.tv_sec) * 1000000000ull + t.tv_nsec;
+}
@@ -0,0 +1,120 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef DCCLFIELDPROFILER20261019H
+#define DCCLFIELDPROFILER20261019H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+
+#include "dccl/common.h"
+#include "field_codec_message_stack.h"
+
+namespace dccl
+{
+    /// \brief Call counts, cumulative time and bits for one field (or the whole head or body) of a message type, collected when profiling is enabled with Codec::set_profiling()
+    struct FieldProfile
+    {
+        /// \brief Statistics for one operation (encode, decode or size)
+        struct Operation
+        {
+            Operation() : count(0), nanoseconds(0), bits(0) { }
+
+            /// \brief Number of calls
+            uint64 count;
+            /// \brief Cumulative time spent, including the time spent in the fields of embedded messages
+            uint64 nanoseconds;
+            /// \brief Cumulative bits encoded, decoded or sized
+            uint64 bits;
+
+            double average_nanoseconds() const { return count ? static_cast<double>(nanoseconds) / count : 0; }
+            double average_bits() const { return count ? static_cast<double>(bits) / count : 0; }
+        };
+        
+        Operation encode;
+        Operation decode;
+        Operation size;
+    };
+
+    /// \brief Profile of a Codec: message full name -> field path -> FieldProfile.
+    ///
+    /// Field paths are the dot separated field names from the root message (e.g. "pos.x" for field "x" of embedded message field "pos"), or "(head)" and "(body)" for the whole head and body of the message.
+    typedef std::map<std::string, std::map<std::string, FieldProfile> > CodecProfile;
+    
+    namespace internal
+    {
+        /// Times one field codec call, recording it in the profile of the calling thread's Codec if profiling is enabled
+        class FieldProfiler
+        {
+          public:
+            enum Operation { ENCODE, DECODE, SIZE };
+            
+            FieldProfiler() : start_ns_(profile_ ? now() : 0), stop_ns_(0) { }
+
+            /// Is the calling thread collecting a profile?
+            bool active() const { return profile_; }
+            
+            /// Stops timing the call (so that work done only for the profile before record() is not included)
+            void stop() { if(profile_) stop_ns_ = now(); }
+
+            /// Records the call (started at construction, ending now or at stop()) of the innermost field of the stack
+            void record(Operation operation,
+                        const google::protobuf::Descriptor* root_descriptor,
+                        const std::vector<const google::protobuf::FieldDescriptor*>& fields,
+                        MessagePart part,
+                        unsigned bits)
+            {
+                if(profile_ && root_descriptor)
+                    do_record(operation, root_descriptor, fields, part, bits);
+            }
+            
+            /// RAII: collects the profile of calls made by this thread into profile (or nothing, if 0) during its lifetime
+            class Scope
+            {
+              public:
+                Scope(CodecProfile* profile) : previous_(profile_)
+                { profile_ = profile; }
+                ~Scope()
+                { profile_ = previous_; }
+              private:
+                CodecProfile* previous_;
+            };
+            
+          private:
+            void do_record(Operation operation,
+                           const google::protobuf::Descriptor* root_descriptor,
+                           const std::vector<const google::protobuf::FieldDescriptor*>& fields,
+                           MessagePart part,
+                           unsigned bits);
+            static uint64 now();
+            
+          private:
+            static DCCL_THREAD_LOCAL CodecProfile* profile_;
+            uint64 start_ns_;
+            uint64 stop_ns_;
+        };
+    }
+}
+
+#endif
@@ -19,29 +19,273 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstring>
 #include <ctime>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/lockfree/queue.hpp>
 
 #include "dccl/logger.h"
 
 dccl::Logger dccl::dlog;
 
-int dccl::internal::LogBuffer::sync() {
-    // all but last one
-    while(buffer_.size() > 1) {
-        display(buffer_.front());
-        buffer_.pop_front();
+namespace dccl
+{
+    namespace internal
+    {
+        /// Writes completed log messages from a background thread. Any number of threads may call push(); the slots are only ever called from the writer thread.
+        class AsyncLogWriter
+        {
+          public:
+            AsyncLogWriter(LogBuffer* buf, unsigned queue_capacity)
+                : buf_(buf),
+                entries_(queue_capacity),
+                free_(queue_capacity),
+                ready_(queue_capacity),
+                running_(true),
+                dropped_(0)
+            {
+                for(unsigned i = 0; i < queue_capacity; ++i)
+                {
+                    entries_[i].msg.reserve(MESSAGE_RESERVE_BYTES);
+                    free_.bounded_push(i);
+                }
+                
+                pthread_mutex_init(&mutex_, 0);
+                pthread_cond_init(&cond_, 0);
+                pthread_create(&thread_, 0, &AsyncLogWriter::run, this);
+            }
+
+            /// stops the writer thread after it has written all the queued messages
+            ~AsyncLogWriter()
+            {
+                running_ = false;
+                pthread_cond_signal(&cond_);
+                pthread_join(thread_, 0);
+
+                pthread_cond_destroy(&cond_);
+                pthread_mutex_destroy(&mutex_);
+            }
+
+            /// queue a message, dropping it if the queue is full. Never blocks.
+            void push(const std::string& msg, logger::Verbosity verbosity, logger::Group group)
+            {
+                unsigned slot;
+                if(!free_.pop(slot))
+                {
+                    ++dropped_;
+                    return;
+                }
+
+                // only reallocates for messages longer than any previously written to this slot
+                Entry& entry = entries_[slot];
+                entry.msg.assign(msg);
+                entry.verbosity = verbosity;
+                entry.group = group;
+
+                // always succeeds: there are only as many slots as the queue holds
+                ready_.bounded_push(slot);
+                pthread_cond_signal(&cond_);
+            }
+
+            unsigned long dropped() const { return dropped_; }
+            
+          private:
+            struct Entry
+            {
+                Entry() : verbosity(logger::INFO), group(logger::GENERAL) { }
+                std::string msg;
+                logger::Verbosity verbosity;
+                logger::Group group;
+            };
+
+            static void* run(void* self)
+            {
+                static_cast<AsyncLogWriter*>(self)->write_loop();
+                return 0;
+            }
+
+            void write_loop()
+            {
+                for(;;)
+                {
+                    // read running_ before draining so nothing pushed before the destructor is missed
+                    bool running = running_;
+                    
+                    unsigned slot;
+                    while(ready_.pop(slot))
+                    {
+                        const Entry& entry = entries_[slot];
+                        buf_->display(entry.msg, entry.verbosity, entry.group);
+                        free_.bounded_push(slot);
+                    }
+                    
+                    if(!running) return;
+
+                    // producers signal without taking the mutex, so a wakeup can be missed: only wait briefly
+                    timespec until;
+                    clock_gettime(CLOCK_REALTIME, &until);
+                    until.tv_nsec += WAIT_NSEC;
+                    if(until.tv_nsec >= 1000000000L)
+                    {
+                        until.tv_sec += 1;
+                        until.tv_nsec -= 1000000000L;
+                    }
+                    
+                    pthread_mutex_lock(&mutex_);
+                    if(ready_.empty() && running_)
+                        pthread_cond_timedwait(&cond_, &mutex_, &until);
+                    pthread_mutex_unlock(&mutex_);
+                }
+            }
+            
+          private:
+            enum { WAIT_NSEC = 10000000L }; // 10 ms
+            enum { MESSAGE_RESERVE_BYTES = 128 };
+            
+            LogBuffer* buf_;
+            // preallocated messages, passed between the loggers and the writer by index
+            std::vector<Entry> entries_;
+            // indices into entries_ that are available to push(), and that are waiting to be written
+            boost::lockfree::queue<unsigned> free_;
+            boost::lockfree::queue<unsigned> ready_;
+            boost::atomic<bool> running_;
+            boost::atomic<unsigned long> dropped_;
+
+            pthread_t thread_;
+            pthread_mutex_t mutex_;
+            pthread_cond_t cond_;
+        };
+    }
+}
+
+dccl::internal::LogBuffer::LogBuffer()
+    : enabled_verbosities_(0),
+      async_writer_(0),
+      dropped_(0)
+{
+    pthread_key_create(&thread_state_key_, &LogBuffer::delete_thread_state);
+    pthread_rwlock_init(&async_writer_lock_, 0);
+    for(int i = 0, n = logger::SIZE + 1; i < n; ++i)
+        group_verbosities_[i] = logger::ALL;
+}
+
+dccl::internal::LogBuffer::~LogBuffer()
+{
+    set_async(false, 0);
+    pthread_rwlock_destroy(&async_writer_lock_);
+    // only the calling thread's state is still reachable; other threads' states are deleted as they exit
+    delete static_cast<ThreadState*>(pthread_getspecific(thread_state_key_));
+    pthread_key_delete(thread_state_key_);
+}
+
+dccl::internal::LogBuffer::ThreadState& dccl::internal::LogBuffer::thread_state()
+{
+    ThreadState* state = static_cast<ThreadState*>(pthread_getspecific(thread_state_key_));
+    if(!state)
+    {
+        state = new ThreadState(this);
+        pthread_setspecific(thread_state_key_, state);
+    }
+    return *state;
+}
+
+void dccl::internal::LogBuffer::delete_thread_state(void* state)
+{
+    delete static_cast<ThreadState*>(state);
+}
+
+void dccl::internal::LogBuffer::set_verbosity_and_group(logger::Verbosity verbosity, logger::Group group)
+{
+    ThreadState& state = thread_state();
+    state.verbosity = verbosity;
+    state.group = group;
+}
+
+void dccl::internal::LogBuffer::set_async(bool async, unsigned queue_capacity)
+{
+    // waits for any thread in sync() to finish with the current writer
+    pthread_rwlock_wrlock(&async_writer_lock_);
+    if(async_writer_)
+    {
+        // joins the writer thread once it has written the queue, so messages stay in order
+        dropped_ += async_writer_->dropped();
+        delete async_writer_;
+        async_writer_ = 0;
     }
-    verbosity_ = logger::INFO;
-    group_ = logger::GENERAL;
     
-    return 0;
+    if(async)
+        async_writer_ = new AsyncLogWriter(this, queue_capacity);
+    pthread_rwlock_unlock(&async_writer_lock_);
+}
+
+unsigned long dccl::internal::LogBuffer::dropped() const
+{
+    pthread_rwlock_rdlock(&async_writer_lock_);
+    unsigned long dropped = dropped_ + (async_writer_ ? async_writer_->dropped() : 0);
+    pthread_rwlock_unlock(&async_writer_lock_);
+    return dropped;
+}
+
+const char* dccl::internal::LogBuffer::write_lines(const char* begin, const char* end,
+                                                   logger::Verbosity verbosity, logger::Group group,
+                                                   std::string* line)
+{
+    pthread_rwlock_rdlock(&async_writer_lock_);
+    for(const char* newline; (newline = std::find(begin, end, '\n')) != end; begin = newline + 1)
+    {
+        line->assign(begin, newline);
+        if(async_writer_)
+            async_writer_->push(*line, verbosity, group);
+        else
+            display(*line, verbosity, group);
+    }
+    pthread_rwlock_unlock(&async_writer_lock_);
+    return begin;
+}
+
+int dccl::internal::LogBuffer::sync() {
+    return thread_state().pubsync();
 }
 
 int dccl::internal::LogBuffer::overflow(int c) {
     if (c == EOF) { return c; }
-    else if(c == '\n') { buffer_.push_back(std::string()); }
-    else { buffer_.back().push_back(c); }
-    return c;
+    return thread_state().sputc(traits_type::to_char_type(c));
+}
+
+dccl::internal::LogBuffer::ThreadState::ThreadState(LogBuffer* log)
+    : verbosity(logger::INFO),
+      group(logger::GENERAL),
+      stream(this),
+      log_(log),
+      buffer_(INITIAL_BUFFER_BYTES)
+{
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+}
+
+int dccl::internal::LogBuffer::ThreadState::sync() {
+    // all but the incomplete last line
+    const char* rest = log_->write_lines(pbase(), pptr(), verbosity, group, &line_);
+    const std::size_t rest_size = pptr() - rest;
+    std::memmove(&buffer_[0], rest, rest_size);
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+    pbump(static_cast<int>(rest_size));
+    
+    verbosity = logger::INFO;
+    group = logger::GENERAL;
+    return 0;
+}
+
+int dccl::internal::LogBuffer::ThreadState::overflow(int c) {
+    if (c == EOF) { return traits_type::not_eof(c); }
+
+    const std::size_t size = pptr() - pbase();
+    buffer_.resize(buffer_.size() * 2);
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+    pbump(static_cast<int>(size));
+    return sputc(traits_type::to_char_type(c));
 }
 
 void dccl::to_ostream(const std::string& msg, dccl::logger::Verbosity vrb,
@@ -24,10 +24,17 @@
 
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
 #include <iomanip>
 #include <boost/signals2.hpp>
+#include <boost/bind.hpp>
 #include <cstdio>
+#include <pthread.h>
+
+// most verbose Verbosity that is compiled in
+#ifndef DCCL_COMPILED_LOG_VERBOSITY
+#define DCCL_COMPILED_LOG_VERBOSITY @DCCL_COMPILED_LOG_VERBOSITY@
+#endif
 
 namespace dccl {
     namespace logger {
@@ -47,7 +54,9 @@ namespace dccl {
         };
         enum Group 
         { GENERAL, ENCODE, DECODE, SIZE };
-  
+
+        /// Mask of the verbosities compiled in (set at build time by the CMake variable `compiled_log_verbosity`, or by defining DCCL_COMPILED_LOG_VERBOSITY before including DCCL headers). Logger::is() is false at compile time for other verbosities, so those log statements are removed entirely by the compiler.
+        const int COMPILED_VERBOSITIES = DCCL_COMPILED_LOG_VERBOSITY | (DCCL_COMPILED_LOG_VERBOSITY - 1);
     }
 
     
@@ -57,11 +66,13 @@ namespace dccl {
     
     namespace internal
     {
+        class AsyncLogWriter;
+        
         class LogBuffer : public std::streambuf
         {
           public:
-          LogBuffer() : verbosity_(logger::INFO), group_(logger::GENERAL), buffer_(1) { }
-            ~LogBuffer() { }
+            LogBuffer();
+            ~LogBuffer();
 
             /// connect a signal to a slot (function pointer or similar)
             template <typename Slot>
@@ -83,42 +94,92 @@ namespace dccl {
                 if(verbosity_mask & logger::DEBUG3) debug3_signal.disconnect_all_slots();
             }
  
-            /// sets the verbosity level until the next sync()
-            void set_verbosity(logger::Verbosity verbosity)
-            { verbosity_ = verbosity; }
-
-            void set_group(logger::Group group)
-            { group_ = group; }
-        
+            /// sets the verbosity level and group for the calling thread until its next sync()
+            void set_verbosity_and_group(logger::Verbosity verbosity, logger::Group group);
   
-            bool contains(logger::Verbosity verbosity)
-            { return verbosity & enabled_verbosities_; }
- 
-     
+            bool contains(logger::Verbosity verbosity, logger::Group group) const
+            { return verbosity & enabled_verbosities_ & group_verbosities_[group]; }
+
+            void set_group_verbosity(logger::Group group, int verbosity_mask)
+            { group_verbosities_[group] = verbosity_mask; }
+
+            void set_async(bool async, unsigned queue_capacity);
+            unsigned long dropped() const;
+
+            /// the calling thread's own stream writing into this buffer
+            std::ostream& thread_stream()
+            { return thread_state().stream; }
+            
           private:
+            friend class AsyncLogWriter;
+            
+            /// send a completed message to the slots connected for its verbosity
+            void display(const std::string& s, logger::Verbosity verbosity, logger::Group group) {
+                if(verbosity & logger::WARN) warn_signal(s, logger::WARN, group);
+                if(verbosity & logger::INFO) info_signal(s, logger::INFO, group);
+                if(verbosity & logger::DEBUG1) debug1_signal(s, logger::DEBUG1, group);
+                if(verbosity & logger::DEBUG2) debug2_signal(s, logger::DEBUG2, group);
+                if(verbosity & logger::DEBUG3) debug3_signal(s, logger::DEBUG3, group);
+            }
+     
             /// virtual inherited from std::streambuf.
-            /// Called when std::endl or std::flush is inserted into the stream
+            /// Called when std::endl or std::flush is inserted into the Logger itself rather than through Logger::operator<<; passed on to the calling thread's buffer
             int sync();
 
-            /// virtual inherited from std::streambuf. Called when something is inserted into the stream
-            /// Called when std::endl or std::flush is inserted into the stream
+            /// virtual inherited from std::streambuf.
+            /// Called when something is inserted into the Logger itself rather than through Logger::operator<<; passed on to the calling thread's buffer
             int overflow(int c = EOF);
-     
 
-            void display(const std::string& s) {
-                if(verbosity_ & logger::WARN) warn_signal(s, logger::WARN, group_);
-                if(verbosity_ & logger::INFO) info_signal(s, logger::INFO, group_);
-                if(verbosity_ & logger::DEBUG1) debug1_signal(s, logger::DEBUG1, group_);
-                if(verbosity_ & logger::DEBUG2) debug2_signal(s, logger::DEBUG2, group_);
-                if(verbosity_ & logger::DEBUG3) debug3_signal(s, logger::DEBUG3, group_);
-            }
+            /// state and buffer of the message currently being written by a given thread
+            ///
+            /// Characters are written straight into the put area, without a virtual call or thread-local lookup; only completed lines are handed to the LogBuffer, by sync().
+            class ThreadState : public std::streambuf
+            {
+              public:
+                ThreadState(LogBuffer* log);
+                
+                logger::Verbosity verbosity;
+                logger::Group group;
+                // keeps the formatting state (std::hex, std::setprecision, ...) separate for each thread
+                std::ostream stream;
+
+              private:
+                /// virtual inherited from std::streambuf.
+                /// Called when std::endl or std::flush is inserted into the stream: writes the completed lines
+                int sync();
+
+                /// virtual inherited from std::streambuf. Called when the put area is full: grows it
+                int overflow(int c = EOF);
+
+              private:
+                enum { INITIAL_BUFFER_BYTES = 256 };
+                
+                LogBuffer* log_;
+                std::vector<char> buffer_;
+                // reused for each completed line
+                std::string line_;
+            };
+            
+            ThreadState& thread_state();
+            static void delete_thread_state(void* state);
+
+            /// display (or queue) each completed line in [begin, end), returning the start of the incomplete line that follows them
+            const char* write_lines(const char* begin, const char* end,
+                                    logger::Verbosity verbosity, logger::Group group,
+                                    std::string* line);
 
           private:
-            logger::Verbosity verbosity_;
-            logger::Group group_;
-            std::deque<std::string> buffer_;
+            pthread_key_t thread_state_key_;
             int enabled_verbosities_; // mask of verbosity settings enabled
+            int group_verbosities_[logger::SIZE + 1]; // mask of verbosity settings enabled for each group
 
+            // if set, completed messages are queued and displayed from a background thread
+            AsyncLogWriter* async_writer_;
+            // messages dropped by previous async writers
+            unsigned long dropped_;
+            // read locked while using async_writer_, write locked by set_async() to replace it
+            mutable pthread_rwlock_t async_writer_lock_;
+            
             typedef boost::signals2::signal<void (const std::string& msg, logger::Verbosity vrb, logger::Group grp)>
                 LogSignal;
                                               
@@ -143,15 +204,31 @@ namespace dccl {
         /// \param verbosity The verbosity level to tag the following message with. These levels are used to direct the output of dlog to different logs or omit them completely.
         /// \param group The group that this message belongs to.
         bool is(logger::Verbosity verbosity, logger::Group group = logger::GENERAL) {
-            if (!buf_.contains(verbosity)) {
+            if (!(verbosity & logger::COMPILED_VERBOSITIES) || !buf_.contains(verbosity, group)) {
                 return false;
             } else {
-                buf_.set_verbosity(verbosity);
-                buf_.set_group(group);
+                buf_.set_verbosity_and_group(verbosity, group);
                 return true;
             }
         }     
      
+        /// \brief Write to the calling thread's own stream, so that threads logging at the same time do not share formatting state
+        template<typename T>
+            std::ostream& operator<<(const T& t)
+        { return buf_.thread_stream() << t; }
+
+        /// \brief Apply a manipulator (e.g. std::endl) to the calling thread's stream
+        std::ostream& operator<<(std::ostream& (*manip)(std::ostream&))
+        { return manip(buf_.thread_stream()); }
+
+        /// \brief Apply a formatting manipulator (e.g. std::hex) to the calling thread's stream
+        std::ostream& operator<<(std::ios_base& (*manip)(std::ios_base&))
+        {
+            std::ostream& os = buf_.thread_stream();
+            manip(os);
+            return os;
+        }
+     
         /// \brief Connect the output of one or more given verbosities to a slot (function pointer or similar)
         ///
         /// \param verbosity_mask A bitmask representing the verbosity or verbosities to send to this slot. For example, you can use connect(WARN | INFO, slot) to send both WARN and INFO messages to slot.
@@ -188,6 +265,28 @@ namespace dccl {
         /// \brief Disconnect all slots for one or more given verbosities
         void disconnect(int verbosity_mask)
         { buf_.disconnect(verbosity_mask); }
+
+        /// \brief Restrict the verbosities written for a given group (by default, all connected verbosities are written for all groups)
+        ///
+        /// For example, set_group_verbosity(DECODE, WARN_PLUS) keeps DEBUG messages from the decoder out of the log, without affecting the encoder.
+        /// \param group The group to filter
+        /// \param verbosity_mask A bitmask representing the verbosity or verbosities to write for this group
+        void set_group_verbosity(logger::Group group, int verbosity_mask)
+        { buf_.set_group_verbosity(group, verbosity_mask); }
+
+        /// \brief Write log messages from a background thread rather than from the thread that logged them
+        ///
+        /// Each thread builds its messages in its own buffer, and completed messages are passed to the background thread through a bounded lock-free queue of preallocated messages, so logging threads never wait on each other or on the slots. Slots are then called only from the background thread. Disabling asynchronous mode (or destroying the Logger) writes any messages still queued before returning.
+        ///
+        /// May be called while other threads are logging: they are held only until the previous background thread has written its queue.
+        /// \param async true to enable asynchronous mode, false to return to calling the slots from the logging thread
+        /// \param queue_capacity Maximum number of messages waiting to be written. Messages logged while the queue is full are dropped (and counted by dropped()).
+        void set_async(bool async, unsigned queue_capacity = 4096)
+        { buf_.set_async(async, queue_capacity); }
+
+        /// \brief Number of messages dropped because the asynchronous queue was full
+        unsigned long dropped() const
+        { return buf_.dropped(); }
         
       private:
         internal::LogBuffer buf_;
@@ -0,0 +1,212 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <cmath>
+#include <algorithm>
+#include <sys/time.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "message_generator.h"
+#include "common.h"
+#include "dynamic_protobuf_manager.h"
+#include "dccl/option_extensions.pb.h"
+
+dccl::MessageGenerator::MessageGenerator(unsigned seed /*= 1*/)
+    : rng_(seed),
+      optional_probability_(0.9),
+      worst_case_(false)
+{ }
+
+boost::shared_ptr<google::protobuf::Message> dccl::MessageGenerator::generate(const google::protobuf::Descriptor* desc)
+{
+    boost::shared_ptr<google::protobuf::Message> msg = DynamicProtobufManager::new_protobuf_message(desc);
+    generate(msg.get());
+    return msg;
+}
+
+void dccl::MessageGenerator::generate(google::protobuf::Message* msg)
+{
+    const google::protobuf::Descriptor* desc = msg->GetDescriptor();
+    for(int i = 0, n = desc->field_count(); i < n; ++i)
+    {
+        const google::protobuf::FieldDescriptor* field = desc->field(i);
+        const dccl::DCCLFieldOptions& options = field->options().GetExtension(dccl::field);
+        if(options.omit())
+            continue;
+
+        if(field->is_repeated())
+        {
+            for(unsigned j = 0, count = worst_case_ ? options.max_repeat() : uniform(options.max_repeat()); j < count; ++j)
+                generate_field(msg, field);
+        }
+        else if(field->is_required() || worst_case_ ||
+                boost::random::uniform_real_distribution<double>(0, 1)(rng_) < optional_probability_)
+        {
+            generate_field(msg, field);
+        }
+    }
+}
+
+void dccl::MessageGenerator::generate_field(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field)
+{
+    using google::protobuf::FieldDescriptor;
+
+    const google::protobuf::Reflection* refl = msg->GetReflection();
+    const dccl::DCCLFieldOptions& options = field->options().GetExtension(dccl::field);
+    const bool repeated = field->is_repeated();
+
+    if(field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+    {
+        generate(repeated ? refl->AddMessage(msg, field) : refl->MutableMessage(msg, field));
+        return;
+    }
+    
+    // string form of the value for static fields
+    std::string static_value;
+    const bool is_static = options.has_static_value();
+    if(is_static)
+        static_value = options.static_value();
+    
+    const bool numeric = field->cpp_type() != FieldDescriptor::CPPTYPE_BOOL &&
+        field->cpp_type() != FieldDescriptor::CPPTYPE_ENUM &&
+        field->cpp_type() != FieldDescriptor::CPPTYPE_STRING;
+    
+    double value = 0;
+    if(numeric && !is_static)
+    {
+        if(options.codec() == "_time" || options.codec() == "dccl.time2")
+        {
+            // within a quarter of the encoded time span (num_days) of now, so it decodes to the same time
+            timeval t;
+            gettimeofday(&t, 0);
+            double span = options.num_days() * 86400.0 / 4;
+            value = uniform(t.tv_sec - span, t.tv_sec + span, std::max(options.precision(), 0));
+            if(field->cpp_type() != FieldDescriptor::CPPTYPE_DOUBLE)
+                value = std::floor(value) * 1e6; // microseconds
+        }
+        else
+        {
+            // integers can be rounded to tens, hundreds, etc. with negative precision
+            int precision = (field->cpp_type() == FieldDescriptor::CPPTYPE_DOUBLE ||
+                             field->cpp_type() == FieldDescriptor::CPPTYPE_FLOAT) ?
+                options.precision() : std::min(options.precision(), 0);
+            
+            if(options.has_min() || options.has_max())
+                value = uniform(options.min(), options.max(), precision);
+            else
+                value = uniform(0, 100, precision);
+        }
+    }
+
+    switch(field->cpp_type())
+    {
+        case FieldDescriptor::CPPTYPE_INT32:
+        {
+            int32 v = is_static ? boost::lexical_cast<int32>(static_value) : static_cast<int32>(value);
+            repeated ? refl->AddInt32(msg, field, v) : refl->SetInt32(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_INT64:
+        {
+            int64 v = is_static ? boost::lexical_cast<int64>(static_value) : static_cast<int64>(value);
+            repeated ? refl->AddInt64(msg, field, v) : refl->SetInt64(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_UINT32:
+        {
+            uint32 v = is_static ? boost::lexical_cast<uint32>(static_value) : static_cast<uint32>(value);
+            repeated ? refl->AddUInt32(msg, field, v) : refl->SetUInt32(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_UINT64:
+        {
+            uint64 v = is_static ? boost::lexical_cast<uint64>(static_value) : static_cast<uint64>(value);
+            repeated ? refl->AddUInt64(msg, field, v) : refl->SetUInt64(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+        {
+            double v = is_static ? boost::lexical_cast<double>(static_value) : value;
+            repeated ? refl->AddDouble(msg, field, v) : refl->SetDouble(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_FLOAT:
+        {
+            float v = is_static ? boost::lexical_cast<float>(static_value) : static_cast<float>(value);
+            repeated ? refl->AddFloat(msg, field, v) : refl->SetFloat(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_BOOL:
+        {
+            // as parsed by StaticCodec<bool> ("1" or "0"), or written as in a .proto default
+            bool v = is_static ?
+                (static_value == "true" || (static_value != "false" && boost::lexical_cast<bool>(static_value))) :
+                uniform(1u);
+            repeated ? refl->AddBool(msg, field, v) : refl->SetBool(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_ENUM:
+        {
+            const google::protobuf::EnumDescriptor* enum_desc = field->enum_type();
+            const google::protobuf::EnumValueDescriptor* v = is_static ?
+                enum_desc->FindValueByName(static_value) :
+                enum_desc->value(uniform(static_cast<unsigned>(enum_desc->value_count() - 1)));
+            if(!v)
+                v = enum_desc->value(0);
+            repeated ? refl->AddEnum(msg, field, v) : refl->SetEnum(msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_STRING:
+        {
+            std::string v = static_value;
+            if(!is_static)
+            {
+                v.resize(worst_case_ ? options.max_length() : uniform(options.max_length()));
+                for(std::string::iterator it = v.begin(), end = v.end(); it != end; ++it)
+                    *it = (field->type() == FieldDescriptor::TYPE_BYTES) ? static_cast<char>(uniform(255u)) : static_cast<char>('a' + uniform(25u));
+            }
+            repeated ? refl->AddString(msg, field, v) : refl->SetString(msg, field, v);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+double dccl::MessageGenerator::uniform(double min, double max, int precision)
+{
+    double scale = std::pow(10.0, precision);
+    double value = std::floor(boost::random::uniform_real_distribution<double>(min, max)(rng_) * scale + 0.5) / scale;
+    // rounding may have pushed the value out of bounds
+    if(value > max)
+        value -= 1 / scale;
+    if(value < min)
+        value += 1 / scale;
+    return value;
+}
+
+unsigned dccl::MessageGenerator::uniform(unsigned max)
+{
+    return boost::random::uniform_int_distribution<unsigned>(0, max)(rng_);
+}
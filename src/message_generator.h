@@ -0,0 +1,72 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef DCCLMESSAGEGENERATOR20261019H
+#define DCCLMESSAGEGENERATOR20261019H
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+namespace dccl
+{
+    /// \brief Generates random messages that honor the DCCL options of each field (for benchmarks, soak and stress tests).
+    ///
+    /// Numeric fields are uniformly distributed within (dccl.field).min and max, rounded to (dccl.field).precision; strings and bytes have up to (dccl.field).max_length characters; repeated fields have up to (dccl.field).max_repeat values; enumerations take any of their values. Fields with a (dccl.field).static_value are given that value, and fields using the time codecs ("_time" or "dccl.time2") a time within a few hours of now. Fields without bounds (for codecs that don't need them) are given values in [0, 100]. Header fields ((dccl.field).in_head) are generated like any other field. Omitted fields ((dccl.field).omit) are left unset.
+    /// \ingroup dccl_api
+    class MessageGenerator
+    {
+      public:
+        /// \brief Constructor
+        ///
+        /// \param seed Seed for the random number generator (the same seed always generates the same messages)
+        explicit MessageGenerator(unsigned seed = 1);
+
+        /// \brief Set the probability (0 to 1) that each optional field is set (default 0.9)
+        void set_optional_probability(double p) { optional_probability_ = p; }
+        
+        /// \brief Generate the largest messages: all optional fields set, max_repeat values for repeated fields and max_length strings and bytes
+        void set_worst_case(bool worst_case) { worst_case_ = worst_case; }
+        
+        /// \brief Fill the (empty) message with random values
+        void generate(google::protobuf::Message* msg);
+        
+        /// \brief Create a new message of the given type, filled with random values
+        boost::shared_ptr<google::protobuf::Message> generate(const google::protobuf::Descriptor* desc);
+
+      private:
+        void generate_field(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field);
+        
+        // uniformly distributed in [min, max], rounded to the given number of decimal places
+        double uniform(double min, double max, int precision);
+        // uniformly distributed in [0, max]
+        unsigned uniform(unsigned max);
+        
+      private:
+        boost::random::mt19937 rng_;
+        double optional_probability_;
+        bool worst_case_;
+    };
+}
+
+#endif
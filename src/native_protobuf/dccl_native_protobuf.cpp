@@ -23,6 +23,8 @@
 #include "dccl_native_protobuf.h"
 #include "dccl/codec.h"
 
+using namespace dccl::logger;
+
 extern "C"
 {
     void dccl3_load(dccl::Codec* dccl)
@@ -68,9 +70,8 @@ extern "C"
 
         FieldCodecManager::add<EnumFieldCodec, FieldDescriptor::TYPE_ENUM>(native_pb_group);
 
-        
-        // ADD ENUM
-        
+        FieldCodecManager::add<StringFieldCodec, FieldDescriptor::TYPE_STRING>(native_pb_group);
+        FieldCodecManager::add<StringFieldCodec, FieldDescriptor::TYPE_BYTES>(native_pb_group);
     }
     
     void dccl3_unload(dccl::Codec* dccl)
@@ -115,6 +116,9 @@ extern "C"
         
         FieldCodecManager::remove<EnumFieldCodec, FieldDescriptor::TYPE_ENUM>(native_pb_group);
 
+        FieldCodecManager::remove<StringFieldCodec, FieldDescriptor::TYPE_STRING>(native_pb_group);
+        FieldCodecManager::remove<StringFieldCodec, FieldDescriptor::TYPE_BYTES>(native_pb_group);
+
         
         FieldCodecManager::remove<v3::DefaultMessageCodec, FieldDescriptor::TYPE_MESSAGE>(native_pb_group);
                     
@@ -137,3 +141,83 @@ const google::protobuf::EnumValueDescriptor* dccl::native_protobuf::EnumFieldCod
     else
         throw NullValueException();
 }
+
+dccl::Bitset dccl::native_protobuf::StringFieldCodec::encode()
+{
+    // presence bit not set (optional) or zero length (required)
+    return Bitset(min_size(), 0);
+}
+
+dccl::Bitset dccl::native_protobuf::StringFieldCodec::encode(const std::string& wire_value)
+{
+    std::string s = wire_value;
+    if(s.size() > dccl_field_options().max_length())
+    {
+        if(this->strict())
+            throw(dccl::OutOfRangeException(std::string("String too long for field: ") + FieldCodecBase::this_field()->DebugString(), this->this_field()));
+                
+        dccl::dlog.is(DEBUG2) && dccl::dlog << "String " << s <<  " exceeds `dccl.max_length`, truncating" << std::endl;
+        s.resize(dccl_field_options().max_length()); 
+    }
+
+    Bitset bits;
+    if(!this->use_required())
+        bits.push_back(true); // presence bit
+    
+    append_varint(&bits, s.size());
+    for(std::string::const_iterator it = s.begin(), end = s.end(); it != end; ++it)
+        append_fixed(&bits, static_cast<unsigned char>(*it), 1);
+    return bits;
+}
+
+std::string dccl::native_protobuf::StringFieldCodec::decode(Bitset* bits)
+{
+    if(!this->use_required())
+    {
+        if(!bits->test(0)) throw NullValueException();
+        bits->resize(0);
+    }
+
+    unsigned offset = 0;
+    // check the full varint before narrowing it, so a corrupt length can't wrap to a valid one
+    const dccl::uint64 encoded_length = read_varint(bits, &offset);
+    if(encoded_length > dccl_field_options().max_length())
+        throw(Exception("String length exceeds max_length for field: " + this_field()->DebugString()));
+    const unsigned length = static_cast<unsigned>(encoded_length);
+
+    // get all the bytes at once
+    bits->get_more_bits(offset + length*BITS_IN_BYTE - bits->size());
+    
+    std::string s(length, 0);
+    for(unsigned i = 0; i < length; ++i)
+        s[i] = read_fixed(bits, 1, &offset);
+    return s;
+}
+
+unsigned dccl::native_protobuf::StringFieldCodec::size()
+{
+    return min_size();
+}
+
+unsigned dccl::native_protobuf::StringFieldCodec::size(const std::string& wire_value)
+{
+    unsigned length = std::min<unsigned>(wire_value.size(), dccl_field_options().max_length());
+    return presence_bit_size() + BITS_IN_BYTE*(varint_size(length) + length);
+}
+
+unsigned dccl::native_protobuf::StringFieldCodec::max_size()
+{
+    unsigned length = dccl_field_options().max_length();
+    return presence_bit_size() + BITS_IN_BYTE*(varint_size(length) + length);
+}
+
+unsigned dccl::native_protobuf::StringFieldCodec::min_size()
+{
+    // presence bit (optional) or a zero length (required)
+    return this->use_required() ? BITS_IN_BYTE : presence_bit_size();
+}
+
+void dccl::native_protobuf::StringFieldCodec::validate()
+{
+    require(dccl_field_options().has_max_length(), "missing (dccl.field).max_length");
+}
@@ -32,6 +32,8 @@
 #include <google/protobuf/wire_format_lite_inl.h> // this .h has been removed in protobuf 3.8
 #endif
 
+#include <boost/lexical_cast.hpp>
+
 #include "dccl/field_codec_fixed.h"
 #include "dccl/field_codec_typed.h"
 
@@ -41,165 +43,258 @@ namespace dccl
 namespace native_protobuf
 {
 
-template<typename WireType, google::protobuf::internal::WireFormatLite::FieldType DeclaredType>
-struct PrimitiveTypeHelperBase
+/// \brief Appends the lowest num_bytes bytes of value (least significant byte first) to the big end of bits
+inline void append_fixed(Bitset* bits, dccl::uint64 value, unsigned num_bytes)
+{
+    for(unsigned i = 0, n = num_bytes*BITS_IN_BYTE; i < n; ++i)
+        bits->push_back((value >> i) & 1);
+}
+
+/// \brief Appends value as a Google Protocol Buffers base 128 varint to the big end of bits
+inline void append_varint(Bitset* bits, dccl::uint64 value)
+{
+    do
+    {
+        // most significant bit indicates if more bytes follow
+        unsigned byte = value & 0x7F;
+        value >>= 7;
+        if(value)
+            byte |= 0x80;
+        append_fixed(bits, byte, 1);
+    } while(value);
+}
+
+/// \brief Reads num_bytes bytes (least significant byte first) from bits starting at bit *offset (which is advanced past them), getting more bits from the parent of bits as needed
+inline dccl::uint64 read_fixed(Bitset* bits, unsigned num_bytes, unsigned* offset)
 {
-    WireType decode(google::protobuf::io::CodedInputStream* input_stream)
+    unsigned num_bits = num_bytes*BITS_IN_BYTE;
+    if(bits->size() < *offset + num_bits)
+        bits->get_more_bits(*offset + num_bits - bits->size());
+
+    dccl::uint64 value = 0;
+    for(unsigned i = 0; i < num_bits; ++i)
     {
-       WireType value;
-       google::protobuf::internal::WireFormatLite::ReadPrimitive<WireType, DeclaredType>(input_stream, &value);
-       return value;
+        if((*bits)[*offset + i])
+            value |= static_cast<dccl::uint64>(1) << i;
     }
-};
+    *offset += num_bits;
+    return value;
+}
+
+/// \brief Reads a Google Protocol Buffers base 128 varint from bits starting at bit *offset (which is advanced past it), getting more bits (one byte at a time) from the parent of bits until the last byte of the varint
+inline dccl::uint64 read_varint(Bitset* bits, unsigned* offset)
+{
+    // longest varint (64-bit value)
+    const unsigned max_varint_bytes = 10;
     
+    dccl::uint64 value = 0;
+    for(unsigned byte_index = 0; byte_index < max_varint_bytes; ++byte_index)
+    {
+        unsigned byte_begin = *offset + byte_index*BITS_IN_BYTE;
+        if(bits->size() < byte_begin + BITS_IN_BYTE)
+            bits->get_more_bits(byte_begin + BITS_IN_BYTE - bits->size());
+
+        for(unsigned i = 0; i < 7; ++i)
+        {
+            if((*bits)[byte_begin + i] && (7*byte_index + i) < 64)
+                value |= static_cast<dccl::uint64>(1) << (7*byte_index + i);
+        }
+
+        // most significant bit indicates if more bytes follow
+        if(!(*bits)[byte_begin + 7])
+        {
+            *offset = byte_begin + BITS_IN_BYTE;
+            return value;
+        }
+    }
+    throw(Exception("Invalid varint: more than 10 bytes"));
+}
+
+/// \brief Size (in bytes) of value encoded as a varint
+inline unsigned varint_size(dccl::uint64 value)
+{
+    return google::protobuf::io::CodedOutputStream::VarintSize64(value);
+}
+
 
+/// \brief Converts between the field's wire type and the Google Protocol Buffers encoding of the field's declared type: the varint value (is_varint() == true) or the bytes of the fixed size value (is_varint() == false)
 template<typename WireType, google::protobuf::FieldDescriptor::Type DeclaredType>
 struct PrimitiveTypeHelper
 {   
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_INT64> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_INT64>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_INT64>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::Int64Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteInt64NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return static_cast<dccl::uint64>(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return true; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_INT32> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_INT32>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_INT32>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::Int32Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteInt32NoTagToArray(wire_value, &(*bytes)[0]); }
+    // negative values are sign extended to 64 bits
+    dccl::uint64 encode(WireType wire_value)
+    { return static_cast<dccl::uint64>(static_cast<dccl::int64>(wire_value)); }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return true; }
 };
 
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_UINT64> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_UINT64>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_UINT64>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::UInt64Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteUInt64NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return wire_value; }
+    WireType decode(dccl::uint64 value)
+    { return value; }
     bool is_varint() { return true; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_UINT32> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_UINT32>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_UINT32>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::UInt32Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteUInt32NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return wire_value; }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return true; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SINT64> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_SINT64>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SINT64>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::SInt64Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteSInt64NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return google::protobuf::internal::WireFormatLite::ZigZagEncode64(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return google::protobuf::internal::WireFormatLite::ZigZagDecode64(value); }
     bool is_varint() { return true; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SINT32> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_SINT32>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SINT32>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::SInt32Size(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteSInt32NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return google::protobuf::internal::WireFormatLite::ZigZagEncode32(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return google::protobuf::internal::WireFormatLite::ZigZagDecode32(static_cast<dccl::uint32>(value)); }
     bool is_varint() { return true; }
 };
 
 
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_ENUM> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_ENUM>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_ENUM>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::EnumSize(wire_value); }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteEnumNoTagToArray(wire_value, &(*bytes)[0]); }
+    // encoded like int32
+    dccl::uint64 encode(WireType wire_value)
+    { return static_cast<dccl::uint64>(static_cast<dccl::int64>(wire_value)); }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return true; }
 };
 
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_DOUBLE> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_DOUBLE>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_DOUBLE>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kDoubleSize; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteDoubleNoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return google::protobuf::internal::WireFormatLite::EncodeDouble(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return google::protobuf::internal::WireFormatLite::DecodeDouble(value); }
     bool is_varint() { return false; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FLOAT> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_FLOAT>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FLOAT>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kFloatSize; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteFloatNoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return google::protobuf::internal::WireFormatLite::EncodeFloat(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return google::protobuf::internal::WireFormatLite::DecodeFloat(static_cast<dccl::uint32>(value)); }
     bool is_varint() { return false; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_BOOL> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_BOOL>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_BOOL>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kBoolSize; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteBoolNoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return wire_value ? 1 : 0; }
+    WireType decode(dccl::uint64 value)
+    { return value != 0; }
     bool is_varint() { return false; }
 };
 
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FIXED64> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_FIXED64>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FIXED64>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kFixed64Size; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteFixed64NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return wire_value; }
+    WireType decode(dccl::uint64 value)
+    { return value; }
     bool is_varint() { return false; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FIXED32> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_FIXED32>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_FIXED32>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kFixed32Size; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteFixed32NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return wire_value; }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return false; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SFIXED64> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_SFIXED64>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SFIXED64>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kSFixed64Size; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteSFixed64NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return static_cast<dccl::uint64>(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(value); }
     bool is_varint() { return false; }
 };
 
 template<typename WireType>
-struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SFIXED32> : public PrimitiveTypeHelperBase<WireType, google::protobuf::internal::WireFormatLite::TYPE_SFIXED32>
+struct PrimitiveTypeHelper<WireType, google::protobuf::FieldDescriptor::TYPE_SFIXED32>
 {
     unsigned byte_size(const WireType& wire_value)
     { return google::protobuf::internal::WireFormatLite::kSFixed32Size; }
-    void encode(WireType wire_value, std::vector<google::protobuf::uint8>* bytes)
-    { google::protobuf::internal::WireFormatLite::WriteSFixed32NoTagToArray(wire_value, &(*bytes)[0]); }
+    dccl::uint64 encode(WireType wire_value)
+    { return static_cast<dccl::uint32>(wire_value); }
+    WireType decode(dccl::uint64 value)
+    { return static_cast<WireType>(static_cast<dccl::uint32>(value)); }
     bool is_varint() { return false; }
 };
 
@@ -231,10 +326,15 @@ private:
         }
 
     unsigned max_size()
+        {
+            return presence_bit_size() + BITS_IN_BYTE*max_value_bytes();
+        }
+
+    unsigned max_value_bytes()
         {
             // Int32 and Int64 use more space for large negative numbers
-            return std::max<unsigned>(size(std::numeric_limits<WireType>::min()),
-                                      size(std::numeric_limits<WireType>::max()));
+            return std::max<unsigned>(helper_.byte_size(std::numeric_limits<WireType>::min()),
+                                      helper_.byte_size(std::numeric_limits<WireType>::max()));
         }
     
     unsigned size() 
@@ -257,18 +357,13 @@ private:
     
     Bitset encode(const WireType& wire_value)
         {
-            std::vector<google::protobuf::uint8> bytes(size(wire_value) / BITS_IN_BYTE, 0);
-            
-            helper_.encode(wire_value, &bytes);
-
+            // written directly into the Bitset (least significant bit first), which gives the same bits as
+            // the protobuf encoded bytes converted with Bitset::from_byte_stream
             Bitset data_bits;
-            data_bits.from_byte_stream(bytes.begin(), bytes.end());
             if(!this->use_required())
-            {
-                data_bits.resize(data_bits.size() + presence_bit_size());
-                data_bits <<= 1;
-                data_bits.set(0, true); // presence bit
-            }            
+                data_bits.push_back(true); // presence bit
+
+            encode_value(&data_bits, wire_value);
             return data_bits;
         }
 
@@ -277,34 +372,155 @@ private:
         {
             if(!this->use_required())
             {
-                dccl::uint64 uint_value = (bits->template to<dccl::uint64>)();
-                if(!uint_value) throw NullValueException();
+                if(!bits->test(0)) throw NullValueException();
                 bits->resize(0);
-                
-                if(helper_.is_varint())
-                    bits->get_more_bits(BITS_IN_BYTE);
-                else
-                    bits->get_more_bits(BITS_IN_BYTE*helper_.byte_size(WireType()));
             }
 
-            if(helper_.is_varint())
+            unsigned offset = 0;
+            return decode_value(bits, &offset);
+        }    
+
+    // fields declared [packed=true] are packed as in Google Protocol Buffers: the length in bytes of all the values (as a varint), followed by the values.
+    // Other repeated fields keep the DCCL encoding (a size prefix, followed by each value as if it were an optional field)
+    bool packed()
+        {
+            return this->this_field()->is_packed();
+        }
+
+    void any_encode_repeated(Bitset* bits, const std::vector<boost::any>& wire_values)
+        {
+            if(!packed())
+                return FieldCodecBase::any_encode_repeated(bits, wire_values);
+
+            if(wire_values.size() > this->dccl_field_options().max_repeat())
+                throw(dccl::OutOfRangeException(std::string("Repeated size exceeds max_repeat for field: ") + this->this_field()->DebugString(), this->this_field()));
+
+            Bitset value_bits;
+            try
+            {
+                for(std::vector<boost::any>::const_iterator it = wire_values.begin(), end = wire_values.end(); it != end; ++it)
+                {
+                    if(!it->empty())
+                        encode_value(&value_bits, boost::any_cast<WireType>(*it));
+                }
+            }
+            catch(boost::bad_any_cast&)
             {
-                // most significant bit indicates if more bytes are needed
-                while(bits->test(bits->size()-1))
-                    bits->get_more_bits(BITS_IN_BYTE);
+                throw(type_error("encode_repeated", typeid(WireType), wire_values.at(0).type()));
             }
-                            
-            std::string bytes = bits->to_byte_string();
-            google::protobuf::io::CodedInputStream input_stream(reinterpret_cast<const google::protobuf::uint8*>(bytes.data()), bytes.size());
+            
+            append_varint(bits, value_bits.size() / BITS_IN_BYTE);
+            bits->append(value_bits);
+        }
 
-            return helper_.decode(&input_stream);
-        }    
+    void any_decode_repeated(Bitset* repeated_bits, std::vector<boost::any>* wire_values)
+        {
+            if(!packed())
+                return FieldCodecBase::any_decode_repeated(repeated_bits, wire_values);
+
+            unsigned offset = 0;
+            const dccl::uint64 value_bytes = read_varint(repeated_bits, &offset);
+
+            // check the length before using it, so a corrupt length can't overflow end or make us fetch a huge number of bits
+            const dccl::uint64 max_bytes = static_cast<dccl::uint64>(this->dccl_field_options().max_repeat())*max_value_bytes();
+            if(value_bytes > max_bytes)
+                throw(Exception("Packed repeated length of " + boost::lexical_cast<std::string>(value_bytes) + " bytes exceeds the maximum of " + boost::lexical_cast<std::string>(max_bytes) + " for field: " + this->this_field()->DebugString()));
+            
+            unsigned end = static_cast<unsigned>(value_bytes)*BITS_IN_BYTE + offset;
+
+            // get all the values at once, rather than one value (or byte) at a time
+            if(repeated_bits->size() < end)
+                repeated_bits->get_more_bits(end - repeated_bits->size());
+            
+            wire_values->clear();
+            while(offset < end)
+                wire_values->push_back(decode_value(repeated_bits, &offset));
+
+            if(offset != end)
+                throw(Exception("Packed repeated values do not match their length for field: " + this->this_field()->DebugString()));
+            if(wire_values->size() > this->dccl_field_options().max_repeat())
+                throw(Exception("Repeated size exceeds max_repeat for field: " + this->this_field()->DebugString()));
+        }
+
+    unsigned any_size_repeated(const std::vector<boost::any>& wire_values)
+        {
+            if(!packed())
+                return FieldCodecBase::any_size_repeated(wire_values);
+
+            unsigned value_bytes = 0;
+            try
+            {
+                for(std::vector<boost::any>::const_iterator it = wire_values.begin(), end = wire_values.end(); it != end; ++it)
+                {
+                    if(!it->empty())
+                        value_bytes += helper_.byte_size(boost::any_cast<WireType>(*it));
+                }
+            }
+            catch(boost::bad_any_cast&)
+            {
+                throw(type_error("size_repeated", typeid(WireType), wire_values.at(0).type()));
+            }
+            return BITS_IN_BYTE*(varint_size(value_bytes) + value_bytes);
+        }
+    
+    unsigned max_size_repeated()
+        {
+            if(!packed())
+                return FieldCodecBase::max_size_repeated();
+
+            unsigned value_bytes = this->dccl_field_options().max_repeat()*max_value_bytes();
+            return BITS_IN_BYTE*(varint_size(value_bytes) + value_bytes);
+        }
+    
+    unsigned min_size_repeated()
+        {
+            if(!packed())
+                return FieldCodecBase::min_size_repeated();
+
+            // length of zero
+            return BITS_IN_BYTE;
+        }
+
+    void encode_value(Bitset* bits, const WireType& wire_value)
+        {
+            if(helper_.is_varint())
+                append_varint(bits, helper_.encode(wire_value));
+            else
+                append_fixed(bits, helper_.encode(wire_value), helper_.byte_size(wire_value));
+        }
+
+    WireType decode_value(Bitset* bits, unsigned* offset)
+        {
+            if(helper_.is_varint())
+                return helper_.decode(read_varint(bits, offset));
+            else
+                return helper_.decode(read_fixed(bits, helper_.byte_size(WireType()), offset));
+        }
 
 private:
     PrimitiveTypeHelper<WireType, DeclaredType> helper_;
 
 };
 
+/// Encodes string and bytes fields as Google Protocol Buffers does: the length in bytes (as a varint) followed by the bytes. Fields that are not required are preceded by a presence bit.
+class StringFieldCodec : public TypedFieldCodec<std::string>
+{
+private:
+    Bitset encode();
+    Bitset encode(const std::string& wire_value);
+    std::string decode(Bitset* bits);
+    unsigned size();
+    unsigned size(const std::string& wire_value);
+    unsigned max_size();
+    unsigned min_size();
+    void validate();
+
+    unsigned presence_bit_size()
+        {
+            return this->use_required() ? 0 : 1;
+        }
+};
+
 class EnumFieldCodec : public PrimitiveTypeFieldCodec<int, google::protobuf::FieldDescriptor::TYPE_ENUM, const google::protobuf::EnumValueDescriptor*>
 {
 public:
@@ -314,6 +314,57 @@ int main(int argc, char* argv[])
         run_test(model, msg_in);
     }
 
+    // uniformly spaced bounds use the direct mapping, which must agree with the search
+    // used for non-uniform bounds
+    {
+        dccl::arith::protobuf::ArithmeticModel uniform_model;
+        uniform_model.set_name("uniform");
+        dccl::arith::protobuf::ArithmeticModel nonuniform_model;
+        nonuniform_model.set_name("nonuniform");
+
+        const int symbols = 200;
+        for(int j = 0; j <= symbols; ++j)
+        {
+            uniform_model.add_value_bound(-10 + j*0.1);
+            nonuniform_model.add_value_bound(-10 + j*0.1 + ((j == symbols/2) ? 0.05 : 0));
+            if(j < symbols)
+            {
+                uniform_model.add_frequency(1);
+                nonuniform_model.add_frequency(1);
+            }
+        }
+
+        dccl::arith::ModelManager::set_model(uniform_model);
+        dccl::arith::ModelManager::set_model(nonuniform_model);
+
+        const dccl::arith::Model& uniform = dccl::arith::ModelManager::find("uniform");
+        const dccl::arith::Model& nonuniform = dccl::arith::ModelManager::find("nonuniform");
+        assert(uniform.uniform_bounds());
+        assert(!nonuniform.uniform_bounds());
+
+        for(double value = -10.5; value <= 10.5; value += 0.0037)
+        {
+            dccl::arith::Model::symbol_type symbol = uniform.value_to_symbol(value);
+            dccl::arith::Model::symbol_type expected = dccl::arith::Model::OUT_OF_RANGE_SYMBOL;
+            if(value >= uniform.user_model().value_bound(0) &&
+               value <= uniform.user_model().value_bound(symbols))
+            {
+                const google::protobuf::RepeatedField<double>& bounds = uniform.user_model().value_bound();
+                int upper = std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+                expected = upper - 1;
+                if(upper < bounds.size() &&
+                   std::abs(bounds.Get(upper)*bounds.Get(upper) - value*value) <= std::abs(bounds.Get(upper-1)*bounds.Get(upper-1) - value*value))
+                    expected = upper;
+            }
+            assert(symbol == expected);
+            if(symbol >= 0)
+                assert(uniform.symbol_to_value(symbol) == uniform.user_model().value_bound(symbol));
+
+            if(std::abs(value) > 0.2)
+                assert(nonuniform.value_to_symbol(value) == symbol);
+        }
+    }
+
     // randomly generate a model and a message
     // loop over all message lengths from 0 to 100
     srand ( time(NULL) );
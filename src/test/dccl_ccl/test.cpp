@@ -133,6 +133,24 @@ int main(int argc, char* argv[])
     assert(state_out.SerializeAsString() == state_out_2.SerializeAsString());
     assert(test_state_encoded == dccl::hex_encode(state_encoded));
         
+    // the year isn't encoded, so archived messages take that of the reference time
+    {
+        boost::posix_time::ptime archive_time(boost::gregorian::date(1998, boost::date_time::Jun, 1));
+        codec.set_reference_time(dccl::legacyccl::TimeDateCodec::to_uint64_time(archive_time) / 1e6);
+
+        dccl::legacyccl::protobuf::CCLMDATState state_archive;
+        codec.decode(dccl::hex_decode(test_state_encoded), &state_archive);
+        boost::posix_time::ptime expected(
+            boost::gregorian::date(1998, boost::date_time::Mar, 4), 
+            boost::posix_time::time_duration(17,1,44));
+        assert(state_archive.time_date() == dccl::legacyccl::TimeDateCodec::to_uint64_time(expected));
+        assert(state_archive.SerializeAsString() != state_out.SerializeAsString());
+        state_archive.set_time_date(state_out.time_date());
+        assert(state_archive.SerializeAsString() == state_out.SerializeAsString());
+
+        codec.set_reference_time_function(dccl::FieldCodecBase::ReferenceTimeFunction());
+    }
+        
     std::cout << dccl::hex_encode(state_out.faults()) << std::endl;
     std::cout << dccl::hex_encode(state_out.faults_2()) << std::endl;
         
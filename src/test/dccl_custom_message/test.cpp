@@ -219,7 +219,26 @@ int main(int argc, char* argv[])
     codec.decode(bytes2, &msg_out2);
     std::cout << "... got Message out:\n" << msg_out2.DebugString() << std::endl;
     assert(msg_in2.SerializeAsString() == msg_out2.SerializeAsString());
-    
+
+    // batch encode / decode must match the single message versions
+    std::vector<const google::protobuf::Message*> msgs_in;
+    for(int i = 0; i < 10; ++i)
+    {
+        msgs_in.push_back(&msg_in1);
+        msgs_in.push_back(&msg_in2);
+    }
+    std::vector<std::string> bytes_many;
+    codec.encode_many(&bytes_many, msgs_in);
+    assert(bytes_many.size() == msgs_in.size());
+    for(int i = 0, n = bytes_many.size(); i < n; ++i)
+        assert(bytes_many[i] == ((i % 2) ? bytes2 : bytes1));
+
+    std::vector<boost::shared_ptr<google::protobuf::Message> > msgs_out;
+    codec.decode_many(bytes_many, &msgs_out);
+    assert(msgs_out.size() == msgs_in.size());
+    for(int i = 0, n = msgs_out.size(); i < n; ++i)
+        assert(msgs_out[i]->SerializeAsString() == msgs_in[i]->SerializeAsString());
+
     std::cout << "all tests passed" << std::endl;
 }
 
@@ -26,9 +26,20 @@
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/text_format.h>
 #include <iostream>
+#include <pthread.h>
 
 #include "test_a.pb.h"
 
+// looks up the same types as the other threads, to exercise the find_descriptor() cache
+void* find_from_thread(void*) {
+  for (int i = 0; i < 1000; ++i) {
+    assert(dccl::DynamicProtobufManager::find_descriptor("A"));
+    assert(dccl::DynamicProtobufManager::find_descriptor("B"));
+    assert(!dccl::DynamicProtobufManager::find_descriptor("G"));
+  }
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   if (argc != 2) {
     std::cerr << "Usage: " << argv[0] << " /path/to/libtest_dyn_protobuf"
@@ -101,6 +112,47 @@ int main(int argc, char *argv[]) {
         dccl::DynamicProtobufManager::new_protobuf_message("E");
     std::cout << edyn_msg->GetDescriptor()->DebugString() << std::endl;
 
+    // adding a database keeps the descriptors already found, and finds types previously missing
+    const google::protobuf::Descriptor* e_desc =
+        dccl::DynamicProtobufManager::find_descriptor("E");
+    assert(e_desc == edyn_msg->GetDescriptor());
+
+    google::protobuf::FileDescriptorProto c_proto;
+    std::string c_proto_str =
+        "name: \"goby/test/util/dynamic_protobuf/test_c.proto\" "
+        "message_type {   name: \"C\"   field {     name: \"c1\"     "
+        "number: 1     label: LABEL_REQUIRED     type: TYPE_DOUBLE  } } ";
+    google::protobuf::TextFormat::ParseFromString(c_proto_str, &c_proto);
+
+    boost::shared_ptr<google::protobuf::SimpleDescriptorDatabase> c_database(
+        new google::protobuf::SimpleDescriptorDatabase);
+    c_database->Add(c_proto);
+    dccl::DynamicProtobufManager::add_database(c_database);
+
+    assert(dccl::DynamicProtobufManager::find_descriptor("E") == e_desc);
+    assert(dccl::DynamicProtobufManager::find_descriptor("C"));
+    assert(dccl::DynamicProtobufManager::find_descriptor("C")->full_name() == "C");
+
+    // a failed lookup is not cached, so the type is found once its file is added
+    assert(!dccl::DynamicProtobufManager::find_descriptor("F"));
+    google::protobuf::FileDescriptorProto f_proto;
+    std::string f_proto_str =
+        "name: \"goby/test/util/dynamic_protobuf/test_f.proto\" "
+        "message_type {   name: \"F\"   field {     name: \"f1\"     "
+        "number: 1     label: LABEL_REQUIRED     type: TYPE_DOUBLE  } } ";
+    google::protobuf::TextFormat::ParseFromString(f_proto_str, &f_proto);
+    dccl::DynamicProtobufManager::add_protobuf_file(f_proto);
+    assert(dccl::DynamicProtobufManager::find_descriptor("F"));
+    assert(dccl::DynamicProtobufManager::find_descriptor("F")->full_name() == "F");
+
+    // concurrent lookups
+    const int num_threads = 4;
+    pthread_t threads[num_threads];
+    for (int i = 0; i < num_threads; ++i)
+      pthread_create(&threads[i], 0, &find_from_thread, 0);
+    for (int i = 0; i < num_threads; ++i)
+      pthread_join(threads[i], 0);
+
     std::cout << "all tests passed" << std::endl;
   }
 
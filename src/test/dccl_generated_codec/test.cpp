@@ -0,0 +1,339 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests the message codecs (generate_codecs parameter) and plain structs (generate_structs parameter) generated by protoc-gen-dccl against the DefaultMessageCodec
+
+#include <cstring>
+
+#include <google/protobuf/dynamic_message.h>
+
+#include "dccl/codec.h"
+#include "dccl/codecs3/field_codec_generated.h"
+#include "dccl/message_generator.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+google::protobuf::DynamicMessageFactory dynamic_factory;
+
+// a copy of msg that is not the generated class, so it is encoded by the DefaultMessageCodec
+boost::shared_ptr<google::protobuf::Message> dynamic_copy(const google::protobuf::Message& msg)
+{
+    boost::shared_ptr<google::protobuf::Message> copy(dynamic_factory.GetPrototype(msg.GetDescriptor())->New());
+    copy->ParsePartialFromString(msg.SerializePartialAsString());
+    return copy;
+}
+
+// the generated and reflection codecs must give the same bytes, sizes and decoded messages
+void check_same(dccl::Codec& codec, const google::protobuf::Message& msg, bool header_only = false)
+{
+    boost::shared_ptr<google::protobuf::Message> dynamic_msg = dynamic_copy(msg);
+
+    std::string bytes, dynamic_bytes;
+    codec.encode(&bytes, msg, header_only);
+    codec.encode(&dynamic_bytes, *dynamic_msg, header_only);
+    assert(bytes == dynamic_bytes);
+    if(!header_only)
+    {
+        assert(codec.size(msg) == codec.size(*dynamic_msg));
+        assert(codec.size(msg) == bytes.size());
+    }
+
+    boost::shared_ptr<google::protobuf::Message> decoded(msg.New());
+    boost::shared_ptr<google::protobuf::Message> dynamic_decoded(dynamic_msg->New());
+    codec.decode(bytes, decoded.get(), header_only);
+    codec.decode(bytes, dynamic_decoded.get(), header_only);
+    assert(decoded->SerializePartialAsString() == dynamic_decoded->SerializePartialAsString());
+}
+
+// the generated struct must decode the bytes of msg into the same values as the Codec, and encode them back to the same bytes
+template<typename ProtobufMessage, typename Struct>
+    void check_struct(dccl::Codec& codec, const ProtobufMessage& msg, void (*check_fields)(const ProtobufMessage&, const Struct&))
+{
+    std::string bytes, head;
+    codec.encode(&bytes, msg);
+    codec.encode(&head, msg, true);
+
+    ProtobufMessage decoded;
+    codec.decode(bytes, &decoded);
+
+    Struct s;
+    std::size_t consumed = s.decode(bytes.data(), bytes.size());
+    assert(consumed == bytes.size());
+    check_fields(decoded, s);
+
+    char buffer[Struct::DCCL_MAX_ENCODED_BYTES];
+    std::size_t size = s.encode(buffer, sizeof(buffer));
+    assert(std::string(buffer, size) == bytes);
+    size = s.encode(buffer, sizeof(buffer), true);
+    assert(std::string(buffer, size) == head);
+
+    Struct head_only;
+    consumed = head_only.decode(head.data(), head.size(), true);
+    assert(consumed == head.size());
+}
+
+void check_generated_fields(const GeneratedMsg& msg, const GeneratedMsg_DCCLStruct& s)
+{
+    assert(s.head_i == msg.head_i());
+    assert(s.has_head_b == msg.has_head_b() && s.head_b == msg.head_b());
+    assert(s.d == msg.d());
+    assert(s.has_od == msg.has_od() && s.od == msg.od());
+    assert(s.has_f == msg.has_f() && s.f == msg.f());
+    assert(s.i32 == msg.i32());
+    assert(s.has_u64 == msg.has_u64() && s.u64 == msg.u64());
+    assert(s.b == msg.b());
+    assert(s.has_mode == msg.has_mode() && (!s.has_mode || s.mode == msg.mode()));
+    assert(s.level == msg.level());
+    assert(s.has_olevel == msg.has_olevel() && (!s.has_olevel || s.olevel == msg.olevel()));
+    assert(static_cast<int>(s.ri_size) == msg.ri_size());
+    for(int i = 0; i < msg.ri_size(); ++i)
+        assert(s.ri[i] == msg.ri(i));
+    assert(static_cast<int>(s.rd_size) == msg.rd_size());
+    for(int i = 0; i < msg.rd_size(); ++i)
+        assert(s.rd[i] == msg.rd(i));
+    assert(static_cast<int>(s.rmode_size) == msg.rmode_size());
+    for(int i = 0; i < msg.rmode_size(); ++i)
+        assert(s.rmode[i] == msg.rmode(i));
+}
+
+void check_not_generated_fields(const NotGeneratedMsg& msg, const NotGeneratedMsg_DCCLStruct& s)
+{
+    assert(s.has_i == msg.has_i() && s.i == msg.i());
+    assert(s.has_s == msg.has_s() && std::string(s.s, s.s_size) == msg.s());
+}
+
+void check_struct_fields(const StructMsg& msg, const StructMsg_DCCLStruct& s)
+{
+    assert(s.has_head_i == msg.has_head_i() && s.head_i == msg.head_i());
+    assert(std::string(s.head_b, s.head_b_size) == msg.head_b());
+    assert(std::string(s.rs, s.rs_size) == msg.rs());
+    assert(s.has_s == msg.has_s() && std::string(s.s, s.s_size) == msg.s());
+    assert(s.has_ob == msg.has_ob() && std::string(s.ob, s.ob_size) == msg.ob());
+    assert(static_cast<int>(s.levels_size) == msg.levels_size());
+    for(int i = 0; i < msg.levels_size(); ++i)
+        assert(s.levels[i] == msg.levels(i));
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+
+    dccl::Codec codec;
+    codec.load<GeneratedMsg>();
+    codec.load<NotGeneratedMsg>();
+    codec.load<SmallMsg>();
+    codec.load<EmbedsMsg>();
+    codec.load<StructMsg>();
+
+    // registered for the generated messages only
+    const std::string codec_name = dccl::Codec::default_codec_name(3);
+    boost::shared_ptr<dccl::FieldCodecBase> reflection = dccl::FieldCodecManager::find(google::protobuf::FieldDescriptor::TYPE_MESSAGE, codec_name);
+    boost::shared_ptr<dccl::FieldCodecBase> generated = dccl::FieldCodecManager::find(GeneratedMsg::descriptor());
+    assert(dynamic_cast<dccl::v3::GeneratedMessageCodec<GeneratedMsg>*>(generated.get()));
+    assert(dynamic_cast<dccl::v3::GeneratedMessageCodec<SmallMsg>*>(dccl::FieldCodecManager::find(SmallMsg::descriptor()).get()));
+    assert(dccl::FieldCodecManager::find(NotGeneratedMsg::descriptor()) == reflection);
+    assert(dccl::FieldCodecManager::find(EmbedsMsg::descriptor()) == reflection);
+
+    const dccl::MessagePart parts[] = { dccl::HEAD, dccl::BODY };
+    for(int i = 0; i < 2; ++i)
+    {
+        unsigned max = 0, reflection_max = 0, min = 0, reflection_min = 0;
+        generated->base_max_size(&max, GeneratedMsg::descriptor(), parts[i]);
+        reflection->base_max_size(&reflection_max, GeneratedMsg::descriptor(), parts[i]);
+        generated->base_min_size(&min, GeneratedMsg::descriptor(), parts[i]);
+        reflection->base_min_size(&reflection_min, GeneratedMsg::descriptor(), parts[i]);
+        std::cout << "part " << parts[i] << ": max " << max << ", min " << min << " bits" << std::endl;
+        assert(max == reflection_max);
+        assert(min == reflection_min);
+
+        // compile-time constants generated into the class scope
+        if(parts[i] == dccl::HEAD)
+        {
+            assert(GeneratedMsg::DCCL_HEAD_MAX_BITS == GeneratedMsg::DCCL_ID_BITS + reflection_max);
+            assert(GeneratedMsg::DCCL_HEAD_MIN_BITS == GeneratedMsg::DCCL_ID_BITS + reflection_min);
+        }
+        else
+        {
+            assert(GeneratedMsg::DCCL_BODY_MAX_BITS == reflection_max);
+            assert(GeneratedMsg::DCCL_BODY_MIN_BITS == reflection_min);
+        }
+    }
+    assert(GeneratedMsg::DCCL_ID == codec.id<GeneratedMsg>());
+    assert(GeneratedMsg::DCCL_ID_BITS == 8);
+    assert(GeneratedMsg::DCCL_BITS_head_i == 10);
+    assert(GeneratedMsg::DCCL_BITS_head_b == 2);
+    assert(GeneratedMsg::DCCL_BITS_ri == 3 + 5*4);
+    assert(SmallMsg::DCCL_MAX_ENCODED_BYTES == SmallMsg::DCCL_MIN_ENCODED_BYTES);
+
+    {
+        GeneratedMsg worst;
+        dccl::MessageGenerator worst_generator;
+        worst_generator.set_worst_case(true);
+        worst_generator.generate(&worst);
+        std::string bytes;
+        codec.encode(&bytes, worst);
+        assert(bytes.size() == GeneratedMsg::DCCL_MAX_ENCODED_BYTES);
+    }
+
+    dccl::MessageGenerator generator;
+    generator.set_optional_probability(0.5);
+    for(int i = 0; i < 500; ++i)
+    {
+        GeneratedMsg msg;
+        generator.generate(&msg);
+        check_same(codec, msg);
+        check_same(codec, msg, true);
+
+        NotGeneratedMsg not_generated;
+        generator.generate(&not_generated);
+        check_same(codec, not_generated);
+
+        EmbedsMsg embeds;
+        generator.generate(&embeds);
+        check_same(codec, embeds);
+
+        check_struct(codec, msg, &check_generated_fields);
+        check_struct(codec, not_generated, &check_not_generated_fields);
+        StructMsg struct_msg;
+        generator.generate(&struct_msg);
+        check_struct(codec, struct_msg, &check_struct_fields);
+    }
+
+    // a struct filled in directly
+    {
+        StructMsg_DCCLStruct s = StructMsg_DCCLStruct();
+        s.has_head_i = true;
+        s.head_i = -5;
+        s.head_b[0] = 'x';
+        s.head_b_size = 1;
+        std::memcpy(s.rs, "abc", 3);
+        s.rs_size = 3;
+        s.has_s = true;
+        std::memcpy(s.s, "hello", 5);
+        s.s_size = 5;
+        s.levels[0] = GeneratedMsg::LEVEL_HIGH;
+        s.levels[1] = GeneratedMsg::LEVEL_LOW;
+        s.levels_size = 2;
+
+        char buffer[StructMsg_DCCLStruct::DCCL_MAX_ENCODED_BYTES];
+        std::size_t size = s.encode(buffer, sizeof(buffer));
+
+        StructMsg msg;
+        msg.set_head_i(-5);
+        msg.set_head_b("x");
+        msg.set_rs("abc");
+        msg.set_s("hello");
+        msg.add_levels(GeneratedMsg::LEVEL_HIGH);
+        msg.add_levels(GeneratedMsg::LEVEL_LOW);
+        std::string bytes;
+        codec.encode(&bytes, msg);
+        assert(std::string(buffer, size) == bytes);
+        // the two byte identifier
+        assert(static_cast<unsigned>(codec.id(bytes)) == StructMsg_DCCLStruct::DCCL_ID);
+
+        StructMsg decoded;
+        codec.decode(bytes, &decoded);
+        assert(decoded.head_b() == std::string("x\0", 2));
+        assert(!decoded.has_ob());
+
+        try
+        {
+            s.encode(buffer, size - 1);
+            assert(false);
+        }
+        catch(std::length_error& e)
+        {
+            std::cout << "expected: " << e.what() << std::endl;
+        }
+
+        s.levels_size = 4;
+        try
+        {
+            s.encode(buffer, sizeof(buffer));
+            assert(false);
+        }
+        catch(std::length_error& e)
+        {
+            std::cout << "expected: " << e.what() << std::endl;
+        }
+
+        SmallMsg small;
+        small.set_i(1);
+        std::string small_bytes;
+        codec.encode(&small_bytes, small);
+        try
+        {
+            s.decode(small_bytes.data(), small_bytes.size());
+            assert(false);
+        }
+        catch(dccl::Exception& e)
+        {
+            std::cout << "expected: " << e.what() << std::endl;
+        }
+    }
+
+    // empty and out of range values
+    {
+        GeneratedMsg msg;
+        check_same(codec, msg, true);
+
+        msg.set_head_i(1001);
+        msg.set_d(-10.0004);
+        msg.set_od(2.26);
+        msg.set_f(0.994);
+        msg.set_i32(-1005);
+        msg.set_u32(99);
+        msg.set_b(true);
+        msg.set_level(GeneratedMsg::LEVEL_HIGH);
+        msg.add_rd(100.04);
+        msg.add_rd(100.06);
+        check_same(codec, msg);
+
+        codec.set_strict(true);
+        try
+        {
+            std::string bytes;
+            codec.encode(&bytes, msg);
+            assert(false);
+        }
+        catch(dccl::OutOfRangeException& e)
+        {
+            std::cout << "expected: " << e.what() << std::endl;
+            assert(e.field() == GeneratedMsg::descriptor()->FindFieldByName("head_i"));
+        }
+        codec.set_strict(false);
+
+        for(int j = 0; j < 6; ++j)
+            msg.add_ri(j);
+        try
+        {
+            std::string bytes;
+            codec.encode(&bytes, msg);
+            assert(false);
+        }
+        catch(dccl::OutOfRangeException& e)
+        {
+            std::cout << "expected: " << e.what() << std::endl;
+        }
+    }
+
+    std::cout << "all tests passed" << std::endl;
+}
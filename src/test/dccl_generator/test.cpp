@@ -0,0 +1,131 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests the random message generator
+
+#include "dccl/codec.h"
+#include "dccl/codecs2/field_codec_default.h"
+#include "dccl/message_generator.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+// encodes strictly (out of range values throw), decodes and checks the decoded message encodes the same
+void check_round_trip(dccl::Codec& codec, const google::protobuf::Message& msg)
+{
+    std::string bytes;
+    codec.encode(&bytes, msg);
+    
+    boost::shared_ptr<google::protobuf::Message> decoded(msg.New());
+    codec.decode(bytes, decoded.get());
+
+    std::string bytes2;
+    codec.encode(&bytes2, *decoded);
+    assert(bytes == bytes2);
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+
+    dccl::FieldCodecManager::add<dccl::v2::StaticCodec<bool> >("_static");
+
+    dccl::Codec codec;
+    codec.set_strict(true);
+    codec.load<GeneratorMsg>();
+    codec.load<GeneratorV2Msg>();
+
+    // the same seed generates the same messages
+    {
+        dccl::MessageGenerator a(42), b(42), c(43);
+        bool all_same_as_c = true;
+        for(int i = 0; i < 10; ++i)
+        {
+            GeneratorMsg msg_a, msg_b, msg_c;
+            a.generate(&msg_a);
+            b.generate(&msg_b);
+            c.generate(&msg_c);
+            assert(msg_a.SerializeAsString() == msg_b.SerializeAsString());
+            if(msg_a.SerializeAsString() != msg_c.SerializeAsString())
+                all_same_as_c = false;
+        }
+        assert(!all_same_as_c);
+    }
+
+    // every generated message is within bounds
+    {
+        dccl::MessageGenerator generator;
+        const int num_msgs = 1000;
+        int num_u32 = 0;
+        for(int i = 0; i < num_msgs; ++i)
+        {
+            GeneratorMsg msg;
+            generator.generate(&msg);
+            check_round_trip(codec, msg);
+
+            assert(!msg.has_omitted());
+            assert(!msg.has_const_int() || msg.const_int() == 3);
+            assert(!msg.has_const_bool() || msg.const_bool());
+            assert(msg.d() >= -10 && msg.d() <= 10);
+            assert(msg.i32() % 10 == 0);
+            assert(msg.s().size() <= 10);
+            assert(msg.ri_size() <= 5);
+            assert(msg.rinner_size() <= 3);
+            if(msg.has_u32())
+            {
+                assert(msg.u32() >= 100 && msg.u32() <= 200);
+                ++num_u32;
+            }
+
+            boost::shared_ptr<google::protobuf::Message> v2_msg = generator.generate(GeneratorV2Msg::descriptor());
+            check_round_trip(codec, *v2_msg);
+        }
+        
+        // default optional field probability is 0.9
+        std::cout << "u32 set in " << num_u32 << " of " << num_msgs << " messages" << std::endl;
+        assert(num_u32 > 0.8 * num_msgs && num_u32 < 0.98 * num_msgs);
+    }
+
+    // no optional fields
+    {
+        dccl::MessageGenerator generator;
+        generator.set_optional_probability(0);
+        GeneratorMsg msg;
+        generator.generate(&msg);
+        check_round_trip(codec, msg);
+        assert(!msg.has_f() && !msg.has_u32() && !msg.has_s() && !msg.has_inner());
+    }
+    
+    // worst case is the maximum size
+    {
+        dccl::MessageGenerator generator;
+        generator.set_worst_case(true);
+        GeneratorMsg msg;
+        generator.generate(&msg);
+        check_round_trip(codec, msg);
+        assert(msg.has_u32() && msg.has_inner() && msg.inner().s().size() == 8);
+        assert(msg.s().size() == 10 && msg.var_by().size() == 12);
+        assert(msg.ri_size() == 5 && msg.rinner_size() == 3);
+        // max_size() allows for a two byte id, where this message's id takes one
+        assert(codec.size(msg) + 1 == codec.max_size<GeneratorMsg>());
+    }
+    
+    std::cout << "all tests passed" << std::endl;
+}
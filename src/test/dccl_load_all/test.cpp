@@ -0,0 +1,85 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests loading (and validating) many messages at once
+
+#include "dccl/codec.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    std::vector<const google::protobuf::Descriptor*> valid;
+    valid.push_back(TestMsgA::descriptor());
+    valid.push_back(TestMsgB::descriptor());
+    valid.push_back(TestMsgC::descriptor());
+
+    // same result as load() for each, for any number of threads
+    for(unsigned num_threads = 0; num_threads < 5; ++num_threads)
+    {
+        dccl::Codec codec;
+        codec.load_all(valid, num_threads);
+        assert(codec.loaded().size() == 3);
+        assert(codec.loaded().find(2)->second == TestMsgA::descriptor());
+        assert(codec.loaded().find(3)->second == TestMsgB::descriptor());
+        assert(codec.loaded().find(4)->second == TestMsgC::descriptor());
+
+        TestMsgA msg_in, msg_out;
+        msg_in.set_a(10);
+        Embedded* pos = msg_in.add_pos();
+        pos->set_x(-5);
+        pos->set_y(500);
+        std::string bytes;
+        codec.encode(&bytes, msg_in);
+        codec.decode(bytes, &msg_out);
+        assert(msg_in.SerializeAsString() == msg_out.SerializeAsString());
+    }
+
+    // valid messages are loaded, and all the errors reported together
+    std::vector<const google::protobuf::Descriptor*> mixed(valid);
+    mixed.push_back(TooBig::descriptor());
+    mixed.push_back(SameId::descriptor());
+    mixed.push_back(NoBounds::descriptor());
+    {
+        dccl::Codec codec;
+        try
+        {
+            codec.load_all(mixed, 2);
+            assert(false);
+        }
+        catch(dccl::Exception& e)
+        {
+            std::string what = e.what();
+            std::cout << "expected exception: " << what << std::endl;
+            assert(what.find("3 of 6") != std::string::npos);
+            assert(what.find("dccl.test.TooBig") != std::string::npos);
+            assert(what.find("dccl.test.SameId") != std::string::npos);
+            assert(what.find("dccl.test.NoBounds") != std::string::npos);
+            assert(what.find("dccl.test.TestMsgA:") == std::string::npos);
+        }
+        assert(codec.loaded().size() == 3);
+        assert(codec.loaded().find(2)->second == TestMsgA::descriptor());
+    }
+    
+    std::cout << "all tests passed" << std::endl;
+}
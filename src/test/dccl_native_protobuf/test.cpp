@@ -53,6 +53,11 @@ void fill_message(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_optional(true);
     
     msg_in.set_enum_default_optional(ENUM_C);
+    msg_in.set_string_default_optional("abc");
+    msg_in.set_bytes_default_optional(std::string("\x00\x01\xff", 3));
+    msg_in.mutable_msg_default_optional()->set_val(++i + 0.3);
+    msg_in.mutable_msg_default_optional()->set_s("embedded");
+    msg_in.mutable_msg_default_optional()->add_sint32_repeat(-++i);
 
     msg_in.set_double_default_required(++i + 0.1);
     msg_in.set_float_default_required(++i + 0.2);
@@ -71,13 +76,25 @@ void fill_message(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_required(true);
 
     msg_in.set_enum_default_required(ENUM_C);
+    msg_in.set_string_default_required("def");
+    msg_in.set_bytes_default_required(std::string("\x80\x7f", 2));
+    msg_in.mutable_msg_default_required()->set_val(++i + 0.3);
+    msg_in.mutable_msg_default_required()->add_sint32_repeat(++i);
+    msg_in.mutable_msg_default_required()->add_sint32_repeat(-++i);
     
     
     for(int j = 0; j < 4; ++j)
     {
         msg_in.add_double_default_repeat(++i + 0.1);
         msg_in.add_int32_default_repeat(++i);
+        msg_in.add_sint64_default_repeat(-++i);
+        msg_in.add_fixed32_default_repeat(++i);
+        msg_in.add_bool_default_repeat(j % 2);
+        msg_in.add_enum_default_repeat(ENUM_B);
+        msg_in.add_string_default_repeat("s" + std::string(j, 'x'));
     }
+    for(int j = 0; j < 2; ++j)
+        msg_in.add_msg_default_repeat()->set_val(++i + 0.4);
 }
 
 void fill_message_partial(NativeProtobufTest& msg_in)
@@ -112,12 +129,16 @@ void fill_message_partial(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_required(true);
 
     msg_in.set_enum_default_required(ENUM_C);
+    msg_in.set_string_default_required("");
+    msg_in.set_bytes_default_required("x");
+    msg_in.mutable_msg_default_required();
     
     
     for(int j = 0; j < 2; ++j)
     {
         msg_in.add_double_default_repeat(++i + 0.1);
         msg_in.add_int32_default_repeat(++i);
+        msg_in.add_sint64_default_repeat(-++i);
     }
 }
 
@@ -141,6 +162,10 @@ void fill_message_max(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_optional(true);
 
     msg_in.set_enum_default_optional(ENUM_C);
+    msg_in.set_string_default_optional(std::string(10, 'z'));
+    msg_in.set_bytes_default_optional(std::string(10, '\xff'));
+    msg_in.mutable_msg_default_optional()->set_val(std::numeric_limits<double>::max());
+    msg_in.mutable_msg_default_optional()->set_s(std::string(10, 'z'));
 
     msg_in.set_double_default_required(std::numeric_limits<double>::max());
     msg_in.set_float_default_required(std::numeric_limits<float>::max());
@@ -158,13 +183,25 @@ void fill_message_max(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_required(true);
 
     msg_in.set_enum_default_required(ENUM_C);
+    msg_in.set_string_default_required(std::string(10, 'z'));
+    msg_in.set_bytes_default_required(std::string(10, '\xff'));
+    msg_in.mutable_msg_default_required()->set_val(std::numeric_limits<double>::max());
+    for(int j = 0; j < 3; ++j)
+        msg_in.mutable_msg_default_required()->add_sint32_repeat(std::numeric_limits<dccl::int32>::min());
     
     
     for(int j = 0; j < 4; ++j)
     {
         msg_in.add_double_default_repeat(std::numeric_limits<double>::max());
         msg_in.add_int32_default_repeat(std::numeric_limits<dccl::int32>::max());
+        msg_in.add_sint64_default_repeat(std::numeric_limits<dccl::int64>::min());
+        msg_in.add_fixed32_default_repeat(std::numeric_limits<dccl::uint32>::max());
+        msg_in.add_bool_default_repeat(true);
+        msg_in.add_enum_default_repeat(ENUM_C);
+        msg_in.add_string_default_repeat(std::string(10, 'z'));
     }
+    for(int j = 0; j < 2; ++j)
+        msg_in.add_msg_default_repeat()->set_s(std::string(10, 'z'));
 }
 
 
@@ -187,6 +224,8 @@ void fill_message_min(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_optional(true);
 
     msg_in.set_enum_default_optional(ENUM_A);
+    msg_in.set_string_default_optional("");
+    msg_in.set_bytes_default_optional("");
 
     msg_in.set_double_default_required(std::numeric_limits<double>::min());
     msg_in.set_float_default_required(std::numeric_limits<float>::min());
@@ -204,12 +243,20 @@ void fill_message_min(NativeProtobufTest& msg_in)
     msg_in.set_bool_default_required(true);
 
     msg_in.set_enum_default_required(ENUM_A);
+    msg_in.set_string_default_required("");
+    msg_in.set_bytes_default_required("");
+    msg_in.mutable_msg_default_required()->set_val(std::numeric_limits<double>::min());
     
     
     for(int j = 0; j < 4; ++j)
     {
         msg_in.add_double_default_repeat(std::numeric_limits<double>::min());
         msg_in.add_int32_default_repeat(std::numeric_limits<dccl::int32>::min());
+        msg_in.add_sint64_default_repeat(std::numeric_limits<dccl::int64>::min());
+        msg_in.add_fixed32_default_repeat(std::numeric_limits<dccl::uint32>::min());
+        msg_in.add_bool_default_repeat(false);
+        msg_in.add_enum_default_repeat(ENUM_A);
+        msg_in.add_string_default_repeat("");
     }
 }
 
@@ -263,7 +310,92 @@ int main(int argc, char* argv[])
         run_test(codec, msg_in);
     }
     
+    // corrupt lengths of packed repeated fields are rejected before reading the values
+    codec.load<NativeProtobufRepeatedTest>();
+    {
+        NativeProtobufRepeatedTest msg_in;
+        msg_in.add_values(1);
+        msg_in.add_values(2);
+        std::string bytes;
+        codec.encode(&bytes, msg_in);
+        // id, length (bytes), values
+        assert(bytes == std::string("\x04\x02\x01\x02", 4));
+
+        NativeProtobufRepeatedTest msg_out;
+        codec.decode(bytes, &msg_out);
+        assert(msg_out.SerializeAsString() == msg_in.SerializeAsString());
+
+        const std::string bad_lengths[] = {
+            // more than max_repeat times the largest value (4 * 10 bytes)
+            std::string("\x29"),
+            // 0x20000002 bytes, which would wrap to 2 bytes when converted to bits
+            std::string("\x82\x80\x80\x80\x02"),
+            // largest 64-bit varint
+            std::string("\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01")
+        };
+        for(int i = 0, n = sizeof(bad_lengths) / sizeof(bad_lengths[0]); i < n; ++i)
+        {
+            std::string bad_bytes = bytes.substr(0, 1) + bad_lengths[i] + bytes.substr(2);
+            bool threw = false;
+            try
+            {
+                codec.decode(bad_bytes, &msg_out);
+            }
+            catch(dccl::Exception& e)
+            {
+                threw = true;
+            }
+            assert(threw);
+        }
+    }
     
+    // repeated fields not declared [packed=true] keep the DCCL repeated encoding
+    codec.load<NativeProtobufUnpackedTest>();
+    {
+        NativeProtobufUnpackedTest msg_in;
+        msg_in.add_values(1);
+        msg_in.add_values(2);
+        std::string bytes;
+        codec.encode(&bytes, msg_in);
+        // id, then (least significant bit first) 3 bits of size, and each value as a varint
+        assert(bytes == std::string("\x06\x0a\x10\x00", 4));
+
+        NativeProtobufUnpackedTest msg_out;
+        codec.decode(bytes, &msg_out);
+        assert(msg_out.SerializeAsString() == msg_in.SerializeAsString());
+    }
+    
+    // corrupt string lengths are rejected, including those that only fit max_length when truncated to 32 bits
+    codec.load<NativeProtobufStringTest>();
+    {
+        NativeProtobufStringTest msg_in;
+        msg_in.set_s("ab");
+        std::string bytes;
+        codec.encode(&bytes, msg_in);
+        // id, length, characters
+        assert(bytes == std::string("\x08\x02" "ab", 4));
+
+        const std::string bad_lengths[] = {
+            std::string("\x0b"),
+            // 2^32 + 1
+            std::string("\x81\x80\x80\x80\x10")
+        };
+        for(int i = 0, n = sizeof(bad_lengths) / sizeof(bad_lengths[0]); i < n; ++i)
+        {
+            std::string bad_bytes = bytes.substr(0, 1) + bad_lengths[i] + bytes.substr(2);
+            NativeProtobufStringTest msg_out;
+            bool threw = false;
+            try
+            {
+                codec.decode(bad_bytes, &msg_out);
+            }
+            catch(dccl::Exception& e)
+            {
+                threw = true;
+            }
+            assert(threw);
+        }
+    }
     
     std::cout << "all tests passed" << std::endl;
 }
@@ -0,0 +1,105 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests per field profiling of encode, decode and size
+
+#include "dccl/codec.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+
+    dccl::Codec codec;
+    codec.load<ProfileMsg>();
+
+    ProfileMsg msg;
+    msg.set_h(5);
+    msg.set_a(100);
+    msg.mutable_pos()->set_x(10);
+    msg.mutable_pos()->set_y(1000);
+
+    ProfileMsg decoded;
+    std::string bytes;
+    
+    // off by default
+    codec.encode(&bytes, msg);
+    codec.decode(bytes, &decoded);
+    assert(codec.profile().empty());
+
+    codec.set_profiling(true);
+    const int num_msgs = 10;
+    for(int i = 0; i < num_msgs; ++i)
+    {
+        bytes.clear();
+        codec.encode(&bytes, msg);
+        codec.size(msg);
+        codec.decode(bytes, &decoded);
+        assert(decoded.SerializeAsString() == msg.SerializeAsString());
+    }
+    codec.set_profiling(false);
+    codec.write_profile(&std::cout);
+
+    assert(codec.profile().size() == 1);
+    const std::map<std::string, dccl::FieldProfile>& profile = codec.profile().find("dccl.test.ProfileMsg")->second;
+
+    // head, body, h, a, pos, pos.x, pos.y
+    assert(profile.size() == 7);
+    
+    const dccl::FieldProfile& a = profile.find("a")->second;
+    assert(a.encode.count == num_msgs);
+    assert(a.decode.count == num_msgs);
+    assert(a.size.count == num_msgs);
+    assert(a.encode.bits == 8*num_msgs);
+    assert(a.decode.bits == 8*num_msgs);
+    assert(a.size.bits == 8*num_msgs);
+    assert(a.encode.average_bits() == 8);
+
+    const dccl::FieldProfile& h = profile.find("h")->second;
+    assert(h.encode.average_bits() == 4);
+
+    const dccl::FieldProfile& x = profile.find("pos.x")->second;
+    const dccl::FieldProfile& y = profile.find("pos.y")->second;
+    assert(x.encode.count == num_msgs && y.decode.count == num_msgs);
+    assert(x.encode.average_bits() == 10 && y.decode.average_bits() == 10);
+
+    // embedded message includes its fields
+    const dccl::FieldProfile& pos = profile.find("pos")->second;
+    assert(pos.encode.bits >= x.encode.bits + y.encode.bits);
+    assert(pos.encode.nanoseconds >= x.encode.nanoseconds + y.encode.nanoseconds);
+    assert(pos.decode.bits == pos.encode.bits);
+
+    // whole head and body
+    const dccl::FieldProfile& head = profile.find("(head)")->second;
+    const dccl::FieldProfile& body = profile.find("(body)")->second;
+    assert(head.encode.count == num_msgs && body.decode.count == num_msgs);
+    assert(head.encode.bits >= h.encode.bits);
+    assert(body.encode.bits >= a.encode.bits + pos.encode.bits);
+    assert(body.size.bits == body.encode.bits);
+    assert(body.decode.bits == body.encode.bits);
+    assert(head.decode.bits == head.encode.bits);
+    
+    codec.reset_profile();
+    assert(codec.profile().empty());
+    
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,138 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests caching parsed .proto files with DynamicProtobufManager::enable_proto_cache()
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <utime.h>
+#include <dirent.h>
+
+#include "dccl/dynamic_protobuf_manager.h"
+#include "dccl/logger.h"
+
+int loaded_from_cache = 0;
+void check_cache_use(const std::string& log_message,
+                     dccl::logger::Verbosity verbosity,
+                     dccl::logger::Group group)
+{
+    if(log_message.find("from proto cache") != std::string::npos)
+        ++loaded_from_cache;
+}
+
+void write_proto(const std::string& path, const std::string& field_name)
+{
+    std::ofstream proto(path.c_str());
+    proto << "syntax = \"proto2\";\n"
+          << "message CacheTest { required int32 " << field_name << " = 1; }\n";
+}
+
+// loads path with a fresh DynamicProtobufManager, returning true if it came from the cache
+bool load(const std::string& cache_dir, const std::string& path, const std::string& expected_field)
+{
+    dccl::DynamicProtobufManager::reset();
+    dccl::DynamicProtobufManager::enable_compilation();
+    dccl::DynamicProtobufManager::enable_proto_cache(cache_dir);
+
+    int loaded_before = loaded_from_cache;
+    const google::protobuf::FileDescriptor* file_desc =
+        dccl::DynamicProtobufManager::load_from_proto_file(path);
+    assert(file_desc);
+    assert(file_desc->FindMessageTypeByName("CacheTest"));
+    assert(file_desc->FindMessageTypeByName("CacheTest")->FindFieldByName(expected_field));
+    return loaded_from_cache > loaded_before;
+}
+
+// names of the files in dir
+std::vector<std::string> list_dir(const std::string& dir)
+{
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    assert(d);
+    while(dirent* entry = readdir(d))
+    {
+        std::string name = entry->d_name;
+        if(name != "." && name != "..")
+            names.push_back(name);
+    }
+    closedir(d);
+    return names;
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::DEBUG1_PLUS, &check_cache_use);
+
+    char dir_template[] = "/tmp/dccl_test_proto_cache_XXXXXX";
+    if(!mkdtemp(dir_template))
+    {
+        std::cerr << "failed to create temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string dir = dir_template;
+    const std::string cache_dir = dir + "/cache";
+    int result = mkdir(cache_dir.c_str(), 0700);
+    assert(result == 0);
+    const std::string proto_path = dir + "/cache_test.proto";
+    
+    write_proto(proto_path, "abc");
+
+    // first load parses the file and writes the cache (and nothing else) to cache_dir
+    bool from_cache = load(cache_dir, proto_path, "abc");
+    assert(!from_cache);
+    std::vector<std::string> cache_files = list_dir(cache_dir);
+    assert(cache_files.size() == 1);
+    assert(cache_files[0].substr(cache_files[0].size() - 3) == ".pb");
+    
+    // cache use is detected from the DEBUG1 log, so can only be checked if that is compiled in
+    const bool debug1_compiled = dccl::logger::DEBUG1 & dccl::logger::COMPILED_VERBOSITIES;
+
+    // second load uses it
+    from_cache = load(cache_dir, proto_path, "abc");
+    assert(from_cache || !debug1_compiled);
+    
+    // changing the contents invalidates the cache, even if the size and modification time are unchanged
+    struct stat st;
+    result = stat(proto_path.c_str(), &st);
+    assert(result == 0);
+    write_proto(proto_path, "xyz");
+    utimbuf times;
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime;
+    result = utime(proto_path.c_str(), &times);
+    assert(result == 0);
+
+    from_cache = load(cache_dir, proto_path, "xyz");
+    assert(!from_cache);
+    // and the rewritten cache is used next time
+    from_cache = load(cache_dir, proto_path, "xyz");
+    assert(from_cache || !debug1_compiled);
+    
+    std::remove((cache_dir + "/" + cache_files[0]).c_str());
+    std::remove(cache_dir.c_str());
+    std::remove(proto_path.c_str());
+    std::remove(dir.c_str());
+    
+    std::cout << "all tests passed" << std::endl;
+}
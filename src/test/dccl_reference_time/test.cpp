@@ -0,0 +1,96 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests decoding partial time fields (dccl.time2) relative to a reference time other than the system clock
+
+#include <sys/time.h>
+
+#include "dccl/codec.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+const double SECONDS_IN_DAY = 86400;
+
+int num_calls = 0;
+double simulated_time = 0;
+double simulated_clock()
+{
+    ++num_calls;
+    return simulated_time;
+}
+
+void check(dccl::Codec& codec, double time)
+{
+    TimeMsg msg;
+    msg.set_time(static_cast<dccl::uint64>(time) * 1000000);
+    msg.set_time_double(time);
+    msg.set_time_int64(static_cast<dccl::int64>(time) * 1000000);
+    
+    std::string bytes;
+    codec.encode(&bytes, msg);
+
+    TimeMsg decoded;
+    codec.decode(bytes, &decoded);
+    std::cout << "in: " << msg.ShortDebugString() << "\nout: " << decoded.ShortDebugString() << std::endl;
+    assert(decoded.SerializeAsString() == msg.SerializeAsString());
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+
+    dccl::Codec codec;
+    codec.load<TimeMsg>();
+
+    timeval t;
+    gettimeofday(&t, 0);
+    double now = t.tv_sec;
+    
+    // system clock by default
+    check(codec, now);
+
+    // replaying a log recorded 30 days ago (and 2 hours before the end of that day)
+    double recorded = (std::floor(now / SECONDS_IN_DAY) - 30)*SECONDS_IN_DAY + 22*3600;
+    codec.set_reference_time(recorded);
+    check(codec, recorded);
+    // a message from the next day (within 12 hours of the reference time)
+    check(codec, recorded + 4*3600);
+    // earlier the same day
+    check(codec, recorded - 6*3600);
+    // a message from the previous day (within 12 hours of the reference time)
+    codec.set_reference_time(recorded + 4*3600);
+    check(codec, recorded - 3600);
+
+    // simulated clock is only read once per decoded message
+    codec.set_reference_time_function(&simulated_clock);
+    simulated_time = 1000*SECONDS_IN_DAY + 1234;
+    check(codec, simulated_time - 60);
+    assert(num_calls == 1);
+    check(codec, simulated_time + 60);
+    assert(num_calls == 2);
+    
+    // back to the system clock
+    codec.set_reference_time_function(dccl::FieldCodecBase::ReferenceTimeFunction());
+    check(codec, now);
+    assert(num_calls == 2);
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,141 @@
+// Copyright 2009-2017 Toby Schneider (http://gobysoft.org/index.wt/people/toby)
+//                     GobySoft, LLC (for 2013-)
+//                     Massachusetts Institute of Technology (for 2007-2014)
+//                     Community contributors (see AUTHORS file)
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests writing and loading Codec snapshots
+
+#include <cstdio>
+#include <fstream>
+
+#include "dccl/codec.h"
+#include "dccl/codec_snapshot.pb.h"
+#include "dccl/codecs3/field_codec_default.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+int validate_count = 0;
+
+// counts validations, so we can see when the snapshot is used instead
+class CountingCodec : public dccl::v3::DefaultNumericFieldCodec<dccl::int32>
+{
+    void validate()
+    {
+        ++validate_count;
+        dccl::v3::DefaultNumericFieldCodec<dccl::int32>::validate();
+    }
+};
+
+void check_round_trip(dccl::Codec& encoder, dccl::Codec& decoder)
+{
+    TestMsgA msg_in;
+    msg_in.set_a(-42);
+    msg_in.mutable_embedded()->set_mode(Embedded::SURVEY);
+    msg_in.mutable_embedded()->add_depth(12.3);
+
+    std::string bytes;
+    encoder.encode(&bytes, msg_in);
+    TestMsgA msg_out;
+    decoder.decode(bytes, &msg_out);
+    assert(msg_in.SerializeAsString() == msg_out.SerializeAsString());
+}
+
+int main(int argc, char* argv[])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+    dccl::FieldCodecManager::add<CountingCodec>("counting_codec");
+
+    const std::string snapshot_path = "dccl_test_snapshot.pb";
+    
+    dccl::Codec codec;
+    codec.load<TestMsgA>();
+    codec.load(TestMsgB::descriptor(), 3);
+    assert(validate_count > 0);
+    codec.write_snapshot(snapshot_path);
+
+    // unchanged messages are loaded without validation
+    {
+        validate_count = 0;
+        dccl::Codec codec2;
+        assert(codec2.load_snapshot(snapshot_path));
+        assert(validate_count == 0);
+        assert(codec2.loaded() == codec.loaded());
+        check_round_trip(codec, codec2);
+    }
+
+    dccl::CodecSnapshot snapshot;
+    {
+        std::ifstream fin(snapshot_path.c_str(), std::ios::binary);
+        assert(snapshot.ParseFromIstream(&fin));
+    }
+    assert(snapshot.message_size() == 2);
+    assert(snapshot.message(0).full_name() == "dccl.test.TestMsgA");
+    assert(!snapshot.message(0).user_id());
+    assert(snapshot.message(0).field(0).name() == "a");
+    assert(snapshot.message(0).field(0).codec() == "counting_codec");
+    assert(snapshot.message(0).field(2).name() == "embedded.mode");
+    assert(snapshot.message(1).dccl_id() == 3);
+    assert(snapshot.message(1).user_id());
+    assert(snapshot.message(0).head_size_bits() + snapshot.message(0).body_size_bits() > 0);
+    assert((snapshot.message(0).head_size_bits() + 7) / 8 + (snapshot.message(0).body_size_bits() + 7) / 8 <=
+           codec.max_size(codec.loaded().find(snapshot.message(0).dccl_id())->second));
+    
+    const dccl::CodecSnapshot original_snapshot = snapshot;
+    
+    // changed messages are validated
+    {
+        snapshot.mutable_message(0)->set_fingerprint(snapshot.message(0).fingerprint() + 1);
+        {
+            std::ofstream fout(snapshot_path.c_str(), std::ios::binary);
+            snapshot.SerializeToOstream(&fout);
+        }
+        validate_count = 0;
+        dccl::Codec codec2;
+        assert(codec2.load_snapshot(snapshot_path));
+        assert(validate_count > 0);
+        assert(codec2.loaded() == codec.loaded());
+        check_round_trip(codec, codec2);
+    }
+
+    // messages are also validated if their field codecs differ from the snapshot, even if the fingerprint matches
+    {
+        dccl::CodecSnapshot edited = original_snapshot;
+        edited.mutable_message(0)->mutable_field(0)->set_codec("dccl.default3");
+        {
+            std::ofstream fout(snapshot_path.c_str(), std::ios::binary);
+            edited.SerializeToOstream(&fout);
+        }
+        validate_count = 0;
+        dccl::Codec codec2;
+        assert(codec2.load_snapshot(snapshot_path));
+        assert(validate_count > 0);
+        assert(codec2.loaded() == codec.loaded());
+        check_round_trip(codec, codec2);
+    }
+
+    // snapshot is ignored if it can't be read
+    {
+        dccl::Codec codec2;
+        assert(!codec2.load_snapshot("no_such_dccl_test_snapshot.pb"));
+        assert(codec2.loaded().empty());
+    }
+
+    std::remove(snapshot_path.c_str());
+    std::cout << "all tests passed" << std::endl;
+}
@@ -19,6 +19,11 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+
 #include "dccl/logger.h"
 
 /// asserts false if called - used for testing proper short-circuiting of logger calls
@@ -37,6 +42,48 @@ void info(const std::string& log_message,
    printf("%s\n", log_message.c_str());
 }
 
+boost::atomic<int> count(0);
+void counter(const std::string& log_message,
+             dccl::logger::Verbosity verbosity,
+             dccl::logger::Group group)
+{
+    ++count;
+}
+
+const int THREAD_MESSAGES = 1000;
+void* log_from_thread(void*)
+{
+    using dccl::dlog;
+    for(int i = 0; i < THREAD_MESSAGES; ++i)
+        dlog.is(dccl::logger::DEBUG1, dccl::logger::ENCODE) && dlog << "message " << i << std::endl;
+    return 0;
+}
+
+bool hex_formatting_leaked = false;
+void check_decimal(const std::string& log_message,
+                   dccl::logger::Verbosity verbosity,
+                   dccl::logger::Group group)
+{
+    if(log_message == "decimal a")
+        hex_formatting_leaked = true;
+}
+
+void* log_decimal_from_thread(void*)
+{
+    using dccl::dlog;
+    for(int i = 0; i < THREAD_MESSAGES; ++i)
+        dlog.is(dccl::logger::DEBUG1) && dlog << "decimal " << 10 << std::endl;
+    return 0;
+}
+
+std::vector<std::string> lines;
+void collect(const std::string& log_message,
+             dccl::logger::Verbosity verbosity,
+             dccl::logger::Group group)
+{
+    lines.push_back(log_message);
+}
+
 int main(int argc, char* argv[])
 {
     using dccl::dlog;
@@ -94,6 +141,75 @@ int main(int argc, char* argv[])
     dlog.is(WARN) && dlog << "warn ok" << std::endl;
     dlog.disconnect(ALL);    
 
+
+    std::cout << "restricting ENCODE group to WARN+" << std::endl;
+    dlog.connect(ALL, &info);
+    dlog.set_group_verbosity(ENCODE, WARN_PLUS);
+    dlog.is(DEBUG1, ENCODE) && dlog << stream_assert << std::endl;
+    dlog.is(INFO, ENCODE) && dlog << stream_assert << std::endl;
+    dlog.is(WARN, ENCODE) && dlog << "encode warn ok" << std::endl;
+    dlog.is(DEBUG1, DECODE) && dlog << "decode debug1 ok" << std::endl;
+    dlog.set_group_verbosity(ENCODE, ALL);
+    dlog.disconnect(ALL);    
+
+    std::cout << "asynchronous logging from multiple threads" << std::endl;
+    dlog.connect(ALL, &counter);
+    dlog.set_async(true, 4 * THREAD_MESSAGES);
+    const int num_threads = 4;
+    pthread_t threads[num_threads];
+    for(int i = 0; i < num_threads; ++i)
+        pthread_create(&threads[i], 0, &log_from_thread, 0);
+    for(int i = 0; i < num_threads; ++i)
+        pthread_join(threads[i], 0);
+    // writes out anything still queued
+    dlog.set_async(false);
+    std::cout << "wrote " << count << " messages, dropped " << dlog.dropped() << std::endl;
+    assert(count + dlog.dropped() == num_threads * THREAD_MESSAGES);
+    assert(count > 0);
+    dlog.disconnect(ALL);    
+
+    std::cout << "switching asynchronous mode while threads are logging" << std::endl;
+    count = 0;
+    unsigned long dropped_before = dlog.dropped();
+    dlog.connect(ALL, &counter);
+    for(int i = 0; i < num_threads; ++i)
+        pthread_create(&threads[i], 0, &log_from_thread, 0);
+    for(int i = 0; i < 20; ++i)
+        dlog.set_async(i % 2 == 0, THREAD_MESSAGES / 10);
+    for(int i = 0; i < num_threads; ++i)
+        pthread_join(threads[i], 0);
+    dlog.set_async(false);
+    std::cout << "wrote " << count << " messages, dropped " << dlog.dropped() - dropped_before << std::endl;
+    assert(count + dlog.dropped() - dropped_before == num_threads * THREAD_MESSAGES);
+    dlog.disconnect(ALL);    
+    
+    std::cout << "formatting state is kept per thread" << std::endl;
+    dlog.connect(ALL, &check_decimal);
+    dlog.is(DEBUG1) && dlog << std::hex << "hex " << 10 << std::endl;
+    pthread_t decimal_thread;
+    pthread_create(&decimal_thread, 0, &log_decimal_from_thread, 0);
+    pthread_join(decimal_thread, 0);
+    dlog << std::dec;
+    assert(!hex_formatting_leaked);
+    dlog.disconnect(ALL);    
+    
+    std::cout << "long, multi-line and partial messages" << std::endl;
+    dlog.connect(ALL, &collect);
+    const std::string long_line(5000, 'x');
+    dlog.is(INFO) && dlog << long_line << std::endl;
+    dlog.is(INFO) && dlog << "first\nsecond" << std::endl;
+    dlog.is(INFO) && dlog << "part" << std::flush;
+    dlog.is(INFO) && dlog << "ial" << std::endl;
+    // through the Logger's own stream buffer rather than Logger::operator<<
+    std::ostream& os = dlog;
+    dlog.is(INFO) && os << "ostream " << 42 << std::endl;
+    assert(lines.size() == 5);
+    assert(lines[0] == long_line);
+    assert(lines[1] == "first");
+    assert(lines[2] == "second");
+    assert(lines[3] == "partial");
+    assert(lines[4] == "ostream 42");
+    dlog.disconnect(ALL);
     
     std::cout << "All tests passed." << std::endl;
 